@@ -0,0 +1,186 @@
+#include "binary_log.h"
+
+#include "data/vector.h"
+
+#include <cstring>
+
+namespace pdp {
+
+size_t EncodeBinaryRecord(uint32_t site, uint64_t time_ns, const PackedValue *args,
+                          uint64_t type_bits, char *out) {
+  size_t num_args = 0;
+  for (uint64_t bits = type_bits; bits > 0; bits >>= 4) {
+    ++num_args;
+  }
+  // What is left for the characters once every argument has its 8 bytes.
+  size_t string_budget = max_binary_record_size - sizeof(BinaryLogRecord) - num_args * 8;
+
+  char *it = out + sizeof(BinaryLogRecord);
+  for (uint64_t bits = type_bits; bits > 0; bits >>= 4) {
+    if ((bits & 0xF) == kStr) {
+      uint64_t length = args[1]._uint64;
+      length = length < string_budget ? length : string_budget;
+      string_budget -= length;
+      memcpy(it, &length, sizeof(length));
+      memcpy(it + sizeof(length), args[0]._str, length);
+      it += sizeof(length) + length;
+      args += 2;
+    } else {
+      memcpy(it, args, sizeof(PackedValue));
+      it += sizeof(PackedValue);
+      args += 1;
+    }
+  }
+
+  BinaryLogRecord record;
+  record.site = site;
+  record.size = it - out - sizeof(BinaryLogRecord);
+  record.time_ns = time_ns;
+  record.type_bits = type_bits;
+  memcpy(out, &record, sizeof(record));
+  return it - out;
+}
+
+size_t EncodeBinarySite(uint32_t id, const LogSite &site, char *out) {
+  const StringSlice filename(site.filename);
+  BinaryLogSite definition;
+  definition.id = id;
+  definition.line = site.line;
+  definition.level = static_cast<uint32_t>(site.level);
+  definition.filename_length = filename.Size();
+  definition.fmt_length = site.fmt.Size();
+
+  const size_t size = sizeof(definition) + filename.Size() + site.fmt.Size();
+  pdp_assert(sizeof(BinaryLogRecord) + size <= max_binary_record_size);
+  BinaryLogRecord record;
+  record.site = site_record;
+  record.size = size;
+  record.time_ns = 0;
+  record.type_bits = 0;
+
+  char *it = out;
+  memcpy(it, &record, sizeof(record));
+  it += sizeof(record);
+  memcpy(it, &definition, sizeof(definition));
+  it += sizeof(definition);
+  memcpy(it, filename.Begin(), filename.Size());
+  it += filename.Size();
+  memcpy(it, site.fmt.Begin(), site.fmt.Size());
+  it += site.fmt.Size();
+  return it - out;
+}
+
+namespace {
+
+struct BinaryLogReader {
+  explicit BinaryLogReader(StringSlice log) : input(log) {}
+
+  template <typename T>
+  bool Read(T &value) {
+    if (input.Size() < sizeof(T)) {
+      return false;
+    }
+    memcpy(&value, input.Begin(), sizeof(T));
+    input.DropLeft(sizeof(T));
+    return true;
+  }
+
+  bool Read(size_t length, StringSlice &slice) {
+    if (input.Size() < length) {
+      return false;
+    }
+    slice = input.GetLeft(length);
+    input.DropLeft(length);
+    return true;
+  }
+
+  bool Empty() const { return input.Empty(); }
+
+  StringSlice input;
+};
+
+struct DecodedSite {
+  StringSlice filename;
+  StringSlice fmt;
+  unsigned line;
+  Level level;
+};
+
+}  // namespace
+
+bool DecodeBinaryLog(StringSlice log, StringBuilder<> &out) {
+  // Text logged before StartBinaryLogging() is passed through.
+  const char *magic = log.MemMem(StringSlice(binary_log_magic, sizeof(binary_log_magic)));
+  if (magic) {
+    out.Append(log.GetLeft(magic));
+    log.DropLeft(magic);
+  }
+
+  BinaryLogReader reader(log);
+  BinaryLogHeader header;
+  if (!reader.Read(header) || memcmp(header.magic, binary_log_magic, sizeof(header.magic)) != 0) {
+    return false;
+  }
+
+  // Indexed by site id. Definitions dropped by the asynchronous backend leave holes.
+  Vector<DecodedSite> sites;
+  while (!reader.Empty()) {
+    BinaryLogRecord record;
+    StringSlice payload;
+    if (!reader.Read(record) || !reader.Read(record.size, payload)) {
+      return false;
+    }
+    if (record.site == site_record) {
+      BinaryLogReader site_reader(payload);
+      BinaryLogSite definition;
+      DecodedSite site;
+      if (!site_reader.Read(definition) ||
+          !site_reader.Read(definition.filename_length, site.filename) ||
+          !site_reader.Read(definition.fmt_length, site.fmt)) {
+        return false;
+      }
+      site.line = definition.line;
+      site.level = static_cast<Level>(definition.level);
+      while (sites.Size() <= definition.id) {
+        sites += DecodedSite{};
+      }
+      sites[definition.id] = site;
+      continue;
+    }
+
+    // Point the string arguments into the payload.
+    BinaryLogReader args_reader(payload);
+    PackedValue args[32];
+    size_t num_slots = 0;
+    for (uint64_t bits = record.type_bits; bits > 0; bits >>= 4) {
+      if ((bits & 0xF) == kStr) {
+        uint64_t length = 0;
+        StringSlice str;
+        if (!args_reader.Read(length) || !args_reader.Read(length, str)) {
+          return false;
+        }
+        args[num_slots]._str = str.Begin();
+        args[num_slots + 1]._uint64 = str.Size();
+        num_slots += 2;
+      } else if (!args_reader.Read(args[num_slots]._uint64)) {
+        return false;
+      } else {
+        num_slots += 1;
+      }
+    }
+
+    if (record.site == raw_text_site) {
+      out.AppendPack("{}", args, record.type_bits);
+    } else if (record.site < sites.Size() && !sites[record.site].fmt.Empty()) {
+      const DecodedSite &site = sites[record.site];
+      AppendLogHeader(site.filename, site.line, site.level, record.time_ns, out);
+      out.AppendPack(site.fmt, args, record.type_bits);
+      out.Append('\n');
+    } else {
+      out.AppendFormat("[decode_log] message of unknown site {}\n", record.site);
+    }
+  }
+  return true;
+}
+
+}  // namespace pdp
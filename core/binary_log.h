@@ -0,0 +1,63 @@
+#pragma once
+
+#include "log.h"
+
+namespace pdp {
+
+/// @brief Layout of a binary log, see StartBinaryLogging().
+///
+/// The log starts with a BinaryLogHeader, followed by records: a BinaryLogRecord and `size` bytes
+/// of payload. The payload of a message is its arguments. Every argument takes 8 bytes, except
+/// strings which take their 8 byte length followed by the characters. Records of `site_record`
+/// define a site instead, their payload is a BinaryLogSite followed by the file name and the format
+/// string. All integers are in native byte order.
+struct BinaryLogHeader {
+  char magic[8];
+};
+
+struct BinaryLogSite {
+  uint32_t id;
+  uint32_t line;
+  uint32_t level;
+  uint32_t filename_length;
+  uint32_t fmt_length;
+};
+
+struct BinaryLogRecord {
+  uint32_t site;
+  uint32_t size;
+  uint64_t time_ns;
+  uint64_t type_bits;
+};
+
+static_assert(sizeof(BinaryLogHeader) == 8);
+static_assert(sizeof(BinaryLogSite) == 20);
+static_assert(sizeof(BinaryLogRecord) == 24);
+
+constexpr char binary_log_magic[8] = {'P', 'D', 'P', 'B', 'L', 'O', 'G', '1'};
+
+/// @brief Site of records which hold already formatted text, e.g. from LogUnformatted().
+constexpr uint32_t raw_text_site = UINT32_MAX;
+/// @brief Site of records which define a site.
+constexpr uint32_t site_record = UINT32_MAX - 1;
+
+/// @brief Records are never larger than this, longer strings are truncated. Keeps a record within
+/// a single push to the asynchronous backend.
+constexpr size_t max_binary_record_size = 4000;
+
+/// @brief Encodes a record into @p out, which must hold max_binary_record_size bytes.
+/// @return The size of the record.
+size_t EncodeBinaryRecord(uint32_t site, uint64_t time_ns, const PackedValue *args,
+                          uint64_t type_bits, char *out);
+
+/// @brief Encodes the record defining @p site as @p id into @p out, which must hold
+/// max_binary_record_size bytes.
+/// @return The size of the record.
+size_t EncodeBinarySite(uint32_t id, const LogSite &site, char *out);
+
+/// @brief Renders a binary log as text, the same text which would have been logged. Text which
+/// precedes the header is copied as is.
+/// @return False if the log is malformed or truncated. Everything before that point is rendered.
+bool DecodeBinaryLog(StringSlice log, StringBuilder<> &out);
+
+}  // namespace pdp
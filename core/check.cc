@@ -24,6 +24,7 @@ static void PrintDecimal(unsigned value) {
 }
 
 void OnFatalError(const char *file, unsigned line, const char *what) {
+  FlushLogBackend();
 #ifdef PDP_DEBUG_BUILD
   LogUnformatted("Backtrace:\n");
   const unsigned max_frames = 16;
@@ -47,6 +48,7 @@ void OnFatalError(const char *file, unsigned line, const char *what) {
 }
 
 void OnFatalError(const char *what, const char *value, size_t value_length) {
+  FlushLogBackend();
   const char *pdp_error = "[*** PDP ERROR ***] ";
   LogUnformatted(pdp_error);
   LogUnformatted(what);
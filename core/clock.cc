@@ -0,0 +1,232 @@
+#include "clock.h"
+
+#include <sched.h>
+#include <atomic>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace pdp {
+
+namespace {
+
+/// @brief Ticks are converted as mono_ns + (tsc - base_tsc) * mult / 2^32.
+struct Calibration {
+  uint64_t base_tsc;
+  uint64_t mono_ns;
+  uint64_t mult;
+  int64_t realtime_offset_ns;
+};
+
+struct ClockSample {
+  uint64_t tsc;
+  uint64_t mono_ns;
+  int64_t realtime_offset_ns;
+};
+
+/// @brief How long the first calibration spins, it is refined by the later ones.
+constexpr uint64_t initial_calibration_ns = 1'000'000;
+/// @brief The recalibration period starts here and doubles up to the maximum.
+constexpr uint64_t initial_period_ns = 10'000'000;
+constexpr uint64_t invariant_period_ns = 1'000'000'000;
+constexpr uint64_t variant_period_ns = 50'000'000;
+
+/// @brief Seqlock around the calibration. Odd while it is being written, zero before the first one.
+std::atomic_uint32_t sequence = 0;
+std::atomic_uint64_t base_tsc = 0;
+std::atomic_uint64_t base_mono_ns = 0;
+std::atomic_uint64_t mult = 0;
+std::atomic_int64_t realtime_offset_ns = 0;
+/// @brief Conversions of later ticks recalibrate first.
+std::atomic_uint64_t next_recalibration = 0;
+
+/// @brief Held by the thread calibrating, protects the variables below.
+std::atomic_flag calibrating = ATOMIC_FLAG_INIT;
+/// @brief Rates are measured from here, the longer the interval the more precise.
+ClockSample anchor;
+uint64_t period_ns = initial_period_ns;
+
+uint64_t ClockGetNs(clockid_t id) {
+  struct timespec ts;
+  clock_gettime(id, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+ClockSample TakeSample() {
+  // Bracket the TSC between two clock reads, the tightest of a few brackets wins.
+  ClockSample sample;
+  uint64_t best_width = UINT64_MAX;
+  for (int i = 0; i < 4; ++i) {
+    const uint64_t before = ClockGetNs(CLOCK_MONOTONIC);
+    const uint64_t tsc = ReadTscOrdered();
+    const uint64_t after = ClockGetNs(CLOCK_MONOTONIC);
+    if (after - before < best_width) {
+      best_width = after - before;
+      sample.tsc = tsc;
+      sample.mono_ns = before + (after - before) / 2;
+    }
+  }
+  const uint64_t realtime = ClockGetNs(CLOCK_REALTIME);
+  sample.realtime_offset_ns = realtime - ClockGetNs(CLOCK_MONOTONIC);
+  return sample;
+}
+
+uint64_t RateBetween(const ClockSample &from, const ClockSample &to) {
+  if (PDP_UNLIKELY(to.tsc <= from.tsc)) {
+    return uint64_t(1) << 32;
+  }
+  return (static_cast<unsigned __int128>(to.mono_ns - from.mono_ns) << 32) / (to.tsc - from.tsc);
+}
+
+uint64_t NsToTicks(uint64_t ns, uint64_t rate) {
+  return (static_cast<unsigned __int128>(ns) << 32) / rate;
+}
+
+uint64_t Convert(const Calibration &c, uint64_t tsc) {
+  const int64_t delta = static_cast<int64_t>(tsc - c.base_tsc);
+  return c.mono_ns + static_cast<int64_t>((static_cast<__int128>(delta) * c.mult) >> 32);
+}
+
+void Publish(const Calibration &c, uint64_t next) {
+  const uint32_t seq = sequence.load(std::memory_order_relaxed);
+  sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  base_tsc.store(c.base_tsc, std::memory_order_relaxed);
+  base_mono_ns.store(c.mono_ns, std::memory_order_relaxed);
+  mult.store(c.mult, std::memory_order_relaxed);
+  realtime_offset_ns.store(c.realtime_offset_ns, std::memory_order_relaxed);
+  sequence.store(seq + 2, std::memory_order_release);
+  next_recalibration.store(next, std::memory_order_relaxed);
+}
+
+/// @brief Doubles the recalibration period, up to what the TSC allows.
+void GrowPeriod() {
+  const uint64_t max_period_ns = HasInvariantTsc() ? invariant_period_ns : variant_period_ns;
+  period_ns = 2 * period_ns < max_period_ns ? 2 * period_ns : max_period_ns;
+}
+
+void InitialCalibration() {
+  anchor = TakeSample();
+  ClockSample end;
+  do {
+    end = TakeSample();
+  } while (end.mono_ns - anchor.mono_ns < initial_calibration_ns);
+
+  Calibration c;
+  c.base_tsc = end.tsc;
+  c.mono_ns = end.mono_ns;
+  c.mult = RateBetween(anchor, end);
+  c.realtime_offset_ns = end.realtime_offset_ns;
+  Publish(c, end.tsc + NsToTicks(period_ns, c.mult));
+}
+
+void CorrectDrift() {
+  Calibration old;
+  old.base_tsc = base_tsc.load(std::memory_order_relaxed);
+  old.mono_ns = base_mono_ns.load(std::memory_order_relaxed);
+  old.mult = mult.load(std::memory_order_relaxed);
+
+  const ClockSample now = TakeSample();
+  const uint64_t rate = RateBetween(anchor, now);
+  const uint64_t converted = Convert(old, now.tsc);
+  GrowPeriod();
+  const int64_t period = period_ns;
+
+  // Continue from where the old calibration is and slew towards CLOCK_MONOTONIC, so that both agree
+  // again after a period. Large errors (e.g. after a suspend) are stepped over when behind and
+  // slewed by at most half the period when ahead.
+  Calibration c;
+  c.base_tsc = now.tsc;
+  c.mono_ns = converted;
+  c.realtime_offset_ns = now.realtime_offset_ns;
+  int64_t error = static_cast<int64_t>(now.mono_ns - converted);
+  if (error > period / 2) {
+    c.mono_ns = now.mono_ns;
+    error = 0;
+  } else if (error < -period / 2) {
+    error = -period / 2;
+  }
+  const uint64_t period_ticks = NsToTicks(period, rate);
+  c.mult = (static_cast<unsigned __int128>(period + error) << 32) / period_ticks;
+  Publish(c, now.tsc + period_ticks);
+
+  if (!HasInvariantTsc()) {
+    // The rate changes with the frequency, only the recent past is relevant.
+    anchor = now;
+  }
+}
+
+/// @brief Publishes a new calibration, unless another thread is already at it.
+void Recalibrate() {
+  if (calibrating.test_and_set(std::memory_order_acquire)) {
+    return;
+  }
+  if (sequence.load(std::memory_order_relaxed) == 0) {
+    InitialCalibration();
+  } else if (ReadTsc() >= next_recalibration.load(std::memory_order_relaxed)) {
+    CorrectDrift();
+  }
+  calibrating.clear(std::memory_order_release);
+}
+
+Calibration LoadCalibration() {
+  for (;;) {
+    const uint32_t seq = sequence.load(std::memory_order_acquire);
+    if (PDP_UNLIKELY(seq == 0)) {
+      Recalibrate();
+    }
+    if (PDP_UNLIKELY(seq == 0 || (seq & 1))) {
+      sched_yield();
+      continue;
+    }
+    Calibration c;
+    c.base_tsc = base_tsc.load(std::memory_order_relaxed);
+    c.mono_ns = base_mono_ns.load(std::memory_order_relaxed);
+    c.mult = mult.load(std::memory_order_relaxed);
+    c.realtime_offset_ns = realtime_offset_ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (PDP_LIKELY(sequence.load(std::memory_order_relaxed) == seq)) {
+      return c;
+    }
+  }
+}
+
+Calibration LoadCalibration(uint64_t tsc) {
+  if (PDP_UNLIKELY(tsc >= next_recalibration.load(std::memory_order_relaxed))) {
+    Recalibrate();
+  }
+  return LoadCalibration();
+}
+
+}  // namespace
+
+bool HasInvariantTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+  // cpuid may trap to the hypervisor, ask only once.
+  static std::atomic_int invariant = -1;
+  int value = invariant.load(std::memory_order_relaxed);
+  if (PDP_UNLIKELY(value < 0)) {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    value = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+    invariant.store(value, std::memory_order_relaxed);
+  }
+  return value;
+#else
+  return true;
+#endif
+}
+
+uint64_t TscToMonotonicNs(uint64_t tsc) { return Convert(LoadCalibration(tsc), tsc); }
+
+uint64_t TscToRealtimeNs(uint64_t tsc) {
+  const Calibration c = LoadCalibration(tsc);
+  return Convert(c, tsc) + c.realtime_offset_ns;
+}
+
+uint64_t TscTicksToNs(uint64_t ticks) {
+  return (static_cast<unsigned __int128>(ticks) * LoadCalibration().mult) >> 32;
+}
+
+}  // namespace pdp
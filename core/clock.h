@@ -0,0 +1,59 @@
+#pragma once
+
+#include "internals.h"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <ctime>
+#endif
+
+namespace pdp {
+
+/// @brief Reads the time stamp counter, a single instruction. Convert readings with the functions
+/// below.
+///
+/// On targets without a TSC the ticks are CLOCK_MONOTONIC nanoseconds.
+inline uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+#endif
+}
+
+/// @brief Like ReadTsc() but waits for all previous instructions to execute first (rdtscp).
+inline uint64_t ReadTscOrdered() {
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned aux;
+  return __rdtscp(&aux);
+#else
+  return ReadTsc();
+#endif
+}
+
+/// @brief True if the TSC ticks at a constant rate regardless of frequency scaling and sleep
+/// states. Without it the clock is recalibrated more often and is less precise.
+bool HasInvariantTsc();
+
+/// @brief Converts a ReadTsc() value to CLOCK_MONOTONIC nanoseconds.
+///
+/// The clock is calibrated against CLOCK_MONOTONIC on first use and its drift is corrected
+/// periodically, by slewing the rate so that conversions never go back in time.
+uint64_t TscToMonotonicNs(uint64_t tsc);
+
+/// @brief Converts a ReadTsc() value to CLOCK_REALTIME nanoseconds.
+uint64_t TscToRealtimeNs(uint64_t tsc);
+
+/// @brief Converts a difference between ReadTsc() values to nanoseconds.
+uint64_t TscTicksToNs(uint64_t ticks);
+
+inline uint64_t MonotonicNs() { return TscToMonotonicNs(ReadTsc()); }
+
+inline uint64_t RealtimeNs() { return TscToRealtimeNs(ReadTsc()); }
+
+}  // namespace pdp
@@ -1,7 +1,11 @@
 #include "log.h"
+#include "binary_log.h"
 #include "check.h"
+#include "clock.h"
+#include "ring_log.h"
 
 #include <fcntl.h>
+#include <sched.h>
 #include <sys/file.h>
 #include <unistd.h>
 #include <cstring>
@@ -17,11 +21,24 @@ static std::atomic_int log_level = static_cast<int>(pdp::Level::kInfo);
 /// @note Each process has its own copy of this variable.
 static std::atomic_int log_output_fd = -1;
 
+/// @brief Set by RedirectLoggingToRing(), replaces writes to log_output_fd. Never unmapped.
+static std::atomic<pdp::RingLogHeader *> log_ring = nullptr;
+
+/// @brief Set by StartBinaryLogging().
+static std::atomic_bool log_binary = false;
+/// @brief Ids handed to sites by their first binary message, zero means undefined.
+static uint32_t num_binary_sites = 0;
+static std::atomic_flag binary_sites_lock = ATOMIC_FLAG_INIT;
+
+/// @brief Installed by SetLogBackend(), null for synchronous writes.
+static std::atomic<const pdp::LogBackend *> log_backend = nullptr;
+
 // TODO remove atomics and accept asyncs.
 
 namespace pdp {
 
 static void TerminateHandler() {
+  FlushLogBackend();
   int fd = log_output_fd.exchange(-1);
   if (PDP_LIKELY(fd > 0)) {
     close(fd);
@@ -62,8 +79,51 @@ void RedirectLogging(int fd) {
   std::set_terminate(TerminateHandler);
 }
 
+void RedirectLoggingToRing(const char *filename, size_t capacity) {
+  int fd = open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (PDP_UNLIKELY(fd < 0)) {
+    PDP_UNREACHABLE("Failed to redirect logging!");
+  }
+  // Lock before resetting, a running session may still be writing to the ring.
+  if (flock(fd, LOCK_EX) < 0) {
+    close(fd);
+    PDP_UNREACHABLE("Failed to obtain an exclusive lock on log file!");
+  }
+  RingLogHeader *ring = CreateRingLog(fd, capacity);
+  if (PDP_UNLIKELY(!ring)) {
+    close(fd);
+    PDP_UNREACHABLE("Failed to map the log ring!");
+  }
+  log_ring.store(ring, std::memory_order_release);
+  RedirectLogging(fd);
+}
+
+bool IsRingLogging() { return log_ring.load(std::memory_order_relaxed) != nullptr; }
+
+void WriteLogOutput(const StringSlice &str) {
+  RingLogHeader *ring = log_ring.load(std::memory_order_acquire);
+  if (ring) {
+    AppendRingLog(ring, str);
+  } else {
+    WriteFully(log_output_fd.load(), str.Data(), str.Size());
+  }
+}
+
 bool LockLogFile(int fd) { return flock(fd, LOCK_SH | LOCK_NB) == 0; }
 
+int GetLogDescriptor() { return log_output_fd.load(std::memory_order_relaxed); }
+
+void SetLogBackend(const LogBackend *backend) {
+  log_backend.store(backend, std::memory_order_release);
+}
+
+void FlushLogBackend() {
+  const LogBackend *backend = log_backend.exchange(nullptr);
+  if (backend) {
+    backend->flush();
+  }
+}
+
 static bool ShouldLogAt(Level level) {
   return log_level.load(std::memory_order_relaxed) <= static_cast<int>(level);
 }
@@ -121,22 +181,27 @@ void Pad3Unchecked(unsigned value, StringBuilder<Alloc> &out) {
   Pad2Unchecked(value - dig3 * 100, out);
 }
 
+/// @brief The "[date time" part of the last header written by this thread, valid for one second.
+struct DatePrefix {
+  time_t second = -1;
+  unsigned size = 0;
+  char chars[32];
+};
+
+static thread_local DatePrefix cached_prefix;
+
 template <typename Alloc>
-void WriteLogHeader(const StringSlice &filename, unsigned line, Level level,
-                    StringBuilder<Alloc> &out) {
-  // Capture current wall-clock time with nanosecond precision.
-  timespec ts;
-  memset(&ts, 0, sizeof(timespec));
-  clock_gettime(CLOCK_REALTIME, &ts);
-  // Convert to millisecond precision.
-  auto milli = ts.tv_nsec / 1'000'000;
+void WriteDatePrefix(time_t second, StringBuilder<Alloc> &out) {
+  if (PDP_LIKELY(cached_prefix.second == second)) {
+    out.AppendUnchecked(StringSlice(cached_prefix.chars, cached_prefix.size));
+    return;
+  }
   // Parse epoch time into day, month, year etc. fields.
   struct tm tm;
   memset(&tm, 0, sizeof(tm));
-  localtime_r(&ts.tv_sec, &tm);
-
-  // Write out timestamp
+  localtime_r(&second, &tm);
 
+  const size_t old_size = out.Size();
   out.AppendUnchecked('[');
   out.AppendUnchecked(tm.tm_year + 1900);
   out.AppendUnchecked('-');
@@ -150,6 +215,21 @@ void WriteLogHeader(const StringSlice &filename, unsigned line, Level level,
   Pad2Unchecked(tm.tm_min, out);
   out.AppendUnchecked(':');
   Pad2Unchecked(tm.tm_sec, out);
+
+  const size_t size = out.Size() - old_size;
+  if (size <= sizeof(cached_prefix.chars)) {
+    memcpy(cached_prefix.chars, out.Data() + old_size, size);
+    cached_prefix.size = size;
+    cached_prefix.second = second;
+  }
+}
+
+template <typename Alloc>
+void WriteLogHeader(const StringSlice &filename, unsigned line, Level level, uint64_t time_ns,
+                    StringBuilder<Alloc> &out) {
+  // Write out timestamp with millisecond precision.
+  WriteDatePrefix(time_ns / 1'000'000'000ull, out);
+  auto milli = time_ns % 1'000'000'000ull / 1'000'000;
   out.AppendUnchecked('.');
   Pad3Unchecked(milli, out);
 
@@ -173,22 +253,84 @@ void WriteLogHeader(const StringSlice &filename, unsigned line, Level level,
   out.AppendUnchecked(' ');
 }
 
-void Log(const char *f, unsigned line, Level level, const StringSlice &fmt, PackedValue *args,
-         uint64_t type_bits) {
-  if (PDP_UNLIKELY(!ShouldLogAt(level))) {
+template <typename Alloc>
+void WriteLogHeader(const StringSlice &filename, unsigned line, Level level,
+                    StringBuilder<Alloc> &out) {
+  WriteLogHeader(filename, line, level, RealtimeNs(), out);
+}
+
+void AppendLogHeader(const StringSlice &filename, unsigned line, Level level, uint64_t time_ns,
+                     StringBuilder<> &out) {
+  out.ReserveFor(EstimateHeaderSize() + filename.Size());
+  WriteLogHeader(filename, line, level, time_ns, out);
+}
+
+static void WriteLogBytes(const StringSlice &str) {
+  const LogBackend *backend = log_backend.load(std::memory_order_acquire);
+  if (backend) {
+    backend->write(str);
     return;
   }
-  StringSlice filename(f);
+  // Safeguard against blasting the terminal with output.
+  const size_t max_length = 65535;
+  WriteLogOutput(StringSlice(str.Data(), str.Size() < max_length ? str.Size() : max_length));
+}
+
+static void LogBinary(uint32_t site, PackedValue *args, uint64_t type_bits) {
+  char record[max_binary_record_size];
+  const size_t size = EncodeBinaryRecord(site, RealtimeNs(), args, type_bits, record);
+  WriteLogBytes(StringSlice(record, size));
+}
+
+/// @brief Writes the record defining @p site, unless another thread got there first.
+static uint32_t DefineBinarySite(LogSite &site) {
+  while (binary_sites_lock.test_and_set(std::memory_order_acquire)) {
+    sched_yield();
+  }
+  // The definition must precede the first message in the log, hence the lock around the write.
+  uint32_t id = site.binary_id.load(std::memory_order_relaxed);
+  if (id == 0) {
+    id = ++num_binary_sites;
+    char record[max_binary_record_size];
+    const size_t size = EncodeBinarySite(id, site, record);
+    WriteLogBytes(StringSlice(record, size));
+    site.binary_id.store(id, std::memory_order_release);
+  }
+  binary_sites_lock.clear(std::memory_order_release);
+  return id;
+}
+
+void StartBinaryLogging() {
+  pdp_assert(!IsRingLogging());
+  WriteLogOutput(StringSlice(binary_log_magic, sizeof(binary_log_magic)));
+  log_binary.store(true);
+}
+
+bool IsBinaryLogging() { return log_binary.load(std::memory_order_relaxed); }
+
+void Log(LogSite &site, PackedValue *args, uint64_t type_bits) {
+  if (PDP_UNLIKELY(!ShouldLogAt(site.level))) {
+    return;
+  }
+  if (log_binary.load(std::memory_order_relaxed)) {
+    uint32_t id = site.binary_id.load(std::memory_order_acquire);
+    if (PDP_UNLIKELY(id == 0)) {
+      id = DefineBinarySite(site);
+    }
+    LogBinary(id, args, type_bits);
+    return;
+  }
+  StringSlice filename(site.filename);
   StringBuilder<OneShotAllocator> builder;
 
   const size_t capacity =
-      EstimateHeaderSize() + filename.Size() + fmt.Size() + RunEstimator(args, type_bits);
+      EstimateHeaderSize() + filename.Size() + site.fmt.Size() + RunEstimator(args, type_bits);
   builder.ReserveFor(capacity);
 
-  WriteLogHeader(filename, line, level, builder);
-  builder.AppendPackUnchecked(fmt, args, type_bits);
+  WriteLogHeader(filename, site.line, site.level, builder);
+  builder.AppendPackUnchecked(site.fmt, args, type_bits);
   builder.AppendUnchecked('\n');
-  LogUnformatted(builder.ToSlice());
+  WriteLogBytes(builder.ToSlice());
 }
 
 void LogUnreachable(const char *f, unsigned line, const StringSlice &fmt, PackedValue *args,
@@ -234,10 +376,14 @@ void LogMultiLine(const char *f, unsigned line, Level level, StringSlice msg) {
 }
 
 void LogUnformatted(const StringSlice &str) {
-  const int fd = log_output_fd.load();
-  // Safeguard against blasting the terminal with output.
-  const size_t max_length = 65535;
-  WriteFully(fd, str.Data(), str.Size() < max_length ? str.Size() : max_length);
+  if (log_binary.load(std::memory_order_relaxed)) {
+    PackedValue args[2];
+    args[0]._str = str.Begin();
+    args[1]._uint64 = str.Size();
+    LogBinary(raw_text_site, args, kStr);
+    return;
+  }
+  WriteLogBytes(str);
 }
 
 }  // namespace pdp
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "trace_category.h"
 #include "strings/string_builder.h"
 
 #include <atomic>
@@ -17,8 +18,17 @@ constexpr const char *GetBasename(const StringSlice &name) {
 /// @brief Log message severity
 enum class Level { kInfo, kWarn, kError, kCrit, kTrace = 100 };
 
-void Log(const char *filename, unsigned line, Level level, const StringSlice &fmt,
-         PackedValue *args, uint64_t type_bits);
+/// @brief Everything about a log statement which is known at compile time, one per PDP_LOG.
+struct LogSite {
+  const char *filename;
+  StringSlice fmt;
+  unsigned line;
+  Level level;
+  /// Identifies the statement in binary logs, zero until its first message is logged.
+  std::atomic_uint32_t binary_id = 0;
+};
+
+void Log(LogSite &site, PackedValue *args, uint64_t type_bits);
 
 [[noreturn]]
 void LogUnreachable(const char *f, unsigned line, const StringSlice &fmt, PackedValue *args,
@@ -27,22 +37,63 @@ void LogUnreachable(const char *f, unsigned line, const StringSlice &fmt, Packed
 void RedirectLogging(const char *filename);
 void RedirectLogging(int fd);
 
+/// @brief Logs into a fixed size ring in @p filename instead, see RingLogHeader.
+///
+/// The file never grows past @p capacity (rounded up to a power of two) and the oldest messages
+/// are overwritten first. Appends are memcpys into the shared mapping, no system calls. The file is
+/// locked like with RedirectLogging(), follow_log reads it in order.
+void RedirectLoggingToRing(const char *filename, size_t capacity);
+
+bool IsRingLogging();
+
+/// @brief Writes @p str to the log file or ring, bypassing the LogBackend.
+void WriteLogOutput(const StringSlice &str);
+
 bool LockLogFile(int fd);
 
+/// @brief Writes messages as binary records instead of text from now on.
+///
+/// Each message is stored as the id of its LogSite, the time and the packed arguments, with string
+/// arguments copied. A site is described once, right before its first message. Formatting is left
+/// to the decode_log tool. Must be called after RedirectLogging(), not with a ring, whose oldest
+/// records (the site definitions) get overwritten.
+void StartBinaryLogging();
+
+bool IsBinaryLogging();
+
+/// @brief Appends the "[time] [level] [file:line] " prefix of a text log line.
+void AppendLogHeader(const StringSlice &filename, unsigned line, Level level, uint64_t time_ns,
+                     StringBuilder<> &out);
+
+/// @brief Descriptor set by RedirectLogging(), or -1.
+int GetLogDescriptor();
+
+/// @brief Alternative to writing every message synchronously, see AsyncLogger.
+struct LogBackend {
+  /// Called by LogUnformatted() instead of write(2). Must not log.
+  void (*write)(const StringSlice &str);
+  /// Writes out everything which was queued so far from the calling thread.
+  void (*flush)();
+};
+
+/// @brief Installs @p backend, or goes back to synchronous writes if null.
+void SetLogBackend(const LogBackend *backend);
+
+/// @brief Detaches the backend and flushes it. Later messages are written synchronously.
+/// Called from OnFatalError so that no queued message is lost when the process dies.
+void FlushLogBackend();
+
 // TODO comments
 
 /// @brief Formats message to stdout and to systemd
 ///
 /// Does not throw. Use the macros instead.
-/// @param header_size Precomputed exact size of header
-/// @param loc Source location where message happened
-/// @param level Message severity
-/// @param fmt The message with special format rules
+/// @param site Source location, severity and format string
 /// @param args Arguments to be placed in format string
 template <typename... Args>
-void Log(const char *filename, unsigned line, Level level, const StringSlice &fmt, Args &&...args) {
+void Log(LogSite &site, Args &&...args) {
   auto packed_args = MakePackedArgs(std::forward<Args>(args)...);
-  Log(filename, line, level, fmt, packed_args.slots, packed_args.type_bits);
+  Log(site, packed_args.slots, packed_args.type_bits);
 }
 
 template <typename... Args>
@@ -58,12 +109,11 @@ void LogMultiLine(const char *filename, unsigned line, Level level, StringSlice
 
 }  // namespace pdp
 
-// The constexpr variable is forced so GetBasename is computed at compile time and loaded directly
-// to a register.
-#define PDP_LOG(level, ...)                                   \
-  do {                                                        \
-    constexpr const char *_bn = ::pdp::GetBasename(__FILE__); \
-    ::pdp::Log(_bn, __LINE__, level, __VA_ARGS__);            \
+// The site is constant initialized, GetBasename is computed at compile time.
+#define PDP_LOG(level, fmt, ...)                                                             \
+  do {                                                                                       \
+    static ::pdp::LogSite _pdp_site = {::pdp::GetBasename(__FILE__), fmt, __LINE__, level}; \
+    ::pdp::Log(_pdp_site, ##__VA_ARGS__);                                                    \
   } while (0)
 
 #define PDP_LOG_MULTI_LINE(level, msg)                        \
@@ -72,33 +122,29 @@ void LogMultiLine(const char *filename, unsigned line, Level level, StringSlice
     ::pdp::LogMultiLine(_bn, __LINE__, level, msg);           \
   } while (0)
 
-/// @brief Disable atrace calls on macro level
+/// @brief Logs a trace message if @p category is enabled, see SetTraceCategories().
 ///
-/// 'atrace' can be used for debug prints, which will trigger a lot dynamic calls to 'log_at'
-/// without logging anything (hopefully, as we don't want debug prints in production). A simple
-/// optimization is to remove the calls on macro level. This reduces code size and avoids the
-/// dynamic calls. As a downside, enabling 'atrace' is more complicated. See also 'SetConsoleLevel'.
-#ifdef PDP_TRACE_MESSAGES
-#define pdp_trace(...)                                            \
-  do {                                                            \
-    constexpr const char *_bn = ::pdp::GetBasename(__FILE__);     \
-    ::pdp::Log(_bn, __LINE__, ::pdp::Level::kTrace, __VA_ARGS__); \
+/// Trace sites stay compiled in so they can be switched on in a running session. While the
+/// category is off a site costs one predictable flag test and its arguments are not evaluated.
+#define pdp_trace_in(category, fmt, ...)                 \
+  do {                                                   \
+    if (PDP_TRACE_ENABLED(category)) {                   \
+      PDP_LOG(::pdp::Level::kTrace, fmt, ##__VA_ARGS__); \
+    }                                                    \
   } while (0)
-#define pdp_trace_once(...)                                         \
-  do {                                                              \
-    static std::atomic_bool _once = false;                          \
-    if (_once.exchange(true) == false) {                            \
-      constexpr const char *_bn = ::pdp::GetBasename(__FILE__);     \
-      ::pdp::Log(_bn, __LINE__, ::pdp::Level::kTrace, __VA_ARGS__); \
-    }                                                               \
+#define pdp_trace(fmt, ...) pdp_trace_in(kMessages, fmt, ##__VA_ARGS__)
+#define pdp_trace_once(fmt, ...)                                 \
+  do {                                                           \
+    static std::atomic_bool _once = false;                       \
+    if (PDP_TRACE_ENABLED(kMessages) && !_once.exchange(true)) { \
+      PDP_LOG(::pdp::Level::kTrace, fmt, ##__VA_ARGS__);         \
+    }                                                            \
   } while (0)
-#else
-#define pdp_trace(...) (void)0
-#define pdp_trace_once(...) (void)0
-#endif
 
 #define pdp_info(fmt, ...) PDP_LOG(::pdp::Level::kInfo, fmt, ##__VA_ARGS__)
 
+#define pdp_info_multiline(msg) PDP_LOG_MULTI_LINE(::pdp::Level::kInfo, msg)
+
 #define pdp_warning(fmt, ...) PDP_LOG(::pdp::Level::kWarn, fmt, ##__VA_ARGS__)
 
 #define pdp_error(fmt, ...) PDP_LOG(::pdp::Level::kError, fmt, ##__VA_ARGS__)
@@ -0,0 +1,185 @@
+#include "ring_log.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace pdp {
+
+static char *RingData(RingLogHeader *ring) { return reinterpret_cast<char *>(ring + 1); }
+
+static const char *RingData(const RingLogHeader *ring) {
+  return reinterpret_cast<const char *>(ring + 1);
+}
+
+static void CopyFromRing(const RingLogHeader *ring, size_t capacity, uint64_t begin, size_t size,
+                         char *out) {
+  const size_t pos = begin & (capacity - 1);
+  const size_t first = size < capacity - pos ? size : capacity - pos;
+  memcpy(out, RingData(ring) + pos, first);
+  memcpy(out + first, RingData(ring), size - first);
+}
+
+static bool HoldsRing(int fd, RingLogHeader &header) {
+  return pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+         memcmp(header.magic, ring_log_magic, sizeof(ring_log_magic)) == 0;
+}
+
+RingLogHeader *CreateRingLog(int fd, size_t capacity) {
+  size_t rounded = 4096;
+  while (rounded < capacity) {
+    rounded *= 2;
+  }
+  const size_t file_size = sizeof(RingLogHeader) + rounded;
+  // Truncating first zeroes what a previous text log left behind. Bytes of a previous ring are
+  // never read once `reserved` is reset, and a reader of it may still map the whole file.
+  RingLogHeader previous;
+  if (!HoldsRing(fd, previous) && ftruncate(fd, 0) < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 ||
+      (static_cast<size_t>(st.st_size) < file_size && ftruncate(fd, file_size) < 0)) {
+    return nullptr;
+  }
+  void *mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (PDP_UNLIKELY(mapping == MAP_FAILED)) {
+    return nullptr;
+  }
+  RingLogHeader *ring = static_cast<RingLogHeader *>(mapping);
+  // Readers which see `reserved` of the new session also see its generation.
+  ring->generation.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  ring->reserved.store(0, std::memory_order_relaxed);
+  ring->written.store(0, std::memory_order_relaxed);
+  ring->capacity = rounded;
+  // Readers check the magic last.
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(ring->magic, ring_log_magic, sizeof(ring_log_magic));
+  return ring;
+}
+
+void CloseRingLog(RingLogHeader *ring) {
+  munmap(ring, sizeof(RingLogHeader) + ring->capacity);
+}
+
+bool OpenRingLog(int fd, RingLogReader &reader) {
+  RingLogHeader header;
+  if (!HoldsRing(fd, header) || header.capacity < 4096 ||
+      (header.capacity & (header.capacity - 1)) != 0) {
+    return false;
+  }
+  // A damaged header must not make reads go past the end of the file.
+  const size_t file_size = sizeof(RingLogHeader) + header.capacity;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < file_size) {
+    return false;
+  }
+  void *mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (PDP_UNLIKELY(mapping == MAP_FAILED)) {
+    return false;
+  }
+  reader.ring = static_cast<const RingLogHeader *>(mapping);
+  reader.capacity = header.capacity;
+  reader.offset = 0;
+  reader.generation = header.generation.load(std::memory_order_relaxed);
+  reader.fd = fd;
+  return true;
+}
+
+void CloseRingLog(RingLogReader &reader) {
+  munmap(const_cast<RingLogHeader *>(reader.ring), sizeof(RingLogHeader) + reader.capacity);
+  reader.ring = nullptr;
+  reader.capacity = 0;
+}
+
+void AppendRingLog(RingLogHeader *ring, const StringSlice &str) {
+  const size_t capacity = ring->capacity;
+  StringSlice tail = str;
+  if (PDP_UNLIKELY(tail.Size() > capacity)) {
+    tail.DropLeft(tail.Size() - capacity);
+  }
+  const size_t size = tail.Size();
+  const uint64_t begin = ring->reserved.fetch_add(size, std::memory_order_relaxed);
+  const size_t pos = begin & (capacity - 1);
+  const size_t first = size < capacity - pos ? size : capacity - pos;
+  memcpy(RingData(ring) + pos, tail.Data(), first);
+  memcpy(RingData(ring), tail.Data() + first, size - first);
+  ring->written.fetch_add(size, std::memory_order_release);
+}
+
+/// @brief True when a new session reset the ring since @p reader last read it. @p reserved is a
+/// value of RingLogHeader::reserved loaded before with acquire order.
+static bool IsNewSession(const RingLogReader &reader, uint64_t reserved) {
+  return reader.ring->generation.load(std::memory_order_relaxed) != reader.generation ||
+         reader.ring->capacity != reader.capacity || reserved < reader.offset;
+}
+
+/// @brief Starts over at a ring reset by a new session. False when it could not be mapped yet.
+static bool RestartRingLog(RingLogReader &reader) {
+  const uint64_t generation = reader.ring->generation.load(std::memory_order_relaxed);
+  if (reader.ring->capacity != reader.capacity) {
+    RingLogReader fresh;
+    if (!OpenRingLog(reader.fd, fresh)) {
+      // Caught in the middle of the reset, the old mapping stays valid since the file only grows.
+      return false;
+    }
+    CloseRingLog(reader);
+    reader.ring = fresh.ring;
+    reader.capacity = fresh.capacity;
+  }
+  reader.offset = 0;
+  reader.generation = generation;
+  ++reader.session;
+  return true;
+}
+
+uint64_t ReadRingLog(RingLogReader &reader, bool writers_gone, StringBuilder<> &out) {
+  const RingLogHeader *ring = reader.ring;
+  const size_t capacity = reader.capacity;
+  uint64_t &offset = reader.offset;
+
+  const uint64_t written = ring->written.load(std::memory_order_acquire);
+  const uint64_t end = ring->reserved.load(std::memory_order_acquire);
+  if (PDP_UNLIKELY(IsNewSession(reader, end))) {
+    return RestartRingLog(reader) ? ReadRingLog(reader, writers_gone, out) : 0;
+  }
+  if (written != end && !writers_gone) {
+    return 0;
+  }
+  const uint64_t oldest = end > capacity ? end - capacity : 0;
+  uint64_t begin = offset > oldest ? offset : oldest;
+  uint64_t lost = begin - offset;
+  if (begin >= end) {
+    offset = end > offset ? end : offset;
+    return lost;
+  }
+
+  const size_t size = end - begin;
+  const size_t old_size = out.Size();
+  char *dest = out.AppendUninitialized(size);
+  CopyFromRing(ring, capacity, begin, size, dest);
+
+  // Appends which started meanwhile may have overwritten the front of the copy.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t now_reserved = ring->reserved.load(std::memory_order_acquire);
+  if (PDP_UNLIKELY(IsNewSession(reader, now_reserved))) {
+    // Reset while copying, the copy may mix both sessions.
+    out.Truncate(old_size);
+    return RestartRingLog(reader) ? ReadRingLog(reader, writers_gone, out) : 0;
+  }
+  const uint64_t now_oldest = now_reserved > capacity ? now_reserved - capacity : 0;
+  if (PDP_UNLIKELY(now_oldest > begin)) {
+    const size_t clobbered = now_oldest - begin < size ? now_oldest - begin : size;
+    memmove(dest, dest + clobbered, size - clobbered);
+    if (clobbered > 0) {
+      out.Truncate(old_size + size - clobbered);
+    }
+    lost += clobbered;
+  }
+  offset = end;
+  return lost;
+}
+
+}  // namespace pdp
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "strings/string_builder.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Layout of a ring log, see RedirectLoggingToRing().
+///
+/// The file is a RingLogHeader followed by `capacity` bytes of data, mapped with MAP_SHARED. Byte
+/// number N of the log, counting from the start of the session, is stored at data[N % capacity].
+/// Contents live in the page cache, so they survive a crash of the process (not of the machine).
+struct alignas(64) RingLogHeader {
+  char magic[8];
+  /// Power of two.
+  uint64_t capacity;
+  /// Bytes handed out to writers. The log holds [reserved - capacity, reserved).
+  std::atomic_uint64_t reserved;
+  /// Bytes writers finished copying. Equal to `reserved` when no append is in flight.
+  std::atomic_uint64_t written;
+  /// Incremented by every session which resets the ring, before `reserved` goes back to zero.
+  std::atomic_uint64_t generation;
+};
+
+static_assert(sizeof(RingLogHeader) == 64);
+static_assert(std::atomic_uint64_t::is_always_lock_free);
+
+constexpr char ring_log_magic[8] = {'P', 'D', 'P', 'R', 'I', 'N', 'G', '1'};
+
+/// @brief Read side of a ring log, see OpenRingLog().
+struct RingLogReader {
+  const RingLogHeader *ring = nullptr;
+  /// Bytes of data mapped. Not read from the header again, a new session may rewrite it.
+  size_t capacity = 0;
+  /// Position in the log of the next byte to read.
+  uint64_t offset = 0;
+  /// Value of RingLogHeader::generation for the session being read.
+  uint64_t generation = 0;
+  /// Incremented when ReadRingLog() notices that a new session reset the ring.
+  uint32_t session = 0;
+  int fd = -1;
+};
+
+/// @brief Resets the file @p fd to an empty ring of at least @p capacity bytes and maps it.
+/// Returns null on failure. A ring left by a previous session is never shrunk, so that readers
+/// which still map all of it do not fault.
+RingLogHeader *CreateRingLog(int fd, size_t capacity);
+
+/// @brief Unmaps the ring of this session, must not be called after another session reset it.
+void CloseRingLog(RingLogHeader *ring);
+
+/// @brief Maps the ring log in @p fd read-only into @p reader, from the start of the log. Returns
+/// false if the file does not hold one.
+bool OpenRingLog(int fd, RingLogReader &reader);
+
+void CloseRingLog(RingLogReader &reader);
+
+/// @brief Copies @p str into the ring. Lock-free: concurrent appends reserve disjoint ranges with
+/// one atomic add and copy in parallel. Only the last `capacity` bytes are kept of longer strings.
+void AppendRingLog(RingLogHeader *ring, const StringSlice &str);
+
+/// @brief Appends the log from the offset of @p reader onwards to @p out and advances the offset
+/// past it.
+///
+/// While appends are in flight nothing is read, unless @p writers_gone, in which case the bytes of
+/// an interrupted append are read as they are. Returns the bytes after the offset which were
+/// overwritten before they could be read.
+///
+/// A ring with another generation was reset by a new session: it is mapped again if its capacity
+/// changed and read from its start, and `session` is incremented.
+uint64_t ReadRingLog(RingLogReader &reader, bool writers_gone, StringBuilder<> &out);
+
+}  // namespace pdp
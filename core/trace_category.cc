@@ -0,0 +1,82 @@
+#include "trace_category.h"
+#include "log.h"
+
+namespace pdp {
+
+static constexpr uint32_t CategoryBit(TraceCategory category) {
+  return 1u << static_cast<uint32_t>(category);
+}
+
+static constexpr uint32_t all_categories = CategoryBit(TraceCategory::kTotal) - 1;
+
+// The compile time features only pick the categories enabled at startup.
+std::atomic_uint32_t g_trace_categories = 0
+#ifdef PDP_TRACE_MESSAGES
+                                          | CategoryBit(TraceCategory::kMessages)
+#endif
+#ifdef PDP_TRACE_RPC_TOKENS
+                                          | CategoryBit(TraceCategory::kRpcTokens)
+#endif
+#ifdef PDP_TRACE_ROLLING_BUFFER
+                                          | CategoryBit(TraceCategory::kRollingBuffer)
+#endif
+    ;
+
+static const char *const category_names[] = {"messages", "rpc-tokens", "rolling-buffer"};
+
+static_assert(sizeof(category_names) / sizeof(category_names[0]) ==
+              static_cast<size_t>(TraceCategory::kTotal));
+
+void SetTraceEnabled(TraceCategory category, bool enabled) {
+  if (enabled) {
+    g_trace_categories.fetch_or(CategoryBit(category), std::memory_order_relaxed);
+  } else {
+    g_trace_categories.fetch_and(~CategoryBit(category), std::memory_order_relaxed);
+  }
+}
+
+static uint32_t FindCategories(const StringSlice &name) {
+  if (name == "all") {
+    return all_categories;
+  }
+  for (size_t i = 0; i < static_cast<size_t>(TraceCategory::kTotal); ++i) {
+    if (name == StringSlice(category_names[i])) {
+      return CategoryBit(static_cast<TraceCategory>(i));
+    }
+  }
+  return 0;
+}
+
+bool SetTraceCategories(const StringSlice &spec) {
+  bool okay = true;
+  StringSlice rest = spec;
+  while (!rest.Empty()) {
+    const char *comma = rest.MemChar(',');
+    StringSlice name(rest.Begin(), comma ? comma : rest.End());
+    rest = StringSlice(comma ? comma + 1 : rest.End(), rest.End());
+
+    const bool enable = !name.StartsWith('-');
+    if (!enable) {
+      name.DropLeft(1);
+    }
+    if (name.Empty()) {
+      continue;
+    }
+    if (name == "none") {
+      g_trace_categories.store(0, std::memory_order_relaxed);
+      continue;
+    }
+    const uint32_t bits = FindCategories(name);
+    if (PDP_UNLIKELY(bits == 0)) {
+      pdp_warning("Unknown trace category '{}'", name);
+      okay = false;
+    } else if (enable) {
+      g_trace_categories.fetch_or(bits, std::memory_order_relaxed);
+    } else {
+      g_trace_categories.fetch_and(~bits, std::memory_order_relaxed);
+    }
+  }
+  return okay;
+}
+
+}  // namespace pdp
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "internals.h"
+#include "strings/string_slice.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Groups of trace sites which are compiled in and switched on at runtime.
+enum class TraceCategory : uint32_t {
+  /// pdp_trace() messages.
+  kMessages,
+  /// Tokens of Neovim requests and responses.
+  kRpcTokens,
+  /// RollingBuffer reallocation counters.
+  kRollingBuffer,
+  kTotal
+};
+
+/// @brief Bit per enabled TraceCategory. Use IsTraceEnabled().
+extern std::atomic_uint32_t g_trace_categories;
+
+/// @brief A single relaxed load and test, cheap enough for every trace site.
+inline bool IsTraceEnabled(TraceCategory category) {
+  return g_trace_categories.load(std::memory_order_relaxed) &
+         (1u << static_cast<uint32_t>(category));
+}
+
+void SetTraceEnabled(TraceCategory category, bool enabled);
+
+/// @brief Applies a comma separated list of category names, e.g. "messages,-rpc-tokens". A leading
+/// '-' disables the category, "all" and "none" switch every category.
+/// @return False if a name is unknown, the other names are still applied.
+bool SetTraceCategories(const StringSlice &spec);
+
+}  // namespace pdp
+
+#define PDP_TRACE_ENABLED(category) \
+  PDP_UNLIKELY(::pdp::IsTraceEnabled(::pdp::TraceCategory::category))
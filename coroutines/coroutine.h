@@ -6,6 +6,7 @@
 #include "data/non_copyable.h"
 #include "strings/string_builder.h"
 #include "system/no_suspend_lock.h"
+#include "tracing/span_tracer.h"
 
 #include <coroutine>
 #include <cstdint>
@@ -14,6 +15,15 @@ namespace pdp {
 
 struct Coroutine : public NonCopyableNonMovable {
   struct promise_type {
+    /// Traces the lifetime of the handler as an async span named after the coroutine function.
+    explicit promise_type(const char *fn = __builtin_FUNCTION()) noexcept : name(fn) {
+      RecordTraceEvent(TracePhase::kAsyncBegin, name, reinterpret_cast<uint64_t>(this));
+    }
+
+    ~promise_type() {
+      RecordTraceEvent(TracePhase::kAsyncEnd, name, reinterpret_cast<uint64_t>(this));
+    }
+
     Coroutine get_return_object() noexcept {
       return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
     }
@@ -30,6 +40,9 @@ struct Coroutine : public NonCopyableNonMovable {
       NoSuspendLock::CheckUnlocked();
       return std::forward<Awaitable>(a);
     }
+
+   private:
+    const char *name;
   };
 
   explicit Coroutine(std::coroutine_handle<promise_type> c) : coro(c) {}
@@ -69,6 +82,7 @@ struct CoroutineTokenTable {
       if (PDP_LIKELY(token == table.Front().token)) {
         auto resumed = table.Front().coro;
         table.PopFront();
+        PDP_TRACE_SPAN("ResumeHandler", token);
         resumed.resume();
         return true;
       }
@@ -83,7 +97,7 @@ struct CoroutineTokenTable {
     for (uint32_t i = 0; i < table.Size(); ++i) {
       builder.AppendFormat("{} ", table.At(i).token);
     }
-    pdp_critical(builder.ToSlice());
+    pdp_critical("{}", builder.ToSlice());
   }
 
  private:
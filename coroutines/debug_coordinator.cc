@@ -3,8 +3,12 @@
 namespace pdp {
 
 DebugCoordinator::DebugCoordinator(const StringSlice &host, int vim_input_fd, int vim_output_fd,
-                                   ChildReaper &reaper)
-    : ssh_driver(nullptr), gdb_async(reaper), vim_async(vim_input_fd, vim_output_fd) {
+                                   ChildReaper &reaper, bool gdb_reader_thread)
+    : ssh_driver(nullptr),
+      pool(num_pool_workers),
+      gdb_async(reaper, gdb_reader_thread),
+      vim_async(vim_input_fd, vim_output_fd, path_cache, pool),
+      breakpoints(path_cache) {
   inferior_pid = -1;
   thread_selected = 1;
   frame_selected = 0;
@@ -22,6 +26,7 @@ DebugCoordinator::~DebugCoordinator() {
 }
 
 void DebugCoordinator::RegisterForPoll(PollTable &table) {
+  pool.RegisterForPoll(table);
   gdb_async.RegisterForPoll(table);
   vim_async.RegisterForPoll(table);
   if (ssh_driver) {
@@ -30,6 +35,7 @@ void DebugCoordinator::RegisterForPoll(PollTable &table) {
 }
 
 void DebugCoordinator::OnPollResults(PollTable &table) {
+  pool.OnPollResults(table);
   gdb_async.OnPollResults(table);
   vim_async.OnPollResults(table);
   if (ssh_driver) {
@@ -2,17 +2,19 @@
 
 #include "drivers/breakpoint_table.h"
 #include "drivers/jump_table.h"
+#include "drivers/path_probe_cache.h"
 #include "gdb_async_driver.h"
 #include "vim_async_driver.h"
 
 #include "drivers/ssh_driver.h"
 #include "system/poll_table.h"
+#include "system/thread_pool.h"
 
 namespace pdp {
 
 struct DebugCoordinator {
   DebugCoordinator(const StringSlice &host, int vim_input_fd, int vim_output_fd,
-                   ChildReaper &reaper);
+                   ChildReaper &reaper, bool gdb_reader_thread = false);
 
   ~DebugCoordinator();
 
@@ -22,6 +24,8 @@ struct DebugCoordinator {
   GdbAsyncDriver &GdbDriver();
   VimAsyncDriver &VimDriver();
   BreakpointTable &Breakpoints();
+  ThreadPool &Pool() { return pool; }
+  PathProbeCache &PathCache() { return path_cache; }
 
   pid_t GetInferiorPid() { return inferior_pid; }
 
@@ -36,7 +40,7 @@ struct DebugCoordinator {
   void RemoveThreadId(int64_t id) { PDP_IGNORE(id); }
 
   // TODO Do something useful
-  void InsertJump(const StringSlice &fullname, int lnum) {
+  void InsertJump(PathId fullname, int lnum) {
     PDP_IGNORE(fullname);
     PDP_IGNORE(lnum);
   }
@@ -49,8 +53,12 @@ struct DebugCoordinator {
   StringSlice GetHost() const { return ""; }
 
  private:
+  static constexpr unsigned num_pool_workers = 2;
+
   DefaultAllocator allocator;
   SshDriver *ssh_driver;
+  ThreadPool pool;
+  PathProbeCache path_cache;
 
   GdbAsyncDriver gdb_async;
   VimAsyncDriver vim_async;
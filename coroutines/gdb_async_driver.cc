@@ -1,17 +1,37 @@
 #include "gdb_async_driver.h"
+#include "core/log.h"
+#include "drivers/latency_stats.h"
 #include "parser/mi_parser.h"
+#include "tracing/execution_tracer.h"
 
 namespace pdp {
 
-GdbAsyncDriver::GdbAsyncDriver(ChildReaper &reaper) { gdb_driver.Start(reaper); }
+GdbAsyncDriver::GdbAsyncDriver(ChildReaper &reaper, bool reader_thread)
+    : gdb_reader(gdb_driver), use_reader_thread(reader_thread && g_recorder.IsNormal()) {
+  if (reader_thread && !use_reader_thread) {
+    pdp_warning("GDB reader thread disabled while recording or replaying");
+  }
+  gdb_driver.Start(reaper);
+  if (use_reader_thread) {
+    gdb_reader.Start();
+  }
+}
+
+GdbAsyncDriver::~GdbAsyncDriver() { gdb_reader.Stop(); }
 
 void GdbAsyncDriver::RegisterForPoll(PollTable &table) {
-  table.Register(gdb_driver.GetDescriptor());
+  if (use_reader_thread) {
+    table.Register(gdb_reader.GetDescriptor());
+  } else {
+    table.Register(gdb_driver.GetDescriptor());
+  }
   table.Register(gdb_driver.GetErrorDescriptor());
 }
 
 void GdbAsyncDriver::OnPollResults(PollTable &table) {
-  if (table.HasInputEventsUnchecked(gdb_driver.GetDescriptor())) {
+  if (use_reader_thread && table.HasInputEventsUnchecked(gdb_reader.GetDescriptor())) {
+    DrainParsedRecords();
+  } else if (!use_reader_thread && table.HasInputEventsUnchecked(gdb_driver.GetDescriptor())) {
     DrainRecords();
   } else if (table.HasInputEventsUnchecked(gdb_driver.GetErrorDescriptor())) {
     DrainErrors();
@@ -25,20 +45,17 @@ void GdbAsyncDriver::DrainRecords() {
     if (kind == GdbRecordKind::kStream) {
       HandleStream(record.stream.message);
     } else {
-      MiFirstPass first_pass(record.result_or_async.results);
-      if (PDP_UNLIKELY(!first_pass.Parse())) {
-        pdp_error("Pass #1 failed on: {}", record.result_or_async.results);
-        return;
-      }
-      MiSecondPass second_pass(record.result_or_async.results, first_pass);
-      UniquePtr<ExprBase> expr(second_pass.Parse());
+      UniquePtr<ExprBase> expr = ParseMiResults(record.result_or_async.results, mi_scratch);
       if (PDP_UNLIKELY(!expr)) {
-        pdp_error("Pass #2 failed on: {}", record.result_or_async.results);
         return;
       }
+      const uint64_t arrival_tsc = gdb_driver.LastRecordArrivalTsc();
       if (kind == GdbRecordKind::kAsync) {
-        HandleAsync(static_cast<GdbAsyncKind>(record.result_or_async.kind), std::move(expr));
+        auto async_kind = static_cast<GdbAsyncKind>(record.result_or_async.kind);
+        g_latency_stats.BeginAsyncEvent(async_kind, arrival_tsc);
+        HandleAsync(async_kind, std::move(expr));
       } else if (kind == GdbRecordKind::kResult) {
+        g_latency_stats.OnCommandResult(record.result_or_async.token, arrival_tsc);
         HandleResult(static_cast<GdbResultKind>(record.result_or_async.kind), std::move(expr));
       } else {
         pdp_assert(false);
@@ -48,6 +65,30 @@ void GdbAsyncDriver::DrainRecords() {
   }
 }
 
+void GdbAsyncDriver::DrainParsedRecords() {
+  // Acknowledge first, records published from now on will trigger another wakeup.
+  gdb_reader.AcknowledgeWakeup();
+  for (GdbParsedRecord *front = gdb_reader.Front(); front; front = gdb_reader.Front()) {
+    GdbParsedRecord record(std::move(*front));
+    gdb_reader.PopFront();
+
+    if (record.kind == GdbRecordKind::kStream) {
+      HandleStream(record.message.ToSlice());
+    } else if (record.kind == GdbRecordKind::kAsync) {
+      auto async_kind = static_cast<GdbAsyncKind>(record.sub_kind);
+      g_latency_stats.BeginAsyncEvent(async_kind, record.arrival_tsc);
+      HandleAsync(async_kind, std::move(record.expr));
+    } else if (record.kind == GdbRecordKind::kResult) {
+      g_latency_stats.OnCommandResult(record.token, record.arrival_tsc);
+      HandleResult(static_cast<GdbResultKind>(record.sub_kind), std::move(record.expr));
+    } else if (record.kind == GdbRecordKind::kNone) {
+      pdp_warning("GDB closed its output");
+    } else {
+      pdp_assert(false);
+    }
+  }
+}
+
 void GdbAsyncDriver::DrainErrors() {
   StringSlice error = gdb_driver.PollForErrors();
   while (!error.Empty()) {
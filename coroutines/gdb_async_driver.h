@@ -1,6 +1,8 @@
 #pragma once
 
+#include "data/arena.h"
 #include "drivers/gdb_driver.h"
+#include "drivers/gdb_reader.h"
 #include "parser/expr.h"
 #include "system/child_reaper.h"
 #include "system/poll_table.h"
@@ -8,13 +10,18 @@
 namespace pdp {
 
 struct GdbAsyncDriver {
-  GdbAsyncDriver(ChildReaper &reaper);
+  /// @param reaper Watches the GDB process.
+  /// @param use_reader_thread Read and parse GDB output on a dedicated thread. Ignored while the
+  /// execution is recorded or replayed, so that the recording stays deterministic.
+  GdbAsyncDriver(ChildReaper &reaper, bool use_reader_thread = false);
+  ~GdbAsyncDriver();
 
   void RegisterForPoll(PollTable &table);
   void OnPollResults(PollTable &table);
 
  private:
   void DrainRecords();
+  void DrainParsedRecords();
   void DrainErrors();
 
   void HandleStream(const StringSlice &msg);
@@ -22,6 +29,10 @@ struct GdbAsyncDriver {
   void HandleResult(GdbResultKind kind, UniquePtr<ExprBase> expr);
 
   GdbDriver gdb_driver;
+  GdbReader gdb_reader;
+  // Parser stacks of the records which are parsed on the main thread.
+  ChainedArena<> mi_scratch;
+  bool use_reader_thread;
 };
 
 }  // namespace pdp
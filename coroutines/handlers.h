@@ -4,9 +4,9 @@
 
 namespace pdp {
 
-void ClearBreakpointSign(DebugCoordinator &d, const StringSlice &in_id, bool should_delete);
+void ClearBreakpointSign(DebugCoordinator &d, BreakpointId in_id, bool should_delete);
 
-Coroutine PlaceBreakpointSign(DebugCoordinator &d, FixedString id);
+Coroutine PlaceBreakpointSign(DebugCoordinator &d, BreakpointId id);
 
 void FormatBreakpointMessage(DebugCoordinator &d, GdbExprView bkpt,
                              BreakpointTable::NoSuspendIterator it);
@@ -2,10 +2,10 @@
 
 namespace pdp {
 
-void ClearBreakpointSign(DebugCoordinator &d, const StringSlice &in_id, bool should_delete) {
+void ClearBreakpointSign(DebugCoordinator &d, BreakpointId in_id, bool should_delete) {
   for (auto &[id, br] : d.Breakpoints().GetAliases(in_id)) {
-    if (!br.fullname.Empty() && br.extmark > 0) {
-      d.VimDriver().DeleteBreakpointMark(br.fullname.ToSlice(), br.extmark);
+    if (br.fullname != PathTable::no_path && br.extmark > 0) {
+      d.VimDriver().DeleteBreakpointMark(br.fullname, br.extmark);
       br.extmark = 0;
     }
   }
@@ -16,11 +16,13 @@ void ClearBreakpointSign(DebugCoordinator &d, const StringSlice &in_id, bool sho
 }
 
 #if 0
-void PlaceBreakpointSign(DebugCoordinator &d, const StringSlice &id) {
+void PlaceBreakpointSign(DebugCoordinator &d, BreakpointId id) {
   auto it = d.Breakpoints().Find(id);
   pdp_assert(it != d.Breakpoints().End());
 
-  const bool check_file = !it->value.fullname.Empty() && FileReadable(it->value.fullname.Cstr());
+  const bool check_file =
+      it->value.fullname != PathTable::no_path &&
+      d.PathCache().Probe(g_path_table.Get(it->value.fullname)).readable;
   if (PDP_UNLIKELY(!check_file)) {
     return;
   }
@@ -29,7 +31,7 @@ void PlaceBreakpointSign(DebugCoordinator &d, const StringSlice &id) {
     return;
   }
   // TODO
-  // awaiter = d.VimDriver().PromiseBufferNumber(it->value.fullname.ToSlice());
+  // awaiter = d.VimDriver().PromiseBufferNumber(it->value.fullname);
 
   auto bufnr = co_await awaiter;
   if (PDP_LIKELY(bufnr < 0)) {
@@ -37,17 +39,17 @@ void PlaceBreakpointSign(DebugCoordinator &d, const StringSlice &id) {
   }
 
   PDP_BLOCK() {
-    auto it = d.Breakpoints().Find(id.ToSlice());
+    auto it = d.Breakpoints().Find(id);
     const bool deleted_during_suspend = it == d.Breakpoints().End();
     if (PDP_UNLIKELY(deleted_during_suspend)) {
       co_return;
     }
     awaiter =
-        d.VimDriver().PromiseBreakpointMark(id.ToSlice(), bufnr, it->value.lnum, it->value.enabled);
+        d.VimDriver().PromiseBreakpointMark(id, bufnr, it->value.lnum, it->value.enabled);
   }
 
   auto extmark = co_await awaiter;
-  auto it = d.Breakpoints().Find(id.ToSlice());
+  auto it = d.Breakpoints().Find(id);
   if (PDP_LIKELY(it != d.Breakpoints().End())) {
     it->value.extmark = extmark;
   }
@@ -60,7 +62,12 @@ void FormatBreakpointMessage(DebugCoordinator &d, GdbExprView bkpt,
   bool jumpable = false;
 
   MessageBuilder builder;
-  builder.AppendFormat("debugIdentifier", "*{}", it->key.ToSlice());
+  if (BreakpointMinor(it->key) != 0) {
+    builder.AppendFormat("debugIdentifier", "*{}.{}", BreakpointMajor(it->key),
+                         BreakpointMinor(it->key));
+  } else {
+    builder.AppendFormat("debugIdentifier", "*{}", BreakpointMajor(it->key));
+  }
   if (br.type & Breakpoint::kWatchBit) {
     builder.Append(" when ", "Normal");
     builder.AppendFormat("Bold", "\"{}\"", bkpt["what"].RequireStr());
@@ -78,7 +85,8 @@ void FormatBreakpointMessage(DebugCoordinator &d, GdbExprView bkpt,
   } else if (br.type == Breakpoint::kCatch) {
     builder.AppendFormat("Bold", "\"{}\"", bkpt["what"].RequireStr());
   } else if (br.type == Breakpoint::kBreak) {
-    jumpable = !br.fullname.Empty() && FileReadable(br.fullname.Cstr());
+    jumpable = br.fullname != PathTable::no_path &&
+               d.PathCache().Probe(g_path_table.Get(br.fullname)).readable;
     builder.Append(" in ", "Normal");
     auto hl = jumpable && br.enabled ? "debugJumpable" : "debugLocation";
     auto location = bkpt["at"];
@@ -89,7 +97,7 @@ void FormatBreakpointMessage(DebugCoordinator &d, GdbExprView bkpt,
       if (location) {
         builder.Append(location.RequireStr(), hl);
       } else if (jumpable) {
-        StringSlice basename = GetBasename(br.fullname.Cstr());
+        StringSlice basename = GetBasename(g_path_table.Cstr(br.fullname));
         builder.AppendFormat(hl, "{}:{}", basename, br.lnum);
       } else {
         StringSlice addr = bkpt["addr"].StrOr("???");
@@ -103,7 +111,7 @@ void FormatBreakpointMessage(DebugCoordinator &d, GdbExprView bkpt,
     d.VimDriver().HighlightLastLine(0, message_length, "@markup.strikethrough");
   }
   if (jumpable) {
-    d.InsertJump(br.fullname.ToSlice(), br.lnum);
+    d.InsertJump(br.fullname, br.lnum);
   }
 }
 
@@ -129,7 +137,7 @@ Coroutine HandleNewBreakpoint(DebugCoordinator &d, UniquePtr<ExprBase> expr) {
     co_return;
   }
 
-  ClearBreakpointSign(d, bkpt["number"].RequireStr(), false);
+  ClearBreakpointSign(d, ParseBreakpointId(bkpt["number"].RequireStr()), false);
 
   const bool check_race_condition = d.GetInferiorPid() > 0;
 
@@ -139,7 +147,7 @@ Coroutine HandleNewBreakpoint(DebugCoordinator &d, UniquePtr<ExprBase> expr) {
     for (size_t i = 0; i < locations.Count(); ++i) {
       auto [it, is_new] = d.Breakpoints().Insert(locations[i], bkpt);
       if (it->value.type == Breakpoint::kBreak) {
-        PlaceBreakpointSign(d, it->key.Copy());
+        PlaceBreakpointSign(d, it->key);
       }
       if (is_new && check_race_condition) {
         FormatBreakpointMessage(d, bkpt, it);
@@ -148,7 +156,7 @@ Coroutine HandleNewBreakpoint(DebugCoordinator &d, UniquePtr<ExprBase> expr) {
   } else {
     auto [it, is_new] = d.Breakpoints().Insert(bkpt, nullptr);
     if (it->value.type == Breakpoint::kBreak) {
-      PlaceBreakpointSign(d, it->key.Copy());
+      PlaceBreakpointSign(d, it->key);
     }
     if (is_new && check_race_condition) {
       FormatBreakpointMessage(d, bkpt, it);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "coroutine.h"
+#include "drivers/path_probe_cache.h"
+#include "system/thread_pool.h"
+
+namespace pdp {
+
+namespace impl {
+
+struct _PathProbeTask : public PoolTask {
+  _PathProbeTask(PathProbeCache *c, const StringSlice &p,
+                 std::coroutine_handle<Coroutine::promise_type> h)
+      : PoolTask(Run, Complete), cache(c), path(p), coro(h) {}
+
+  static void Run(PoolTask *task) {
+    auto *self = static_cast<_PathProbeTask *>(task);
+    self->result.Reset(PathProbeCache::Resolve(self->path.ToSlice()));
+  }
+
+  static void Complete(PoolTask *task) {
+    auto *self = static_cast<_PathProbeTask *>(task);
+    self->cache->Store(self->path.ToSlice(), std::move(self->result));
+    auto coro = self->coro;
+
+    DefaultAllocator allocator;
+    self->~_PathProbeTask();
+    Deallocate<_PathProbeTask>(allocator, self);
+
+    coro.resume();
+  }
+
+  PathProbeCache *cache;
+  FixedString path;
+  PathProbe result;
+  std::coroutine_handle<Coroutine::promise_type> coro;
+};
+
+}  // namespace impl
+
+/// @brief Looks up `path` in the cache. On a miss the path is resolved on the thread pool and the
+/// coroutine resumes once the result is stored. The path must outlive the suspension.
+struct PathProbeAwaiter {
+  PathProbeCache *cache;
+  ThreadPool *pool;
+  StringSlice path;
+
+  PathProbeAwaiter(PathProbeCache &c, ThreadPool &p, const StringSlice &s)
+      : cache(&c), pool(&p), path(s) {}
+
+  bool await_ready() const noexcept {
+    if (cache->Find(path)) {
+      return true;
+    }
+    if (pool->IsInline()) {
+      cache->Probe(path);
+      return true;
+    }
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<Coroutine::promise_type> coro) const noexcept {
+    DefaultAllocator allocator;
+    auto *task = Allocate<impl::_PathProbeTask>(allocator, 1);
+    new (task) impl::_PathProbeTask(cache, path, coro);
+    pool->Submit(task);
+  }
+
+  /// @brief The reference is valid until the cache is modified.
+  const PathProbe &await_resume() const noexcept { return cache->Probe(path); }
+};
+
+}  // namespace pdp
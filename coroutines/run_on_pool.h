@@ -0,0 +1,81 @@
+#pragma once
+
+#include "coroutine.h"
+#include "system/thread_pool.h"
+
+#include <type_traits>
+#include <utility>
+
+namespace pdp {
+
+/// @brief Runs a function on the thread pool and resumes the awaiting coroutine on the main
+/// thread, once the pool reports the completion.
+template <typename Fun>
+struct PoolAwaiter : public PoolTask {
+  using Result = std::invoke_result_t<Fun &>;
+
+  template <typename F>
+  PoolAwaiter(ThreadPool &p, F &&f)
+      : PoolTask(Run, Complete), pool(p), fun(std::forward<F>(f)), has_result(false) {}
+
+  ~PoolAwaiter() {
+    if constexpr (!std::is_void_v<Result>) {
+      if (has_result) {
+        ResultPtr()->~Result();
+      }
+    }
+  }
+
+  bool await_ready() noexcept {
+    if (pool.IsInline()) {
+      Invoke();
+      return true;
+    }
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<Coroutine::promise_type> c) noexcept {
+    coro = c;
+    pool.Submit(this);
+  }
+
+  Result await_resume() noexcept {
+    pdp_assert(has_result);
+    if constexpr (!std::is_void_v<Result>) {
+      return std::move(*ResultPtr());
+    }
+  }
+
+ private:
+  using Storage = std::conditional_t<std::is_void_v<Result>, char, Result>;
+
+  Storage *ResultPtr() { return reinterpret_cast<Storage *>(storage); }
+
+  void Invoke() {
+    if constexpr (std::is_void_v<Result>) {
+      fun();
+    } else {
+      new (storage) Result(fun());
+    }
+    has_result = true;
+  }
+
+  static void Run(PoolTask *task) { static_cast<PoolAwaiter *>(task)->Invoke(); }
+
+  static void Complete(PoolTask *task) { static_cast<PoolAwaiter *>(task)->coro.resume(); }
+
+  ThreadPool &pool;
+  Fun fun;
+  std::coroutine_handle<Coroutine::promise_type> coro;
+  bool has_result;
+  alignas(Storage) byte storage[sizeof(Storage)];
+};
+
+/// @brief `co_await RunOnPool(pool, fn)` evaluates `fn()` on a worker thread.
+/// The function must not touch state owned by the main thread.
+template <typename Fun>
+PoolAwaiter<std::decay_t<Fun>> RunOnPool(ThreadPool &pool, Fun &&fun) {
+  return PoolAwaiter<std::decay_t<Fun>>(pool, std::forward<Fun>(fun));
+}
+
+}  // namespace pdp
@@ -1,4 +1,7 @@
 #include "vim_async_driver.h"
+#include "path_probe_awaiter.h"
+#include "drivers/latency_stats.h"
+#include "tracing/tracing_counter.h"
 
 namespace pdp {
 
@@ -10,8 +13,9 @@ StringRpcAwaiter StringRpcQueue::NextAwaiter() {
   return StringRpcAwaiter(async_driver, token_begin++);
 }
 
-VimAsyncDriver::VimAsyncDriver(int vim_input_fd, int vim_output_fd)
-    : vim_driver(vim_input_fd, vim_output_fd) {
+VimAsyncDriver::VimAsyncDriver(int vim_input_fd, int vim_output_fd, PathProbeCache &c,
+                               ThreadPool &p)
+    : vim_driver(vim_input_fd, vim_output_fd), path_cache(c), pool(p) {
   InitializeNs();
   InitializeBuffers();
 }
@@ -30,16 +34,14 @@ void VimAsyncDriver::Drain() {
   VimRpcEvent event = vim_driver.PollRpcEvent();
   while (event) {
     if (PDP_LIKELY(event.IsResponse())) {
-#if PDP_TRACE_RPC_TOKENS
-      pdp_trace("Response: token={}", event.GetToken());
-#endif
+      pdp_trace_in(kRpcTokens, "Response: token={}", event.GetToken());
       const bool token_handled = suspended_handlers.Resume(event.GetToken());
       if (!token_handled) {
         vim_driver.SkipResult();
-#if PDP_TRACE_RPC_TOKENS
-        pdp_trace("Skipped: token={}", event.GetToken());
-#endif
+        pdp_trace_in(kRpcTokens, "Skipped: token={}", event.GetToken());
       }
+    } else if (event.IsRequest()) {
+      ReadRequestEvent(event.GetToken());
     } else {
       pdp_assert(event.IsNotify());
       ReadNotifyEvent();
@@ -59,27 +61,123 @@ void VimAsyncDriver::ReadNotifyEvent() {
     }
     auto bufnr = vim_driver.ReadInteger();
     auto name = vim_driver.ReadString();
-    if (name.ToSlice().StartsWith('/') && FileReadable(name.Cstr())) {
-      auto [it, _] = opened_buffers.Emplace(std::move(name));
-      it->value = bufnr;
-      OnNotifyNewBuffer(it->key.ToSlice(), it->value);
-    }
+    TrackBuffer(name.ToSlice(), bufnr);
   } else if (method == "pdp/buf_removed") {
     if (PDP_UNLIKELY(elems != 1)) {
       PDP_FMT_UNREACHABLE("Unexpected number of elements: {}", elems);
     }
     auto name = vim_driver.ReadString();
-    auto it = opened_buffers.Find(name.ToSlice());
-    if (it != opened_buffers.End()) {
-      opened_buffers.Erase(it);
+    auto probing_it = probing_buffers.Find(name.ToSlice());
+    if (probing_it != probing_buffers.End()) {
+      probing_buffers.Erase(probing_it);
+    }
+    // A path that was never interned cannot be an opened buffer.
+    PathId path = g_path_table.Find(name.ToSlice());
+    if (path != PathTable::no_path) {
+      auto it = opened_buffers.Find(path);
+      if (it != opened_buffers.End()) {
+        opened_buffers.Erase(it);
+      }
     }
+  } else if (method == "pdp/latency") {
+    g_latency_stats.LogReport();
+  } else if (method == "pdp/trace") {
+    if (PDP_UNLIKELY(elems != 1)) {
+      PDP_FMT_UNREACHABLE("Unexpected number of elements: {}", elems);
+    }
+    auto categories = vim_driver.ReadString();
+    SetTraceCategories(categories.ToSlice());
+  } else if (method == "pdp/counters") {
+    StringBuilder<> report;
+    AppendTracingCounters(report);
+    pdp_info("Counters:");
+    pdp_info_multiline(report.ToSlice());
   } else {
     PDP_FMT_UNREACHABLE("Unhandled notification {}", method.ToSlice());
   }
 }
 
-void VimAsyncDriver::OnNotifyNewBuffer(const StringSlice &fullname, int bufnr) {
-  pdp_info("Triggered notify event fullname={} bufnr={}", fullname, bufnr);
+/// @brief Adds {rss = bytes, <tag> = {live, peak}, ...}, the result of pdp/stats.
+static void AddMemoryStats(RpcBuilder &builder) {
+  builder.OpenShortMap();
+  builder.AddMapItem("rss", ReadResidentBytes());
+  for (size_t i = 0; i < static_cast<size_t>(MemoryTag::kTotal); ++i) {
+    const MemoryTag tag = static_cast<MemoryTag>(i);
+    builder.Add(MemoryTagName(tag));
+    builder.OpenShortArray();
+    builder.Add(MemoryTagLiveBytes(tag));
+    builder.Add(MemoryTagPeakBytes(tag));
+    builder.CloseShortArray();
+  }
+  builder.CloseShortMap();
+}
+
+void VimAsyncDriver::ReadRequestEvent(uint32_t msgid) {
+  FixedString method = vim_driver.ReadString();
+  auto elems = vim_driver.OpenArray();
+  for (uint32_t i = 0; i < elems; ++i) {
+    vim_driver.SkipResult();
+  }
+
+  RpcBuilder builder;
+  builder.RestartResponse(msgid);
+  if (method == "pdp/stats") {
+    builder.AddNil();
+    AddMemoryStats(builder);
+  } else {
+    pdp_warning("Unhandled request {}", method.ToSlice());
+    builder.Add("Unknown method");
+    builder.AddNil();
+  }
+  vim_driver.SendRpcResponse(builder);
+}
+
+void VimAsyncDriver::TrackBuffer(const StringSlice &name, int64_t bufnr) {
+  if (!name.StartsWith('/')) {
+    // Scratch and terminal buffers.
+    return;
+  }
+  const PathProbe *probe = path_cache.Find(name);
+  if (probe) {
+    if (probe->readable) {
+      InsertOpenedBuffer(g_path_table.Intern(name), bufnr);
+    }
+  } else {
+    ProbeNewBuffer(FixedString(name), bufnr);
+  }
+}
+
+Coroutine VimAsyncDriver::ProbeNewBuffer(FixedString path, int64_t bufnr) {
+  auto [probing_it, is_new] = probing_buffers.Emplace(path.ToSlice());
+  probing_it->value = bufnr;
+  if (!is_new) {
+    // Already being probed, the pending coroutine will pick up the new buffer number.
+    co_return;
+  }
+
+  // The pool only sees this copy of the path, never the path table.
+  const bool readable = (co_await PathProbeAwaiter(path_cache, pool, path.ToSlice())).readable;
+
+  probing_it = probing_buffers.Find(path.ToSlice());
+  const bool removed_during_suspend = probing_it == probing_buffers.End();
+  if (PDP_UNLIKELY(removed_during_suspend)) {
+    co_return;
+  }
+  bufnr = probing_it->value;
+  probing_buffers.Erase(probing_it);
+  if (readable) {
+    InsertOpenedBuffer(g_path_table.Intern(path.ToSlice()), bufnr);
+  }
+}
+
+void VimAsyncDriver::InsertOpenedBuffer(PathId fullname, int64_t bufnr) {
+  auto [it, _] = opened_buffers.Emplace(fullname);
+  it->value = bufnr;
+  OnNotifyNewBuffer(fullname, it->value);
+}
+
+void VimAsyncDriver::OnNotifyNewBuffer(PathId fullname, int bufnr) {
+  pdp_info("Triggered notify event fullname={} bufnr={}", g_path_table.Get(fullname), bufnr);
 #if 0
   auto it = pending_extmarks.Find(fullname);
   while (it != pending_extmarks.End()) {
@@ -122,7 +220,7 @@ IntegerRpcAwaiter VimAsyncDriver::PromiseBufferLineCount(int bufnr) {
   return IntegerRpcAwaiter(this, token);
 }
 
-void VimAsyncDriver::DeleteBreakpointMark(const StringSlice &fullname, int extmark) {
+void VimAsyncDriver::DeleteBreakpointMark(PathId fullname, int extmark) {
   auto it = opened_buffers.Find(fullname);
   if (it != opened_buffers.End()) {
     auto bufnr = it->value;
@@ -131,8 +229,8 @@ void VimAsyncDriver::DeleteBreakpointMark(const StringSlice &fullname, int extma
 }
 
 #if 0
-IntegerRpcAwaiter VimAsyncDriver::SetBreakpointMark(StringSlice mark, const StringSlice &fullname,
-                                                    int lnum, int enabled) {
+IntegerRpcAwaiter VimAsyncDriver::SetBreakpointMark(StringSlice mark, PathId fullname, int lnum,
+                                                    int enabled) {
   if 
 }
 
@@ -273,7 +371,7 @@ Coroutine VimAsyncDriver::InitializeBuffers() {
           break;
       }
     }
-    opened_buffers.EmplaceUnchecked(std::move(dynamic_str), all_buffers[i]);
+    TrackBuffer(name, all_buffers[i]);
   }
 
   IntegerRpcQueue new_buffers_queue = PrepareIntegerQueue();
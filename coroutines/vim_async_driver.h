@@ -1,9 +1,13 @@
 #pragma once
 
 #include "coroutine.h"
+#include "data/memory_tags.h"
+#include "drivers/path_probe_cache.h"
 #include "drivers/vim_driver.h"
 #include "external/emhash8.h"
+#include "strings/path_table.h"
 #include "system/poll_table.h"
+#include "system/thread_pool.h"
 
 namespace pdp {
 
@@ -80,7 +84,8 @@ struct VimAsyncDriver {
   friend struct IntegerRpcQueue;
   friend struct StringRpcQueue;
 
-  VimAsyncDriver(int vim_input_fd, int vim_output_fd);
+  VimAsyncDriver(int vim_input_fd, int vim_output_fd, PathProbeCache &path_cache,
+                 ThreadPool &pool);
 
   void RegisterForPoll(PollTable &table);
   void OnPollResults(PollTable &table);
@@ -95,9 +100,8 @@ struct VimAsyncDriver {
 
   IntegerRpcAwaiter PromiseBufferLineCount(int bufnr);
 
-  void DeleteBreakpointMark(const StringSlice &fullname, int extmark);
-  void SetBreakpointMark(const StringSlice &mark, const StringSlice &fullname, int lnum,
-                         int enabled);
+  void DeleteBreakpointMark(PathId fullname, int extmark);
+  void SetBreakpointMark(const StringSlice &mark, PathId fullname, int lnum, int enabled);
 
   void ShowNormal(const StringSlice &msg);
 
@@ -125,15 +129,28 @@ struct VimAsyncDriver {
 
   void Drain();
   void ReadNotifyEvent();
-  void OnNotifyNewBuffer(const StringSlice &fullname, int bufnr);
+  void ReadRequestEvent(uint32_t msgid);
+  void TrackBuffer(const StringSlice &name, int64_t bufnr);
+  Coroutine ProbeNewBuffer(FixedString path, int64_t bufnr);
+  void InsertOpenedBuffer(PathId fullname, int64_t bufnr);
+  void OnNotifyNewBuffer(PathId fullname, int bufnr);
 
   void SetBreakpointMark(const StringSlice &mark, int bufnr, int lnum, int enabled);
   void ShowPacked(const StringSlice &fmt, PackedValue *args, uint64_t type_bits);
 
   VimDriver vim_driver;
   CoroutineTokenTable suspended_handlers;
-  emhash8::StringMap<int64_t> opened_buffers;
-  emhash8::StringMap<FixedString> pending_extmarks;  // TODO change template arg
+  emhash8::Map<PathId, int64_t, emhash8::DefaultHasher, TaggedAllocator<MemoryTag::kOpenedBuffers>>
+      opened_buffers;
+  // Buffers whose path is being probed on the thread pool. Keyed by name, paths are only interned
+  // once found readable.
+  emhash8::StringMap<int64_t> probing_buffers;
+  PathProbeCache &path_cache;
+  ThreadPool &pool;
+  // TODO change template arg
+  emhash8::Map<PathId, FixedString, emhash8::DefaultHasher,
+               TaggedAllocator<MemoryTag::kPendingExtmarks>>
+      pending_extmarks;
 
   unsigned num_prompt_lines;
 
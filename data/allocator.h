@@ -1,15 +1,5 @@
 #pragma once
 
-// TODO: idea
-// allocator which holds memory and has a threshold for memory usage
-// if it rises too much it starts freeing memory.
-
-// TODO: idea
-// tagging an Allocator<size_t> and providing statistics for a specific allocation.
-// BIG
-// BRAIN
-// POWER
-
 #include "core/check.h"
 #include "core/once_guard.h"
 
@@ -184,7 +174,19 @@ void Deallocate(Alloc &allocator, void *ptr) {
 }
 
 #ifdef PDP_TRACE_ALLOCATIONS
+}  // namespace pdp
+
+#include "tracing_allocator.h"
+
+namespace pdp {
 using DefaultAllocator = TracingAllocator;
+#elif defined(PDP_POOL_ALLOCATIONS)
+}  // namespace pdp
+
+#include "pool_allocator.h"
+
+namespace pdp {
+using DefaultAllocator = PoolAllocator;
 #else
 using DefaultAllocator = MallocAllocator;
 #endif
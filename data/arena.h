@@ -2,13 +2,18 @@
 
 #include "core/check.h"
 #include "data/allocator.h"
+#include "data/memory_tags.h"
 #include "data/non_copyable.h"
 
 #include <cstdint>
+#include <cstring>
 
 namespace pdp {
 
-template <typename Alloc = DefaultAllocator>
+/// @brief Arena blocks of all subsystems are accounted under one tag.
+using ArenaBlockAllocator = TaggedAllocator<MemoryTag::kArena>;
+
+template <typename Alloc = ArenaBlockAllocator>
 struct Arena : public AlignmentTraits, public NonCopyable {
   Arena(size_t cap) {
     pdp_assert(cap < max_capacity);
@@ -74,4 +79,197 @@ struct Arena : public AlignmentTraits, public NonCopyable {
   Alloc allocator;
 };
 
+namespace impl {
+
+struct _ArenaBlock {
+  _ArenaBlock *next;
+  size_t capacity;
+
+  byte *Begin() { return reinterpret_cast<byte *>(this + 1); }
+  byte *End() { return Begin() + capacity; }
+};
+
+static_assert(sizeof(_ArenaBlock) % 16 == 0, "Block header must keep malloc alignment");
+
+}  // namespace impl
+
+/// @brief Position inside a ChainedArena which can be returned to with Rewind().
+struct ArenaMark {
+  impl::_ArenaBlock *block;
+  byte *head;
+};
+
+/// @brief Arena which grows by chaining blocks instead of asserting on overflow.
+///
+/// Memory is given back in bulk, either up to a Mark() with Rewind() or entirely with Reset().
+/// Blocks past the rewound position are kept for the next allocations until TrimSpareBlocks().
+/// Reset() frees all of them but the first one, which stays allocated for the lifetime of the
+/// arena.
+template <typename Alloc = ArenaBlockAllocator>
+struct ChainedArena : public AlignmentTraits, public NonCopyableNonMovable {
+  ChainedArena(size_t first_block_size = default_block_size) {
+    first = NewBlock(first_block_size, nullptr);
+    current = first;
+    head = first->Begin();
+    limit = first->End();
+  }
+
+  ~ChainedArena() { FreeBlocks(first); }
+
+  void *Allocate(uint32_t bytes) {
+    return PDP_ASSUME_ALIGNED(AllocateUnchecked(AlignUp(bytes)), alignment);
+  }
+
+  void *AllocateUnchecked(uint32_t bytes) {
+    pdp_assert(bytes > 0);
+    pdp_assert(bytes % alignment == 0);
+    if (PDP_UNLIKELY(size_t(limit - head) < bytes)) {
+      NextBlock(bytes);
+    }
+    void *ptr = head;
+    head += bytes;
+    return PDP_ASSUME_ALIGNED(ptr, alignment);
+  }
+
+  void *AllocateOrNull(uint32_t bytes) {
+    if (PDP_LIKELY(bytes > 0)) {
+      return Allocate(bytes);
+    } else {
+      return nullptr;
+    }
+  }
+
+  /// @brief Grows the most recent allocation in place.
+  /// @return False if `ptr` is not the last allocation or the current block is full.
+  bool TryExtend(void *ptr, uint32_t old_bytes, uint32_t new_bytes) {
+    pdp_assert(old_bytes <= new_bytes);
+    old_bytes = AlignUp(old_bytes);
+    new_bytes = AlignUp(new_bytes);
+    if (static_cast<byte *>(ptr) + old_bytes != head) {
+      return false;
+    }
+    if (size_t(limit - head) < new_bytes - old_bytes) {
+      return false;
+    }
+    head += new_bytes - old_bytes;
+    return true;
+  }
+
+  ArenaMark Mark() const { return ArenaMark{current, head}; }
+
+  /// @brief Frees everything allocated after `mark` was taken.
+  void Rewind(ArenaMark mark) {
+    pdp_assert(mark.head >= mark.block->Begin() && mark.head <= mark.block->End());
+    current = mark.block;
+    head = mark.head;
+    limit = current->End();
+  }
+
+  /// @brief Returns the blocks past the current one, which Rewind() keeps for reuse.
+  void TrimSpareBlocks() {
+    FreeBlocks(current->next);
+    current->next = nullptr;
+  }
+
+  /// @brief Frees everything and returns all blocks except the first one.
+  void Reset() {
+    FreeBlocks(first->next);
+    first->next = nullptr;
+    current = first;
+    head = first->Begin();
+    limit = first->End();
+  }
+
+  size_t NumBlocks() const {
+    size_t count = 0;
+    for (impl::_ArenaBlock *block = first; block; block = block->next) {
+      ++count;
+    }
+    return count;
+  }
+
+  static constexpr size_t default_block_size = 16_KB;
+  static constexpr size_t max_capacity = 1_GB;
+
+ private:
+  impl::_ArenaBlock *NewBlock(size_t capacity, impl::_ArenaBlock *next) {
+    pdp_assert(capacity < max_capacity);
+    auto *block = static_cast<impl::_ArenaBlock *>(
+        allocator.AllocateRaw(sizeof(impl::_ArenaBlock) + capacity));
+    pdp_assert(block);
+    block->next = next;
+    block->capacity = capacity;
+    return block;
+  }
+
+  void FreeBlocks(impl::_ArenaBlock *block) {
+    while (block) {
+      impl::_ArenaBlock *next = block->next;
+      allocator.DeallocateRaw(block);
+      block = next;
+    }
+  }
+
+  void NextBlock(uint32_t bytes) {
+    impl::_ArenaBlock *next = current->next;
+    // Reuse a block left over from a Rewind() when it is big enough.
+    if (!next || next->capacity < bytes) {
+      const size_t doubled = current->capacity * 2;
+      next = NewBlock(doubled > bytes ? doubled : bytes, next);
+      current->next = next;
+    }
+    current = next;
+    head = current->Begin();
+    limit = current->End();
+  }
+
+  impl::_ArenaBlock *first;
+  impl::_ArenaBlock *current;
+  byte *head;
+  byte *limit;
+
+  Alloc allocator;
+};
+
+/// @brief Allocator interface over a ChainedArena, for containers which only live as long as the
+/// arena position they were created at. Deallocation is a no-op.
+template <typename Alloc = ArenaBlockAllocator>
+struct ArenaAllocator {
+  ArenaAllocator(ChainedArena<Alloc> *a) : arena(a) {}
+
+  void *AllocateRaw(size_t bytes) {
+    pdp_assert(bytes < ChainedArena<Alloc>::max_capacity);
+    auto *size = static_cast<uint64_t *>(arena->Allocate(sizeof(uint64_t) + bytes));
+    *size = bytes;
+#ifdef PDP_ENABLE_ZERO_INITIALIZE
+    memset(size + 1, 0, bytes);
+#endif
+    return size + 1;
+  }
+
+  void DeallocateRaw(void *) {}
+
+  void *ReallocateRaw(void *ptr, size_t new_bytes) {
+    if (!ptr) {
+      return AllocateRaw(new_bytes);
+    }
+    uint64_t *size = static_cast<uint64_t *>(ptr) - 1;
+    if (new_bytes <= *size) {
+      return ptr;
+    }
+    if (arena->TryExtend(size, sizeof(uint64_t) + *size, sizeof(uint64_t) + new_bytes)) {
+      *size = new_bytes;
+      return ptr;
+    }
+    void *new_ptr = AllocateRaw(new_bytes);
+    memcpy(new_ptr, ptr, *size);
+    return new_ptr;
+  }
+
+  size_t GetAllocationSize(void *ptr) { return static_cast<uint64_t *>(ptr)[-1]; }
+
+ private:
+  ChainedArena<Alloc> *arena;
+};
+
 }  // namespace pdp
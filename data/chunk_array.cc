@@ -5,6 +5,24 @@ namespace pdp {
 
 namespace impl {
 
+// Chunks bigger than chunk_size bypass the cache. They are tagged in the chunk list so that they
+// are given back to the allocator.
+static constexpr uintptr_t _big_chunk_tag = 1;
+
+static byte *_TagBigChunk(byte *chunk) {
+  return reinterpret_cast<byte *>(reinterpret_cast<uintptr_t>(chunk) | _big_chunk_tag);
+}
+
+static void _ReleaseChunk(byte *chunk) {
+  const uintptr_t bits = reinterpret_cast<uintptr_t>(chunk);
+  if (bits & _big_chunk_tag) {
+    DefaultAllocator allocator;
+    allocator.DeallocateRaw(reinterpret_cast<byte *>(bits & ~_big_chunk_tag));
+  } else {
+    g_chunk_cache.Release(chunk);
+  }
+}
+
 }  // namespace impl
 
 ChunkHandle::ChunkHandle(byte **chunks, size_t num_chunks)
@@ -17,9 +35,10 @@ ChunkHandle::ChunkHandle(ChunkHandle &&rhs) : chunks(rhs.chunks), num_chunks(rhs
 ChunkHandle::~ChunkHandle() {
   if (chunks) {
     for (size_t i = 0; i < num_chunks; ++i) {
-      free(chunks[i]);
+      impl::_ReleaseChunk(chunks[i]);
     }
-    free(chunks);
+    DefaultAllocator allocator;
+    Deallocate<byte *>(allocator, chunks);
   }
 }
 
@@ -31,27 +50,43 @@ ChunkHandle ChunkArray::ReleaseChunks() {
 }
 
 ChunkArray::ChunkArray() : chunks(16) {
-  chunks += static_cast<byte *>(allocator.AllocateRaw(chunk_size));
-  top_used_bytes = 0;
 #ifdef PDP_TRACE_CHUNK_ARRAY
-  all_used_bytes = chunk_size;
+  allocated_bytes = chunk_size;
+  requested_bytes = 0;
+  cache_hits = 0;
+  cache_misses = 0;
 #endif
+  chunks += AcquireChunk();
+  top_used_bytes = 0;
 }
 
 ChunkArray::~ChunkArray() {
 #ifdef PDP_TRACE_CHUNK_ARRAY
   pdp_trace("Chunk array requested {}B vs actually allocated {}B", requested_bytes,
             allocated_bytes);
-  pdp_trace("Total {} calls to malloc", chunks.Size());
+  pdp_trace("Total {} chunks, {} cache hits and {} cache misses", chunks.Size(), cache_hits,
+            cache_misses);
 #endif
   impl::_VectorPrivAcess<byte *, DefaultAllocator> _stack_priv(chunks);
   if (_stack_priv.IsHoldingData()) {
     for (size_t i = 0; i < chunks.Size(); ++i) {
-      allocator.DeallocateRaw(chunks[i]);
+      impl::_ReleaseChunk(chunks[i]);
     }
   }
 }
 
+byte *ChunkArray::AcquireChunk() {
+#ifdef PDP_TRACE_CHUNK_ARRAY
+  bool is_hit;
+  byte *chunk = g_chunk_cache.Acquire(&is_hit);
+  cache_hits += is_hit;
+  cache_misses += !is_hit;
+  return chunk;
+#else
+  return g_chunk_cache.Acquire();
+#endif
+}
+
 void *ChunkArray::Allocate(uint32_t bytes) {
   return PDP_ASSUME_ALIGNED(AllocateUnchecked(AlignUp(bytes)), alignment);
 }
@@ -72,22 +107,22 @@ void *ChunkArray::AllocateUnchecked(uint32_t bytes) {
 
   if (PDP_TRACE_UNLIKELY(bytes >= chunk_size)) {
 #ifdef PDP_TRACE_CHUNK_ARRAY
-    pdp_assert(all_used_bytes <= max_capacity - bytes);
+    pdp_assert(allocated_bytes <= max_capacity - bytes);
     allocated_bytes += bytes;
 #endif
     byte *big_chunk = static_cast<byte *>(allocator.AllocateRaw(bytes));
 
     auto normal_chunk = chunks.Top();
-    chunks.Top() = big_chunk;
+    chunks.Top() = impl::_TagBigChunk(big_chunk);
     chunks += normal_chunk;
     return big_chunk;
   }
 
 #ifdef PDP_TRACE_CHUNK_ARRAY
-  pdp_assert(all_used_bytes <= max_capacity - chunk_size);
+  pdp_assert(allocated_bytes <= max_capacity - chunk_size);
   allocated_bytes += chunk_size;
 #endif
-  byte *result = static_cast<byte *>(allocator.AllocateRaw(chunk_size));
+  byte *result = AcquireChunk();
   chunks += result;
   top_used_bytes = bytes;
   return result;
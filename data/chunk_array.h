@@ -3,6 +3,7 @@
 // TODO flagged as not required
 
 #include "data/allocator.h"
+#include "data/chunk_cache.h"
 #include "data/stack.h"
 
 namespace pdp {
@@ -30,14 +31,18 @@ struct ChunkArray : public AlignmentTraits, public NonCopyableNonMovable {
 
   [[nodiscard]] ChunkHandle ReleaseChunks();
 
-  static constexpr size_t chunk_size = 64_KB;
+  static constexpr size_t chunk_size = ChunkCache::chunk_size;
   static constexpr size_t max_capacity = 1_GB;
 
  private:
+  byte *AcquireChunk();
+
   size_t top_used_bytes;
 #ifdef PDP_TRACE_CHUNK_ARRAY
   size_t allocated_bytes;
   size_t requested_bytes;
+  size_t cache_hits;
+  size_t cache_misses;
 #endif
   Stack<byte *> chunks;
 
@@ -0,0 +1,135 @@
+#include "chunk_cache.h"
+
+#include <sys/mman.h>
+
+namespace pdp {
+
+ChunkCache g_chunk_cache;
+
+void ChunkCache::Lock() {
+  while (is_locked.exchange(true, std::memory_order_acquire)) {
+    while (is_locked.load(std::memory_order_relaxed)) {
+      __builtin_ia32_pause();
+    }
+  }
+}
+
+void ChunkCache::Unlock() { is_locked.store(false, std::memory_order_release); }
+
+byte *ChunkCache::Acquire(bool *is_hit) {
+  byte *chunk = nullptr;
+  bool hit = true;
+  Lock();
+  if (num_free_slab_chunks > 0) {
+    chunk = free_slab_chunks[--num_free_slab_chunks];
+  } else if (num_cached > 0) {
+    chunk = cached[--num_cached];
+  } else if (use_slabs && MapSlab()) {
+    chunk = free_slab_chunks[--num_free_slab_chunks];
+    hit = false;
+  }
+  Unlock();
+
+  if (PDP_UNLIKELY(!chunk)) {
+    DefaultAllocator allocator;
+    chunk = static_cast<byte *>(allocator.AllocateRaw(chunk_size));
+    hit = false;
+  }
+  if (hit) {
+    hits.fetch_add(1, std::memory_order_relaxed);
+#ifdef PDP_ENABLE_ZERO_INITIALIZE
+    memset(chunk, 0, chunk_size);
+#endif
+  } else {
+    misses.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (is_hit) {
+    *is_hit = hit;
+  }
+  return chunk;
+}
+
+void ChunkCache::Release(byte *chunk) {
+  Lock();
+  if (IsSlabChunk(chunk)) {
+    pdp_assert(num_free_slab_chunks < max_slabs * chunks_per_slab);
+    free_slab_chunks[num_free_slab_chunks++] = chunk;
+    chunk = nullptr;
+  } else if (num_cached < max_cached_chunks) {
+    cached[num_cached++] = chunk;
+    chunk = nullptr;
+  }
+  Unlock();
+
+  if (chunk) {
+    DefaultAllocator allocator;
+    allocator.DeallocateRaw(chunk);
+  }
+}
+
+void ChunkCache::EnableHugePageSlabs(bool enable) {
+  Lock();
+  use_slabs = enable;
+  Unlock();
+}
+
+void ChunkCache::Trim() {
+  Lock();
+  size_t count = num_cached;
+  byte *to_free[max_cached_chunks];
+  for (size_t i = 0; i < count; ++i) {
+    to_free[i] = cached[i];
+  }
+  num_cached = 0;
+  Unlock();
+
+  DefaultAllocator allocator;
+  for (size_t i = 0; i < count; ++i) {
+    allocator.DeallocateRaw(to_free[i]);
+  }
+}
+
+ChunkCache::Stats ChunkCache::GetStats() {
+  Stats stats;
+  stats.hits = hits.load(std::memory_order_relaxed);
+  stats.misses = misses.load(std::memory_order_relaxed);
+  Lock();
+  stats.cached_chunks = num_cached + num_free_slab_chunks;
+  stats.num_slabs = num_slabs;
+  Unlock();
+  return stats;
+}
+
+bool ChunkCache::IsSlabChunk(byte *chunk) const {
+  for (size_t i = 0; i < num_slabs; ++i) {
+    if (chunk >= slabs[i] && chunk < slabs[i] + slab_size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ChunkCache::MapSlab() {
+  if (num_slabs == max_slabs) {
+    return false;
+  }
+  void *mem = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mem == MAP_FAILED) {
+    // No reserved huge pages, fall back to transparent huge pages.
+    mem = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (PDP_UNLIKELY(mem == MAP_FAILED)) {
+      return false;
+    }
+    madvise(mem, slab_size, MADV_HUGEPAGE);
+  }
+
+  byte *slab = static_cast<byte *>(mem);
+  slabs[num_slabs++] = slab;
+  for (size_t i = chunks_per_slab; i > 0; --i) {
+    free_slab_chunks[num_free_slab_chunks++] = slab + (i - 1) * chunk_size;
+  }
+  return true;
+}
+
+}  // namespace pdp
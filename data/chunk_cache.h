@@ -0,0 +1,65 @@
+#pragma once
+
+#include "data/allocator.h"
+
+#include <atomic>
+
+namespace pdp {
+
+/// @brief Process-wide cache of the fixed size chunks used by ChunkArray.
+///
+/// Released chunks are kept on a bounded free list and handed out again, so parsing a large
+/// message does not pay a malloc/free pair per chunk. Optionally, chunks are carved out of 2MB
+/// slabs which are backed by huge pages when the system allows it. Slab chunks are never freed.
+struct ChunkCache {
+  static constexpr size_t chunk_size = 64_KB;
+  static constexpr size_t max_cached_chunks = 64;
+  static constexpr size_t slab_size = 2_MB;
+  static constexpr size_t chunks_per_slab = slab_size / chunk_size;
+  static constexpr size_t max_slabs = 8;
+
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    size_t cached_chunks;
+    size_t num_slabs;
+  };
+
+  /// @param is_hit Optional, set to whether the chunk came from the cache.
+  byte *Acquire(bool *is_hit = nullptr);
+  void Release(byte *chunk);
+
+  /// @brief Serve misses from huge page slabs instead of malloc. Up to `max_slabs` are mapped.
+  void EnableHugePageSlabs(bool enable);
+
+  /// @brief Frees the cached chunks which did not come from a slab.
+  void Trim();
+
+  Stats GetStats();
+
+ private:
+  void Lock();
+  void Unlock();
+
+  bool IsSlabChunk(byte *chunk) const;
+  bool MapSlab();
+
+  std::atomic_bool is_locked;
+  bool use_slabs;
+
+  size_t num_cached;
+  byte *cached[max_cached_chunks];
+
+  size_t num_slabs;
+  byte *slabs[max_slabs];
+  size_t num_free_slab_chunks;
+  byte *free_slab_chunks[max_slabs * chunks_per_slab];
+
+  std::atomic_uint64_t hits;
+  std::atomic_uint64_t misses;
+};
+
+/// @brief Zero initialized, usable before any constructor runs.
+extern ChunkCache g_chunk_cache;
+
+}  // namespace pdp
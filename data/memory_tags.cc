@@ -0,0 +1,72 @@
+#include "memory_tags.h"
+#include "core/log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace pdp {
+
+static const char *const memory_tag_names[] = {
+    "rolling-buffer", "byte-stream",      "arena", "breakpoints",
+    "opened-buffers", "pending-extmarks", "ssh",
+};
+
+static_assert(sizeof(memory_tag_names) / sizeof(memory_tag_names[0]) ==
+              static_cast<size_t>(MemoryTag::kTotal));
+
+const char *MemoryTagName(MemoryTag tag) { return memory_tag_names[static_cast<size_t>(tag)]; }
+
+int64_t MemoryTagLiveBytes(MemoryTag tag) {
+  return impl::g_memory_tag_stats[static_cast<size_t>(tag)].live_bytes.load(
+      std::memory_order_relaxed);
+}
+
+int64_t MemoryTagPeakBytes(MemoryTag tag) {
+  return impl::g_memory_tag_stats[static_cast<size_t>(tag)].peak_bytes.load(
+      std::memory_order_relaxed);
+}
+
+int64_t ReadResidentBytes() {
+  int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+  if (PDP_UNLIKELY(fd < 0)) {
+    return -1;
+  }
+  char buf[128];
+  const ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (PDP_UNLIKELY(n <= 0)) {
+    return -1;
+  }
+  buf[n] = '\0';
+  // "size resident shared ..." in pages.
+  char *resident = strchr(buf, ' ');
+  if (PDP_UNLIKELY(!resident)) {
+    return -1;
+  }
+  return strtoll(resident + 1, nullptr, 10) * sysconf(_SC_PAGESIZE);
+}
+
+static int64_t ToKilobytes(int64_t bytes) { return (bytes + 1023) / 1024; }
+
+void AppendMemoryReport(StringBuilder<> &out) {
+  out.AppendFormat("rss {}KB", ToKilobytes(ReadResidentBytes()));
+  for (size_t i = 0; i < static_cast<size_t>(MemoryTag::kTotal); ++i) {
+    const MemoryTag tag = static_cast<MemoryTag>(i);
+    const int64_t peak = MemoryTagPeakBytes(tag);
+    if (peak == 0) {
+      continue;
+    }
+    out.AppendFormat(" {} {}KB/{}KB", StringSlice(MemoryTagName(tag)),
+                     ToKilobytes(MemoryTagLiveBytes(tag)), ToKilobytes(peak));
+  }
+}
+
+void LogMemoryReport() {
+  StringBuilder<> report;
+  AppendMemoryReport(report);
+  pdp_info("Memory (live/peak): {}", report.ToSlice());
+}
+
+}  // namespace pdp
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "data/allocator.h"
+#include "strings/string_builder.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Subsystems whose heap usage is accounted separately.
+enum class MemoryTag : uint8_t {
+  kRollingBuffer,
+  kByteStream,
+  /// Blocks of Arena and ChainedArena.
+  kArena,
+  kBreakpoints,
+  kOpenedBuffers,
+  kPendingExtmarks,
+  kSsh,
+  kTotal
+};
+
+namespace impl {
+
+struct _MemoryTagStats {
+  std::atomic_int64_t live_bytes;
+  std::atomic_int64_t peak_bytes;
+};
+
+/// @brief Zero initialized, usable before any constructor runs.
+inline _MemoryTagStats g_memory_tag_stats[static_cast<size_t>(MemoryTag::kTotal)];
+
+}  // namespace impl
+
+/// @brief Allocator which charges the usable size of its blocks to @p tag, with live and peak
+/// bytes. Two relaxed atomic adds per allocation on top of @p Alloc.
+template <MemoryTag tag, typename Alloc = DefaultAllocator>
+struct TaggedAllocator {
+  void *AllocateRaw(size_t bytes) {
+    void *ptr = allocator.AllocateRaw(bytes);
+    if (PDP_LIKELY(ptr)) {
+      OnBytesAcquired(allocator.GetAllocationSize(ptr));
+    }
+    return ptr;
+  }
+
+  void DeallocateRaw(void *ptr) {
+    if (ptr) {
+      OnBytesReleased(allocator.GetAllocationSize(ptr));
+    }
+    allocator.DeallocateRaw(ptr);
+  }
+
+  void *ReallocateRaw(void *ptr, size_t new_bytes) {
+    const size_t old_size = ptr ? allocator.GetAllocationSize(ptr) : 0;
+    void *new_ptr = allocator.ReallocateRaw(ptr, new_bytes);
+    if (PDP_UNLIKELY(!new_ptr && new_bytes > 0)) {
+      // The old block is untouched.
+      return nullptr;
+    }
+    OnBytesReleased(old_size);
+    if (new_ptr) {
+      OnBytesAcquired(allocator.GetAllocationSize(new_ptr));
+    }
+    return new_ptr;
+  }
+
+  size_t GetAllocationSize(void *ptr) { return allocator.GetAllocationSize(ptr); }
+
+ private:
+  static impl::_MemoryTagStats &Stats() {
+    return impl::g_memory_tag_stats[static_cast<size_t>(tag)];
+  }
+
+  static void OnBytesAcquired(size_t bytes) {
+    impl::_MemoryTagStats &stats = Stats();
+    const int64_t signed_bytes = static_cast<int64_t>(bytes);
+    const int64_t live =
+        stats.live_bytes.fetch_add(signed_bytes, std::memory_order_relaxed) + signed_bytes;
+    int64_t peak = stats.peak_bytes.load(std::memory_order_relaxed);
+    while (peak < live &&
+           !stats.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+  }
+
+  static void OnBytesReleased(size_t bytes) {
+    Stats().live_bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+  }
+
+  Alloc allocator;
+};
+
+const char *MemoryTagName(MemoryTag tag);
+int64_t MemoryTagLiveBytes(MemoryTag tag);
+int64_t MemoryTagPeakBytes(MemoryTag tag);
+
+/// @brief Resident set size of the process from /proc/self/statm, or -1.
+int64_t ReadResidentBytes();
+
+/// @brief Appends "rss X tag live/peak ..." on one line, sizes in KB. Tags which never allocated
+/// are left out.
+void AppendMemoryReport(StringBuilder<> &out);
+
+void LogMemoryReport();
+
+}  // namespace pdp
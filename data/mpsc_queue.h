@@ -0,0 +1,169 @@
+#pragma once
+
+#include "allocator.h"
+#include "core/check.h"
+#include "non_copyable.h"
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace pdp {
+
+/// @brief Bounded lock-free ring for handing elements from any number of producer threads to
+/// exactly one consumer thread.
+///
+/// Every slot carries a sequence number telling whether it is free for the producer claiming
+/// that position or ready for the consumer (D. Vyukov's bounded queue). Producers only contend on
+/// the tail index, the consumer owns the head index.
+template <typename T, typename Alloc = DefaultAllocator>
+struct MpscQueue : public NonCopyableNonMovable {
+  static constexpr size_t cache_line_size = 64;
+
+  MpscQueue(size_t power_of_two, Alloc alloc = Alloc()) : allocator(alloc) {
+    pdp_assert(power_of_two > 0);
+    pdp_assert((power_of_two & (power_of_two - 1)) == 0);
+
+    cells = Allocate<Cell>(allocator, power_of_two);
+    for (size_t i = 0; i < power_of_two; ++i) {
+      new (&cells[i].sequence) std::atomic_size_t(i);
+    }
+    mask = power_of_two - 1;
+    tail.store(0, std::memory_order_relaxed);
+    head = 0;
+  }
+
+  ~MpscQueue() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      while (IsReady(head)) {
+        cells[head & mask].Get()->~T();
+        ++head;
+      }
+    }
+    Deallocate<Cell>(allocator, cells);
+  }
+
+  size_t Capacity() const { return mask + 1; }
+
+  // Producer side
+
+  template <typename... Args>
+  bool TryEmplaceBack(Args &&...args) {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells[pos & mask];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          new (cell.storage) T(std::forward<Args>(args)...);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The consumer has not released the slot yet.
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief Claims `count` consecutive slots with a single CAS and moves the elements into them.
+  /// Either all elements are pushed or none. The moved-from elements are still owned by the
+  /// caller.
+  bool TryPushBatch(T *elements, size_t count) {
+    pdp_assert(count > 0 && count <= Capacity());
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      // The consumer releases slots in order, if the last slot is free then so are the others.
+      Cell &last = cells[(pos + count - 1) & mask];
+      const size_t sequence = last.sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + count - 1);
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      Cell &cell = cells[(pos + i) & mask];
+      // Released before the last slot, visible through the acquire above.
+      pdp_assert(cell.sequence.load(std::memory_order_relaxed) == pos + i);
+      new (cell.storage) T(std::move(elements[i]));
+      cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return true;
+  }
+
+  // Consumer side
+
+  bool Empty() const { return !IsReady(head); }
+
+  T *Front() {
+    if (!IsReady(head)) {
+      return nullptr;
+    }
+    return cells[head & mask].Get();
+  }
+
+  void PopFront() {
+    pdp_assert(IsReady(head));
+    Release(head);
+    ++head;
+  }
+
+  /// @brief Moves up to `max_count` ready elements out of the queue.
+  /// @param out Uninitialized storage, the elements are move constructed into it.
+  /// @return The number of elements that were popped.
+  size_t PopBatch(T *out, size_t max_count) {
+    size_t popped = 0;
+    while (popped < max_count && IsReady(head)) {
+      new (out + popped) T(std::move(*cells[head & mask].Get()));
+      Release(head);
+      ++head;
+      ++popped;
+    }
+    return popped;
+  }
+
+ private:
+  struct Cell {
+    T *Get() { return reinterpret_cast<T *>(storage); }
+
+    std::atomic_size_t sequence;
+    alignas(T) byte storage[sizeof(T)];
+  };
+
+  bool IsReady(size_t pos) const {
+    return cells[pos & mask].sequence.load(std::memory_order_acquire) == pos + 1;
+  }
+
+  void Release(size_t pos) {
+    Cell &cell = cells[pos & mask];
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      cell.Get()->~T();
+    }
+    cell.sequence.store(pos + Capacity(), std::memory_order_release);
+  }
+
+  Cell *cells;
+  size_t mask;
+  Alloc allocator;
+
+  byte padding0[cache_line_size];
+  // Claimed by the producers.
+  std::atomic_size_t tail;
+  byte padding1[cache_line_size - sizeof(std::atomic_size_t)];
+  // Owned by the consumer.
+  size_t head;
+  byte padding2[cache_line_size - sizeof(size_t)];
+};
+
+}  // namespace pdp
@@ -0,0 +1,509 @@
+#pragma once
+
+#include "core/check.h"
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace pdp {
+
+namespace impl {
+
+/// @brief Prefix of every block handed out by the PoolAllocator.
+struct _PoolHeader {
+  static constexpr uint32_t magic_value = 0x9001B10C;
+
+  enum Tier : uint16_t { kSmall, kLarge, kHuge };
+
+  uint16_t tier;
+  uint16_t size_class;
+  uint32_t magic;
+  uint64_t usable_size;
+};
+
+static_assert(sizeof(_PoolHeader) == 16, "Header must keep malloc alignment");
+
+/// @brief Freed blocks are chained through their first bytes.
+struct _PoolFreeBlock {
+  _PoolFreeBlock *next;
+};
+
+// Small classes: 16 byte steps up to 128 bytes, then four classes per power of two up to 4KB.
+constexpr size_t _pool_num_small_classes = 28;
+constexpr size_t _pool_max_small_size = 4096;
+// Large classes: spans of 8KB, 16KB, ... 1MB (header included), mapped with mmap.
+constexpr size_t _pool_num_large_classes = 8;
+constexpr size_t _pool_min_large_span = 8192;
+constexpr size_t _pool_max_large_span = 1024 * 1024;
+constexpr size_t _pool_max_cached_spans = 16;
+
+inline uint32_t _PoolSmallClass(size_t bytes) {
+  if (bytes <= 128) {
+    return bytes == 0 ? 0 : (bytes + 15) / 16 - 1;
+  }
+  const uint32_t shift = 63 - __builtin_clzll(bytes - 1);
+  return 8 + (shift - 7) * 4 + (((bytes - 1) >> (shift - 2)) - 4);
+}
+
+inline constexpr size_t _PoolSmallClassSize(uint32_t size_class) {
+  if (size_class < 8) {
+    return (size_class + 1) * 16;
+  }
+  const uint32_t shift = (size_class - 8) / 4 + 7;
+  return ((size_class - 8) % 4 + 5) << (shift - 2);
+}
+
+inline uint32_t _PoolLargeClass(size_t span_bytes) {
+  const uint32_t shift = 64 - __builtin_clzll(span_bytes - 1);
+  return shift <= 13 ? 0 : shift - 13;
+}
+
+inline constexpr size_t _PoolLargeClassSpan(uint32_t size_class) {
+  return _pool_min_large_span << size_class;
+}
+
+struct _PoolSpinLock {
+  void Lock() {
+    while (flag.exchange(true, std::memory_order_acquire)) {
+      while (flag.load(std::memory_order_relaxed)) {
+        __builtin_ia32_pause();
+      }
+    }
+  }
+
+  void Unlock() { flag.store(false, std::memory_order_release); }
+
+  std::atomic_bool flag;
+};
+
+struct _PoolFreeList {
+  _PoolSpinLock lock;
+  _PoolFreeBlock *head;
+  /// Written under `lock`, read without it to skip empty lists.
+  std::atomic_size_t count;
+};
+
+/// @brief Counters which are bumped on the hot path. Kept per thread and folded into the global
+/// counters when the thread cache talks to the global lists.
+struct _PoolCounters {
+  uint64_t small_hits;
+  uint64_t small_refills;
+  uint64_t small_misses;
+  uint64_t large_hits;
+  uint64_t large_misses;
+  uint64_t huge_allocations;
+};
+
+struct _PoolThreadCache {
+  _PoolFreeBlock *heads[_pool_num_small_classes];
+  uint32_t counts[_pool_num_small_classes];
+  _PoolCounters counters;
+  bool is_registered;
+};
+
+/// @brief Global state, zero initialized so it is usable before any constructor runs.
+struct _PoolGlobals {
+  _PoolFreeList small_lists[_pool_num_small_classes];
+  _PoolFreeList large_lists[_pool_num_large_classes];
+
+  // Bytes kept in the global lists, not counting spans whose pages were given back.
+  std::atomic_int64_t retained_bytes;
+  // Zero means the default limit.
+  std::atomic_int64_t retained_limit;
+  std::atomic_uint64_t trimmed_bytes;
+
+  std::atomic_uint64_t small_hits;
+  std::atomic_uint64_t small_refills;
+  std::atomic_uint64_t small_misses;
+  std::atomic_uint64_t large_hits;
+  std::atomic_uint64_t large_misses;
+  std::atomic_uint64_t huge_allocations;
+
+  // 0 - not created, 1 - being created, 2 - ready.
+  std::atomic_int key_state;
+  pthread_key_t thread_key;
+};
+
+inline _PoolGlobals g_pool_globals;
+inline thread_local _PoolThreadCache g_pool_thread_cache;
+
+constexpr int64_t _pool_default_retained_limit = 16 * 1024 * 1024;
+
+inline int64_t _PoolRetainedLimit() {
+  const int64_t limit = g_pool_globals.retained_limit.load(std::memory_order_relaxed);
+  return limit > 0 ? limit : _pool_default_retained_limit;
+}
+
+inline size_t _PoolThreadCacheLimit(uint32_t size_class) {
+  const size_t blocks = 64 * 1024 / _PoolSmallClassSize(size_class);
+  return blocks < 8 ? 8 : (blocks > 256 ? 256 : blocks);
+}
+
+inline void _PoolFoldCounters(_PoolCounters &counters) {
+  _PoolGlobals &globals = g_pool_globals;
+  globals.small_hits.fetch_add(counters.small_hits, std::memory_order_relaxed);
+  globals.small_refills.fetch_add(counters.small_refills, std::memory_order_relaxed);
+  globals.small_misses.fetch_add(counters.small_misses, std::memory_order_relaxed);
+  globals.large_hits.fetch_add(counters.large_hits, std::memory_order_relaxed);
+  globals.large_misses.fetch_add(counters.large_misses, std::memory_order_relaxed);
+  globals.huge_allocations.fetch_add(counters.huge_allocations, std::memory_order_relaxed);
+  memset(&counters, 0, sizeof(counters));
+}
+
+/// @brief Moves `count` blocks from the thread cache to the global list. Blocks that would push
+/// the retained bytes over the limit are returned to malloc instead.
+inline void _PoolFlushSmall(_PoolThreadCache &cache, uint32_t size_class, size_t count) {
+  _PoolGlobals &globals = g_pool_globals;
+  const int64_t block_bytes = _PoolSmallClassSize(size_class) + sizeof(_PoolHeader);
+  const int64_t limit = _PoolRetainedLimit();
+
+  _PoolFreeList &list = globals.small_lists[size_class];
+  size_t added = 0;
+  list.lock.Lock();
+  for (size_t i = 0; i < count; ++i) {
+    _PoolFreeBlock *block = cache.heads[size_class];
+    cache.heads[size_class] = block->next;
+    --cache.counts[size_class];
+
+    if (globals.retained_bytes.load(std::memory_order_relaxed) + block_bytes > limit) {
+      globals.trimmed_bytes.fetch_add(block_bytes, std::memory_order_relaxed);
+      free(reinterpret_cast<_PoolHeader *>(block) - 1);
+    } else {
+      globals.retained_bytes.fetch_add(block_bytes, std::memory_order_relaxed);
+      block->next = list.head;
+      list.head = block;
+      ++added;
+    }
+  }
+  list.count.store(list.count.load(std::memory_order_relaxed) + added, std::memory_order_relaxed);
+  list.lock.Unlock();
+  _PoolFoldCounters(cache.counters);
+}
+
+inline void _PoolThreadExit(void *arg) {
+  auto *cache = static_cast<_PoolThreadCache *>(arg);
+  for (uint32_t i = 0; i < _pool_num_small_classes; ++i) {
+    _PoolFlushSmall(*cache, i, cache->counts[i]);
+  }
+  cache->is_registered = false;
+}
+
+/// @brief Makes sure the cache of this thread is flushed when the thread exits.
+inline void _PoolRegisterThread(_PoolThreadCache &cache) {
+  _PoolGlobals &globals = g_pool_globals;
+  int state = globals.key_state.load(std::memory_order_acquire);
+  if (state != 2) {
+    int expected = 0;
+    if (globals.key_state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+      pthread_key_create(&globals.thread_key, _PoolThreadExit);
+      globals.key_state.store(2, std::memory_order_release);
+    } else {
+      while (globals.key_state.load(std::memory_order_acquire) != 2) {
+        __builtin_ia32_pause();
+      }
+    }
+  }
+  pthread_setspecific(globals.thread_key, &cache);
+  cache.is_registered = true;
+}
+
+}  // namespace impl
+
+/// @brief Allocator which recycles freed memory instead of returning it to the system.
+///
+/// - Small blocks (up to 4KB) are rounded to one of 28 size classes and kept in per-thread free
+/// lists, which overflow into global lists.
+/// - Large blocks (up to 1MB) are mmap'ed spans of power of two size, cached globally.
+/// - Anything bigger is mapped and unmapped directly.
+///
+/// The global lists hold at most SetPoolRetainedBytes() bytes. Past that, small blocks are given
+/// back to malloc and cached spans are released with MADV_FREE, so the kernel can take the pages
+/// back lazily while the address range is still reused.
+struct PoolAllocator {
+  void *AllocateRaw(size_t bytes) {
+    void *ptr;
+    if (PDP_LIKELY(bytes <= impl::_pool_max_small_size)) {
+      ptr = AllocateSmall(impl::_PoolSmallClass(bytes));
+    } else if (bytes + sizeof(impl::_PoolHeader) <= impl::_pool_max_large_span) {
+      ptr = AllocateLarge(impl::_PoolLargeClass(bytes + sizeof(impl::_PoolHeader)));
+    } else {
+      ptr = AllocateHuge(bytes);
+    }
+#ifdef PDP_ENABLE_ZERO_INITIALIZE
+    if (ptr) {
+      memset(ptr, 0, bytes);
+    }
+#endif
+    return ptr;
+  }
+
+  void DeallocateRaw(void *ptr) {
+    if (!ptr) {
+      return;
+    }
+    impl::_PoolHeader *header = HeaderOf(ptr);
+    switch (header->tier) {
+      case impl::_PoolHeader::kSmall:
+        DeallocateSmall(header);
+        break;
+      case impl::_PoolHeader::kLarge:
+        DeallocateLarge(header);
+        break;
+      default:
+        munmap(header, header->usable_size + sizeof(impl::_PoolHeader));
+        break;
+    }
+  }
+
+  void *ReallocateRaw(void *ptr, size_t new_bytes) {
+    if (!ptr) {
+      return AllocateRaw(new_bytes);
+    }
+    impl::_PoolHeader *header = HeaderOf(ptr);
+    if (new_bytes <= header->usable_size) {
+      return ptr;
+    }
+    void *new_ptr = AllocateRaw(new_bytes);
+    if (PDP_LIKELY(new_ptr)) {
+      memcpy(new_ptr, ptr, header->usable_size);
+      DeallocateRaw(ptr);
+    }
+    return new_ptr;
+  }
+
+  size_t GetAllocationSize(void *ptr) { return HeaderOf(ptr)->usable_size; }
+
+ private:
+  static impl::_PoolHeader *HeaderOf(void *ptr) {
+    auto *header = static_cast<impl::_PoolHeader *>(ptr) - 1;
+    pdp_assert(header->magic == impl::_PoolHeader::magic_value);
+    return header;
+  }
+
+  static void *AllocateSmall(uint32_t size_class) {
+    impl::_PoolThreadCache &cache = impl::g_pool_thread_cache;
+    impl::_PoolFreeBlock *block = cache.heads[size_class];
+    if (PDP_LIKELY(block)) {
+      cache.heads[size_class] = block->next;
+      --cache.counts[size_class];
+      ++cache.counters.small_hits;
+      return block;
+    }
+    if (PDP_UNLIKELY(!cache.is_registered)) {
+      impl::_PoolRegisterThread(cache);
+    }
+    if (RefillSmall(cache, size_class)) {
+      ++cache.counters.small_refills;
+      return AllocateSmall(size_class);
+    }
+
+    ++cache.counters.small_misses;
+    const size_t size = impl::_PoolSmallClassSize(size_class);
+    auto *header = static_cast<impl::_PoolHeader *>(malloc(sizeof(impl::_PoolHeader) + size));
+    if (PDP_UNLIKELY(!header)) {
+      return nullptr;
+    }
+    header->tier = impl::_PoolHeader::kSmall;
+    header->size_class = size_class;
+    header->magic = impl::_PoolHeader::magic_value;
+    header->usable_size = size;
+    return header + 1;
+  }
+
+  /// @brief Takes up to half of the thread cache limit from the global list.
+  static bool RefillSmall(impl::_PoolThreadCache &cache, uint32_t size_class) {
+    impl::_PoolGlobals &globals = impl::g_pool_globals;
+    impl::_PoolFreeList &list = globals.small_lists[size_class];
+    if (list.count.load(std::memory_order_relaxed) == 0) {
+      return false;
+    }
+    const int64_t block_bytes = impl::_PoolSmallClassSize(size_class) + sizeof(impl::_PoolHeader);
+    const size_t wanted = impl::_PoolThreadCacheLimit(size_class) / 2;
+
+    size_t taken = 0;
+    list.lock.Lock();
+    while (taken < wanted && list.head) {
+      impl::_PoolFreeBlock *block = list.head;
+      list.head = block->next;
+      block->next = cache.heads[size_class];
+      cache.heads[size_class] = block;
+      ++taken;
+    }
+    list.count.store(list.count.load(std::memory_order_relaxed) - taken, std::memory_order_relaxed);
+    list.lock.Unlock();
+
+    cache.counts[size_class] += taken;
+    globals.retained_bytes.fetch_sub(taken * block_bytes, std::memory_order_relaxed);
+    return taken > 0;
+  }
+
+  static void DeallocateSmall(impl::_PoolHeader *header) {
+    const uint32_t size_class = header->size_class;
+    impl::_PoolThreadCache &cache = impl::g_pool_thread_cache;
+    auto *block = reinterpret_cast<impl::_PoolFreeBlock *>(header + 1);
+    block->next = cache.heads[size_class];
+    cache.heads[size_class] = block;
+    ++cache.counts[size_class];
+
+    const size_t limit = impl::_PoolThreadCacheLimit(size_class);
+    if (PDP_UNLIKELY(cache.counts[size_class] > limit)) {
+      if (!cache.is_registered) {
+        impl::_PoolRegisterThread(cache);
+      }
+      impl::_PoolFlushSmall(cache, size_class, limit / 2);
+    }
+  }
+
+  static void *AllocateLarge(uint32_t size_class) {
+    impl::_PoolGlobals &globals = impl::g_pool_globals;
+    impl::_PoolThreadCache &cache = impl::g_pool_thread_cache;
+    const size_t span = impl::_PoolLargeClassSpan(size_class);
+
+    impl::_PoolFreeList &list = globals.large_lists[size_class];
+    list.lock.Lock();
+    impl::_PoolFreeBlock *block = list.head;
+    if (block) {
+      list.head = block->next;
+      list.count.fetch_sub(1, std::memory_order_relaxed);
+    }
+    list.lock.Unlock();
+
+    if (block) {
+      ++cache.counters.large_hits;
+      auto *header = reinterpret_cast<impl::_PoolHeader *>(block) - 1;
+      // Spans released with MADV_FREE were not counted.
+      if (header->size_class == size_class) {
+        globals.retained_bytes.fetch_sub(span, std::memory_order_relaxed);
+      }
+      header->size_class = size_class;
+      return block;
+    }
+
+    ++cache.counters.large_misses;
+    void *mem = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (PDP_UNLIKELY(mem == MAP_FAILED)) {
+      return nullptr;
+    }
+    auto *header = static_cast<impl::_PoolHeader *>(mem);
+    header->tier = impl::_PoolHeader::kLarge;
+    header->size_class = size_class;
+    header->magic = impl::_PoolHeader::magic_value;
+    header->usable_size = span - sizeof(impl::_PoolHeader);
+    return header + 1;
+  }
+
+  static void DeallocateLarge(impl::_PoolHeader *header) {
+    impl::_PoolGlobals &globals = impl::g_pool_globals;
+    const uint32_t size_class = header->size_class;
+    const size_t span = impl::_PoolLargeClassSpan(size_class);
+
+    impl::_PoolFreeList &list = globals.large_lists[size_class];
+    list.lock.Lock();
+    if (list.count.load(std::memory_order_relaxed) >= impl::_pool_max_cached_spans) {
+      list.lock.Unlock();
+      globals.trimmed_bytes.fetch_add(span, std::memory_order_relaxed);
+      munmap(header, span);
+      return;
+    }
+
+    if (globals.retained_bytes.load(std::memory_order_relaxed) + static_cast<int64_t>(span) >
+        impl::_PoolRetainedLimit()) {
+      // Keep the address range, let the kernel reclaim everything but the header page.
+      const size_t page = sysconf(_SC_PAGESIZE);
+      madvise(reinterpret_cast<byte *>(header) + page, span - page, MADV_FREE);
+      globals.trimmed_bytes.fetch_add(span - page, std::memory_order_relaxed);
+      // Marks the span as not counted in the retained bytes.
+      header->size_class = impl::_pool_num_large_classes;
+    } else {
+      globals.retained_bytes.fetch_add(span, std::memory_order_relaxed);
+    }
+    auto *block = reinterpret_cast<impl::_PoolFreeBlock *>(header + 1);
+    block->next = list.head;
+    list.head = block;
+    list.count.fetch_add(1, std::memory_order_relaxed);
+    list.lock.Unlock();
+  }
+
+  static void *AllocateHuge(size_t bytes) {
+    ++impl::g_pool_thread_cache.counters.huge_allocations;
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t length = (bytes + sizeof(impl::_PoolHeader) + page - 1) & ~(page - 1);
+    void *mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (PDP_UNLIKELY(mem == MAP_FAILED)) {
+      return nullptr;
+    }
+    auto *header = static_cast<impl::_PoolHeader *>(mem);
+    header->tier = impl::_PoolHeader::kHuge;
+    header->size_class = 0;
+    header->magic = impl::_PoolHeader::magic_value;
+    header->usable_size = length - sizeof(impl::_PoolHeader);
+    return header + 1;
+  }
+};
+
+/// @brief Upper bound for the memory kept in the global lists of the PoolAllocator.
+inline void SetPoolRetainedBytes(int64_t bytes) {
+  impl::g_pool_globals.retained_limit.store(bytes, std::memory_order_relaxed);
+}
+
+struct PoolAllocatorStats {
+  uint64_t small_hits;
+  uint64_t small_refills;
+  uint64_t small_misses;
+  uint64_t large_hits;
+  uint64_t large_misses;
+  uint64_t huge_allocations;
+  int64_t retained_bytes;
+  uint64_t trimmed_bytes;
+
+  double SmallHitRate() const {
+    const uint64_t total = small_hits + small_refills + small_misses;
+    return total ? double(small_hits + small_refills) / total : 0;
+  }
+
+  double LargeHitRate() const {
+    const uint64_t total = large_hits + large_misses;
+    return total ? double(large_hits) / total : 0;
+  }
+};
+
+/// @brief Global statistics, including the not yet folded counters of the calling thread.
+inline PoolAllocatorStats GetPoolAllocatorStats() {
+  impl::_PoolFoldCounters(impl::g_pool_thread_cache.counters);
+  impl::_PoolGlobals &globals = impl::g_pool_globals;
+
+  PoolAllocatorStats stats;
+  stats.small_hits = globals.small_hits.load(std::memory_order_relaxed);
+  stats.small_refills = globals.small_refills.load(std::memory_order_relaxed);
+  stats.small_misses = globals.small_misses.load(std::memory_order_relaxed);
+  stats.large_hits = globals.large_hits.load(std::memory_order_relaxed);
+  stats.large_misses = globals.large_misses.load(std::memory_order_relaxed);
+  stats.huge_allocations = globals.huge_allocations.load(std::memory_order_relaxed);
+  stats.retained_bytes = globals.retained_bytes.load(std::memory_order_relaxed);
+  stats.trimmed_bytes = globals.trimmed_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+inline void PrintPoolAllocatorReport(int fd) {
+  PoolAllocatorStats stats = GetPoolAllocatorStats();
+  dprintf(fd,
+          "Pool allocator: small %.1f%% hits (%lu thread, %lu global, %lu malloc), "
+          "large %.1f%% hits (%lu cached, %lu mapped), %lu huge, %ld bytes retained, "
+          "%lu bytes trimmed\n",
+          stats.SmallHitRate() * 100, static_cast<unsigned long>(stats.small_hits),
+          static_cast<unsigned long>(stats.small_refills),
+          static_cast<unsigned long>(stats.small_misses), stats.LargeHitRate() * 100,
+          static_cast<unsigned long>(stats.large_hits),
+          static_cast<unsigned long>(stats.large_misses),
+          static_cast<unsigned long>(stats.huge_allocations),
+          static_cast<long>(stats.retained_bytes),
+          static_cast<unsigned long>(stats.trimmed_bytes));
+}
+
+}  // namespace pdp
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "allocator.h"
+#include "core/check.h"
+#include "non_copyable.h"
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace pdp {
+
+/// @brief Bounded lock-free ring for handing elements from exactly one producer thread to exactly
+/// one consumer thread. Unlike LoopQueue it never grows: a full queue is reported to the producer.
+///
+/// The indices of the two sides live on separate cache lines and each side keeps a private copy of
+/// the other index, so the shared lines are only touched when the cached copy runs out.
+template <typename T, typename Alloc = DefaultAllocator>
+struct SpscQueue : public NonCopyableNonMovable {
+  static constexpr size_t cache_line_size = 64;
+
+  SpscQueue(size_t power_of_two, Alloc alloc = Alloc()) : allocator(alloc) {
+    pdp_assert(power_of_two > 0);
+    pdp_assert((power_of_two & (power_of_two - 1)) == 0);
+
+    ptr = Allocate<T>(allocator, power_of_two);
+    mask = power_of_two - 1;
+    tail.store(0, std::memory_order_relaxed);
+    cached_head = 0;
+    head.store(0, std::memory_order_relaxed);
+    cached_tail = 0;
+  }
+
+  ~SpscQueue() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      size_t end = tail.load(std::memory_order_acquire);
+      for (size_t i = head.load(std::memory_order_relaxed); i != end; ++i) {
+        ptr[i & mask].~T();
+      }
+    }
+    Deallocate<T>(allocator, ptr);
+  }
+
+  size_t Capacity() const { return mask + 1; }
+
+  // Producer side
+
+  template <typename... Args>
+  bool TryEmplaceBack(Args &&...args) {
+    const size_t pos = tail.load(std::memory_order_relaxed);
+    if (PDP_UNLIKELY(pos - cached_head > mask)) {
+      cached_head = head.load(std::memory_order_acquire);
+      if (pos - cached_head > mask) {
+        return false;
+      }
+    }
+    new (ptr + (pos & mask)) T(std::forward<Args>(args)...);
+    tail.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Moves up to `count` elements into the queue and publishes them at once. The moved-from
+  /// elements are still owned by the caller.
+  /// @return The number of elements that were pushed.
+  size_t TryPushBatch(T *elements, size_t count) {
+    const size_t pos = tail.load(std::memory_order_relaxed);
+    size_t free_slots = Capacity() - (pos - cached_head);
+    if (free_slots < count) {
+      cached_head = head.load(std::memory_order_acquire);
+      free_slots = Capacity() - (pos - cached_head);
+    }
+    const size_t pushed = count < free_slots ? count : free_slots;
+    for (size_t i = 0; i < pushed; ++i) {
+      new (ptr + ((pos + i) & mask)) T(std::move(elements[i]));
+    }
+    tail.store(pos + pushed, std::memory_order_release);
+    return pushed;
+  }
+
+  // Consumer side
+
+  bool Empty() {
+    const size_t pos = head.load(std::memory_order_relaxed);
+    if (pos == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+    }
+    return pos == cached_tail;
+  }
+
+  T *Front() {
+    if (Empty()) {
+      return nullptr;
+    }
+    return ptr + (head.load(std::memory_order_relaxed) & mask);
+  }
+
+  void PopFront() {
+    pdp_assert(!Empty());
+    const size_t pos = head.load(std::memory_order_relaxed);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      ptr[pos & mask].~T();
+    }
+    head.store(pos + 1, std::memory_order_release);
+  }
+
+  /// @brief Moves up to `max_count` elements out of the queue and releases their slots at once.
+  /// @param out Uninitialized storage, the elements are move constructed into it.
+  /// @return The number of elements that were popped.
+  size_t PopBatch(T *out, size_t max_count) {
+    const size_t pos = head.load(std::memory_order_relaxed);
+    size_t available = cached_tail - pos;
+    if (available < max_count) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      available = cached_tail - pos;
+    }
+    const size_t popped = max_count < available ? max_count : available;
+    for (size_t i = 0; i < popped; ++i) {
+      T &slot = ptr[(pos + i) & mask];
+      new (out + i) T(std::move(slot));
+      if constexpr (!std::is_trivially_destructible_v<T>) {
+        slot.~T();
+      }
+    }
+    head.store(pos + popped, std::memory_order_release);
+    return popped;
+  }
+
+ private:
+  T *ptr;
+  size_t mask;
+  Alloc allocator;
+
+  // Padding instead of alignas, the queue may live in memory from Allocate() which only
+  // guarantees malloc alignment.
+  byte padding0[cache_line_size];
+
+  // Written by the producer.
+  std::atomic_size_t tail;
+  size_t cached_head;
+  byte padding1[cache_line_size - sizeof(std::atomic_size_t) - sizeof(size_t)];
+
+  // Written by the consumer.
+  std::atomic_size_t head;
+  size_t cached_tail;
+  byte padding2[cache_line_size - sizeof(std::atomic_size_t) - sizeof(size_t)];
+};
+
+}  // namespace pdp
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "core/check.h"
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace pdp {
+
+inline void PrintAllocationReport(int fd);
+
+namespace impl {
+
+/// @brief Statistics of all allocations made through allocators constructed at one source line.
+struct _AllocationSite {
+  static constexpr size_t num_size_classes = 16;
+
+  // Zero while the slot is free, the hash of (file, line) once it is claimed.
+  std::atomic_uint64_t key;
+  std::atomic_bool is_ready;
+  const char *file;
+  int line;
+
+  std::atomic_int64_t allocations;
+  std::atomic_int64_t reallocations;
+  std::atomic_int64_t deallocations;
+  std::atomic_int64_t live_bytes;
+  std::atomic_int64_t peak_bytes;
+  std::atomic_int64_t total_bytes;
+  std::atomic_int64_t lifetime_ns;
+  // Requested sizes. Bucket 0 counts sizes up to 16 bytes, bucket i sizes in (2^(i+3), 2^(i+4)]
+  // and the last bucket is unbounded.
+  std::atomic_int64_t size_classes[num_size_classes];
+};
+
+/// @brief Fixed table of allocation sites. Zero initialized, so it is usable before any
+/// constructor runs and never destroyed.
+struct _AllocationRegistry {
+  static constexpr size_t max_sites = 2048;
+  // Site used when the table is full.
+  static constexpr uint32_t overflow_site = 0;
+
+  _AllocationSite sites[max_sites];
+  std::atomic_int64_t live_bytes;
+  std::atomic_int64_t peak_bytes;
+  std::atomic_bool report_registered;
+};
+
+inline _AllocationRegistry g_allocation_registry;
+
+struct _AllocationHeader {
+  static constexpr uint32_t magic_value = 0xA110CA7E;
+
+  uint32_t site;
+  uint32_t magic;
+  int64_t birth_ns;
+};
+
+static_assert(sizeof(_AllocationHeader) == 16, "Header must keep malloc alignment");
+
+inline int64_t _AllocationClock() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return ts.tv_sec * 1'000'000'000ll + ts.tv_nsec;
+}
+
+inline size_t _SizeClass(size_t bytes) {
+  if (bytes <= 16) {
+    return 0;
+  }
+  size_t size_class = (64 - __builtin_clzll(bytes - 1)) - 4;
+  return size_class < _AllocationSite::num_size_classes ? size_class
+                                                        : _AllocationSite::num_size_classes - 1;
+}
+
+inline void _AtomicMax(std::atomic_int64_t &target, int64_t value) {
+  int64_t current = target.load(std::memory_order_relaxed);
+  while (current < value &&
+         !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+inline void _PrintAllocationReportAtExit() { PrintAllocationReport(STDERR_FILENO); }
+
+inline uint32_t _RegisterAllocationSite(const char *file, int line) {
+  _AllocationRegistry &registry = g_allocation_registry;
+  if (!registry.report_registered.exchange(true, std::memory_order_relaxed)) {
+    atexit(_PrintAllocationReportAtExit);
+  }
+
+  // The same header included from different translation units yields different pointers for
+  // the same file. Those are merged when printing the report.
+  uint64_t key = reinterpret_cast<uintptr_t>(file) * 0x9E3779B97F4A7C15ull ^ line;
+  key |= 1;
+
+  const size_t mask = _AllocationRegistry::max_sites - 1;
+  for (size_t probe = 0; probe < _AllocationRegistry::max_sites; ++probe) {
+    // Slot 0 is reserved for the overflow site.
+    const size_t index = ((key >> 32) + probe) & mask;
+    if (index == _AllocationRegistry::overflow_site) {
+      continue;
+    }
+    _AllocationSite &site = registry.sites[index];
+    uint64_t expected = 0;
+    if (site.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+      site.file = file;
+      site.line = line;
+      site.is_ready.store(true, std::memory_order_release);
+      return index;
+    }
+    if (expected == key) {
+      while (!site.is_ready.load(std::memory_order_acquire)) {
+      }
+      if (site.file == file && site.line == line) {
+        return index;
+      }
+    }
+  }
+  return _AllocationRegistry::overflow_site;
+}
+
+}  // namespace impl
+
+/// @brief Allocator which attributes every allocation to the source line where the allocator
+/// was constructed and keeps per-site counts, live/peak bytes, lifetimes and a histogram of the
+/// requested sizes. A sorted report is printed at exit or with PrintAllocationReport().
+///
+/// Each allocation is prefixed with a 16 byte header, so memory from this allocator must never
+/// be released with free().
+struct TracingAllocator {
+  TracingAllocator(const char *file = __builtin_FILE(), int line = __builtin_LINE()) noexcept
+      : site(impl::_RegisterAllocationSite(file, line)) {}
+
+  void *AllocateRaw(size_t bytes) {
+    auto *header = static_cast<impl::_AllocationHeader *>(
+        malloc(sizeof(impl::_AllocationHeader) + bytes));
+    if (PDP_UNLIKELY(!header)) {
+      return nullptr;
+    }
+    header->site = site;
+    header->magic = impl::_AllocationHeader::magic_value;
+    header->birth_ns = impl::_AllocationClock();
+
+    void *ptr = header + 1;
+#ifdef PDP_ENABLE_ZERO_INITIALIZE
+    memset(ptr, 0, bytes);
+#endif
+    impl::_AllocationSite &stats = Site(site);
+    stats.allocations.fetch_add(1, std::memory_order_relaxed);
+    stats.size_classes[impl::_SizeClass(bytes)].fetch_add(1, std::memory_order_relaxed);
+    OnBytesAcquired(stats, UsableSize(header));
+    return ptr;
+  }
+
+  void DeallocateRaw(void *ptr) {
+    if (!ptr) {
+      return;
+    }
+    impl::_AllocationHeader *header = HeaderOf(ptr);
+    impl::_AllocationSite &stats = Site(header->site);
+    stats.deallocations.fetch_add(1, std::memory_order_relaxed);
+    stats.lifetime_ns.fetch_add(impl::_AllocationClock() - header->birth_ns,
+                                std::memory_order_relaxed);
+    OnBytesReleased(stats, UsableSize(header));
+    header->magic = 0;
+    free(header);
+  }
+
+  void *ReallocateRaw(void *ptr, size_t new_bytes) {
+    if (!ptr) {
+      return AllocateRaw(new_bytes);
+    }
+    impl::_AllocationHeader *header = HeaderOf(ptr);
+    impl::_AllocationSite &stats = Site(header->site);
+    const size_t old_size = UsableSize(header);
+
+    header = static_cast<impl::_AllocationHeader *>(
+        realloc(header, sizeof(impl::_AllocationHeader) + new_bytes));
+    if (PDP_UNLIKELY(!header)) {
+      return nullptr;
+    }
+    stats.reallocations.fetch_add(1, std::memory_order_relaxed);
+    stats.size_classes[impl::_SizeClass(new_bytes)].fetch_add(1, std::memory_order_relaxed);
+    OnBytesReleased(stats, old_size);
+    OnBytesAcquired(stats, UsableSize(header));
+    return header + 1;
+  }
+
+  size_t GetAllocationSize(void *ptr) { return UsableSize(HeaderOf(ptr)); }
+
+ private:
+  static impl::_AllocationSite &Site(uint32_t index) {
+    return impl::g_allocation_registry.sites[index];
+  }
+
+  static impl::_AllocationHeader *HeaderOf(void *ptr) {
+    auto *header = static_cast<impl::_AllocationHeader *>(ptr) - 1;
+    pdp_assert(header->magic == impl::_AllocationHeader::magic_value);
+    return header;
+  }
+
+  static size_t UsableSize(impl::_AllocationHeader *header) {
+    return malloc_usable_size(header) - sizeof(impl::_AllocationHeader);
+  }
+
+  static void OnBytesAcquired(impl::_AllocationSite &stats, size_t bytes) {
+    const int64_t signed_bytes = static_cast<int64_t>(bytes);
+    stats.total_bytes.fetch_add(signed_bytes, std::memory_order_relaxed);
+    int64_t live = stats.live_bytes.fetch_add(signed_bytes, std::memory_order_relaxed);
+    impl::_AtomicMax(stats.peak_bytes, live + signed_bytes);
+
+    auto &registry = impl::g_allocation_registry;
+    live = registry.live_bytes.fetch_add(signed_bytes, std::memory_order_relaxed);
+    impl::_AtomicMax(registry.peak_bytes, live + signed_bytes);
+  }
+
+  static void OnBytesReleased(impl::_AllocationSite &stats, size_t bytes) {
+    const int64_t signed_bytes = static_cast<int64_t>(bytes);
+    stats.live_bytes.fetch_sub(signed_bytes, std::memory_order_relaxed);
+    impl::g_allocation_registry.live_bytes.fetch_sub(signed_bytes, std::memory_order_relaxed);
+  }
+
+  uint32_t site;
+};
+
+namespace impl {
+
+struct _SiteSnapshot {
+  const char *file;
+  int line;
+  int64_t allocations;
+  int64_t reallocations;
+  int64_t deallocations;
+  int64_t live_bytes;
+  int64_t peak_bytes;
+  int64_t total_bytes;
+  int64_t lifetime_ns;
+  int64_t size_classes[_AllocationSite::num_size_classes];
+};
+
+inline void _AccumulateSite(_SiteSnapshot &out, const _AllocationSite &site) {
+  out.allocations += site.allocations.load(std::memory_order_relaxed);
+  out.reallocations += site.reallocations.load(std::memory_order_relaxed);
+  out.deallocations += site.deallocations.load(std::memory_order_relaxed);
+  out.live_bytes += site.live_bytes.load(std::memory_order_relaxed);
+  // Sum of the peaks of merged sites, an upper bound of the real peak.
+  out.peak_bytes += site.peak_bytes.load(std::memory_order_relaxed);
+  out.total_bytes += site.total_bytes.load(std::memory_order_relaxed);
+  out.lifetime_ns += site.lifetime_ns.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < _AllocationSite::num_size_classes; ++i) {
+    out.size_classes[i] += site.size_classes[i].load(std::memory_order_relaxed);
+  }
+}
+
+}  // namespace impl
+
+/// @brief Writes the allocation statistics of all sites, sorted by the number of bytes
+/// allocated, to the given descriptor.
+inline void PrintAllocationReport(int fd) {
+  using impl::_SiteSnapshot;
+  auto &registry = impl::g_allocation_registry;
+
+  // Plain malloc, the report itself should not show up in the statistics.
+  auto *snapshots = static_cast<_SiteSnapshot *>(
+      calloc(impl::_AllocationRegistry::max_sites, sizeof(_SiteSnapshot)));
+  auto *order = static_cast<uint32_t *>(
+      malloc(impl::_AllocationRegistry::max_sites * sizeof(uint32_t)));
+  if (PDP_UNLIKELY(!snapshots || !order)) {
+    free(snapshots);
+    free(order);
+    return;
+  }
+
+  size_t num_snapshots = 0;
+  for (size_t i = 0; i < impl::_AllocationRegistry::max_sites; ++i) {
+    const impl::_AllocationSite &site = registry.sites[i];
+    const bool is_overflow = (i == impl::_AllocationRegistry::overflow_site);
+    if (!is_overflow && !site.is_ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+    if (site.allocations.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    const char *file = is_overflow ? "<other>" : site.file;
+    const int line = is_overflow ? 0 : site.line;
+
+    size_t j = 0;
+    while (j < num_snapshots &&
+           (snapshots[j].line != line || strcmp(snapshots[j].file, file) != 0)) {
+      ++j;
+    }
+    if (j == num_snapshots) {
+      snapshots[j].file = file;
+      snapshots[j].line = line;
+      order[j] = j;
+      ++num_snapshots;
+    }
+    impl::_AccumulateSite(snapshots[j], site);
+  }
+
+  // Insertion sort, descending by total bytes.
+  for (size_t i = 1; i < num_snapshots; ++i) {
+    uint32_t current = order[i];
+    size_t j = i;
+    while (j > 0 && snapshots[order[j - 1]].total_bytes < snapshots[current].total_bytes) {
+      order[j] = order[j - 1];
+      --j;
+    }
+    order[j] = current;
+  }
+
+  dprintf(fd, "Allocation report: live %ld bytes, peak %ld bytes, %zu sites\n",
+          static_cast<long>(registry.live_bytes.load()),
+          static_cast<long>(registry.peak_bytes.load()), num_snapshots);
+  dprintf(fd, "%12s %10s %10s %12s %12s %12s %12s  %s\n", "total_bytes", "allocs", "reallocs",
+          "live_allocs", "live_bytes", "peak_bytes", "avg_life_us", "site");
+  for (size_t i = 0; i < num_snapshots; ++i) {
+    const _SiteSnapshot &s = snapshots[order[i]];
+    const int64_t avg_lifetime_us =
+        s.deallocations > 0 ? s.lifetime_ns / s.deallocations / 1000 : 0;
+    dprintf(fd, "%12ld %10ld %10ld %12ld %12ld %12ld %12ld  %s:%d\n",
+            static_cast<long>(s.total_bytes), static_cast<long>(s.allocations),
+            static_cast<long>(s.reallocations),
+            static_cast<long>(s.allocations - s.deallocations), static_cast<long>(s.live_bytes),
+            static_cast<long>(s.peak_bytes), static_cast<long>(avg_lifetime_us), s.file, s.line);
+
+    dprintf(fd, "%12s sizes:", "");
+    for (size_t c = 0; c < impl::_AllocationSite::num_size_classes; ++c) {
+      if (s.size_classes[c] == 0) {
+        continue;
+      }
+      if (c + 1 == impl::_AllocationSite::num_size_classes) {
+        dprintf(fd, " >%zu:%ld", size_t(8) << c, static_cast<long>(s.size_classes[c]));
+      } else {
+        dprintf(fd, " <=%zu:%ld", size_t(16) << c, static_cast<long>(s.size_classes[c]));
+      }
+    }
+    dprintf(fd, "\n");
+  }
+
+  free(order);
+  free(snapshots);
+}
+
+}  // namespace pdp
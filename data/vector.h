@@ -5,6 +5,7 @@
 #include "non_copyable.h"
 
 #include <cstring>
+#include <new>
 #include <utility>
 
 namespace pdp {
@@ -129,6 +130,29 @@ struct Vector : public NonCopyable {
     ++size;
   }
 
+  /// @brief Constructs an element at @p index, shifting the following elements up by one.
+  template <typename... Args>
+  T &EmplaceAt(size_t index, Args &&...args) {
+    pdp_assert(index <= size);
+    ReserveFor(1);
+    memmove(static_cast<void *>(ptr + index + 1), ptr + index, (size - index) * sizeof(T));
+    new (ptr + index) T(std::forward<Args>(args)...);
+    ++size;
+    return ptr[index];
+  }
+
+  /// @brief Destroys the elements in [begin, end) and closes the gap.
+  void Erase(size_t begin, size_t end) {
+    pdp_assert(begin <= end && end <= size);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t i = begin; i < end; ++i) {
+        ptr[i].~T();
+      }
+    }
+    memmove(static_cast<void *>(ptr + begin), ptr + end, (size - end) * sizeof(T));
+    size -= end - begin;
+  }
+
   T *NewElement() {
     ReserveFor(1);
 
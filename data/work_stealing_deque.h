@@ -0,0 +1,109 @@
+#pragma once
+
+#include "allocator.h"
+#include "core/check.h"
+#include "non_copyable.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Chase-Lev deque of pointers with a fixed capacity.
+///
+/// The owner thread pushes and pops at the bottom (LIFO), any other thread may steal from the
+/// top (FIFO). Memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory
+/// Models" (Le, Pop, Cohen, Zappa Nardelli).
+template <typename T, typename Alloc = DefaultAllocator>
+struct WorkStealingDeque : public NonCopyableNonMovable {
+  static constexpr size_t cache_line_size = 64;
+
+  WorkStealingDeque(size_t power_of_two, Alloc alloc = Alloc()) : allocator(alloc) {
+    pdp_assert(power_of_two > 0);
+    pdp_assert((power_of_two & (power_of_two - 1)) == 0);
+
+    slots = Allocate<std::atomic<T *>>(allocator, power_of_two);
+    for (size_t i = 0; i < power_of_two; ++i) {
+      new (slots + i) std::atomic<T *>(nullptr);
+    }
+    mask = power_of_two - 1;
+    top.store(0, std::memory_order_relaxed);
+    bottom.store(0, std::memory_order_relaxed);
+  }
+
+  ~WorkStealingDeque() { Deallocate<std::atomic<T *>>(allocator, slots); }
+
+  // Owner side
+
+  bool Push(T *element) {
+    const int64_t b = bottom.load(std::memory_order_relaxed);
+    const int64_t t = top.load(std::memory_order_acquire);
+    if (PDP_UNLIKELY(static_cast<size_t>(b - t) > mask)) {
+      return false;
+    }
+    slots[b & mask].store(element, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  T *Pop() {
+    const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      // Empty.
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    T *element = slots[b & mask].load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last element, race against the thieves.
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        element = nullptr;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return element;
+  }
+
+  // Thief side
+
+  T *Steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+
+    T *element = slots[t & mask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+      // Lost the race against the owner or another thief.
+      return nullptr;
+    }
+    return element;
+  }
+
+  bool Empty() const {
+    return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<T *> *slots;
+  size_t mask;
+  Alloc allocator;
+
+  // Keep the index touched by thieves away from the one touched by the owner.
+  byte padding0[cache_line_size];
+  std::atomic<int64_t> top;
+  byte padding1[cache_line_size - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom;
+};
+
+}  // namespace pdp
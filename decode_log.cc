@@ -0,0 +1,43 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "core/binary_log.h"
+#include "strings/string_builder.h"
+
+// Renders a log written after StartBinaryLogging() as text.
+// Usage: decode_log [log file]
+
+static void WriteSlice(const pdp::StringSlice &str) {
+  pdp::WriteFully(STDOUT_FILENO, str.Data(), str.Size());
+}
+
+int main(int argc, char **argv) {
+  const char *filename = argc > 1 ? argv[1] : PDP_LOG_PATH;
+  int fd = open(filename, O_RDONLY);
+  if (PDP_UNLIKELY(fd < 0)) {
+    pdp_error("Failed to open {}!", pdp::StringSlice(filename));
+    return 1;
+  }
+
+  const size_t chunk = 64 * 1024;
+  pdp::StringBuilder<> log;
+  ssize_t ret = 0;
+  do {
+    char *buf = log.AppendUninitialized(chunk);
+    ret = read(fd, buf, chunk);
+    const size_t num_read = ret > 0 ? ret : 0;
+    if (num_read < chunk) {
+      log.Truncate(log.Size() - chunk + num_read);
+    }
+  } while (ret > 0);
+  close(fd);
+
+  pdp::StringBuilder<> text;
+  const bool okay = pdp::DecodeBinaryLog(log.ToSlice(), text);
+  WriteSlice(text.ToSlice());
+  if (!okay) {
+    WriteSlice("\e[31m\e[1m[decode_log] malformed or truncated record, stopping\e[0m\n");
+    return 1;
+  }
+  return 0;
+}
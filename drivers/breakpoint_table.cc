@@ -1,32 +1,44 @@
 #include "breakpoint_table.h"
-#include "system/file_descriptor.h"
-
-#include <linux/limits.h>
-#include <unistd.h>
 
 namespace pdp {
 
-Breakpoint::Breakpoint() : type(kUnknown), enabled(0), lnum(-1), extmark(0) {}
-
-BreakpointTable::BreakpointTable() : buffer(PATH_MAX + 1) {}
+Breakpoint::Breakpoint()
+    : fullname(PathTable::no_path), type(kUnknown), enabled(0), lnum(-1), extmark(0) {}
 
-FixedString BreakpointTable::RealPathFromSlice(const StringSlice &str) {
-  auto len = str.Size() < PATH_MAX ? str.Size() : PATH_MAX;
-  memcpy(buffer.Get(), str.Data(), len);
-  buffer[len] = '\0';
-  return RealPath(buffer.Get());
+BreakpointId ParseBreakpointId(const StringSlice &id) {
+  uint32_t parts[2] = {0, 0};
+  size_t part = 0;
+  for (size_t i = 0; i < id.Size(); ++i) {
+    const char c = id[i];
+    if (c == '.' && part == 0) {
+      part = 1;
+    } else if (PDP_LIKELY(c >= '0' && c <= '9')) {
+      parts[part] = parts[part] * 10 + (c - '0');
+    } else {
+      PDP_FMT_UNREACHABLE("Malformed breakpoint number: {}", id);
+    }
+  }
+  return MakeBreakpointId(parts[0], parts[1]);
 }
 
+BreakpointTable::BreakpointTable(PathProbeCache &c) : path_cache(c) {}
+
 BreakpointTable::InsertionResult BreakpointTable::Insert(GdbExprView bkpt, GdbExprView parent) {
-  StringSlice id = bkpt["number"].RequireStr();
-  auto [it, inserted] = table.Emplace(id);
-  Breakpoint *new_br = &it->value;
+  const BreakpointId id = ParseBreakpointId(bkpt["number"].RequireStr());
+  const size_t pos = LowerBound(id);
+  const bool inserted = pos == table.Size() || table[pos].key != id;
+  if (inserted) {
+    table.EmplaceAt(pos, id);
+  }
+  Breakpoint *new_br = &table[pos].value;
 
-  new_br->enabled = bkpt["enabled"].RequireInt();
+  new_br->enabled = (bkpt["enabled"] == "y");
   auto fullname = bkpt["fullname"];
   if (fullname) {
     new_br->lnum = bkpt["line"].RequireInt();
-    new_br->fullname.Reset(RealPathFromSlice(fullname.RequireStr()));
+    // Locations of a <MULTIPLE> breakpoint mostly share a handful of files.
+    const PathProbe &probe = path_cache.Probe(fullname.RequireStr());
+    new_br->fullname = g_path_table.Intern(probe.real_path.ToSlice());
   }
 
   auto type = bkpt["type"];
@@ -52,51 +64,58 @@ BreakpointTable::InsertionResult BreakpointTable::Insert(GdbExprView bkpt, GdbEx
   }
 
   if (parent) {
-    StringSlice parent_id = parent["id"].RequireStr();
     new_br->enabled = new_br->enabled && (parent["enabled"] == "y");
-
-    auto [aliases_it, _] = aliases.Emplace(parent_id);
-    aliases_it->value.MemCopy(id.Data(), id.Size());
-    aliases_it->value += '\0';
   }
-  return {it, inserted};
+  return {table.Begin() + pos, inserted};
 }
 
-void BreakpointTable::Delete(const StringSlice &id) {
-  auto aliases_it = aliases.Find(id);
-  if (aliases_it != aliases.End()) {
-    for (auto alias : aliases_it->value.SplitByNull()) {
-      auto table_it = table.Find(alias);
-      pdp_assert(table_it != table.End());
-      table.Erase(table_it);
-    }
-    aliases.Erase(aliases_it);
-  } else {
-    auto it = table.Find(id);
-    if (it != table.End()) {
-      table.Erase(it);
-    }
+void BreakpointTable::Delete(BreakpointId id) {
+  size_t begin, end;
+  GetRange(id, &begin, &end);
+  table.Erase(begin, end);
+}
+
+BreakpointTable::Aliases BreakpointTable::GetAliases(BreakpointId id) {
+  size_t begin, end;
+  GetRange(id, &begin, &end);
+  return Aliases(table.Begin() + begin, table.Begin() + end);
+}
+
+BreakpointTable::NoSuspendIterator BreakpointTable::Find(BreakpointId id) {
+  const size_t pos = LowerBound(id);
+  if (pos < table.Size() && table[pos].key == id) {
+    return NoSuspendIterator(table.Begin() + pos);
   }
+  return End();
 }
 
-BreakpointAliases BreakpointTable::GetAliases(const StringSlice &id) {
-  auto aliases_it = aliases.Find(id);
-  if (aliases_it != aliases.End()) {
-    return BreakpointAliases(&table, aliases_it->value);
-  } else {
-    auto table_it = table.Find(id);
-    if (table_it != table.End()) {
-      return BreakpointAliases(&table, table_it->key);
+BreakpointTable::NoSuspendIterator BreakpointTable::End() { return NoSuspendIterator(table.End()); }
+
+size_t BreakpointTable::LowerBound(BreakpointId id) const {
+  if (PDP_LIKELY(table.Empty() || table.Last().key < id)) {
+    return table.Size();
+  }
+  size_t lo = 0;
+  size_t hi = table.Size();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (table[mid].key < id) {
+      lo = mid + 1;
     } else {
-      return BreakpointAliases(&table);
+      hi = mid;
     }
   }
+  return lo;
 }
 
-BreakpointTable::NoSuspendIterator BreakpointTable::Find(const StringSlice &id) {
-  return NoSuspendIterator(table.Find(id));
+void BreakpointTable::GetRange(BreakpointId id, size_t *begin, size_t *end) const {
+  if (BreakpointMinor(id) != 0) {
+    *begin = LowerBound(id);
+    *end = *begin + (*begin < table.Size() && table[*begin].key == id);
+  } else {
+    *begin = LowerBound(id);
+    *end = LowerBound(MakeBreakpointId(BreakpointMajor(id) + 1));
+  }
 }
 
-BreakpointTable::NoSuspendIterator BreakpointTable::End() { return NoSuspendIterator(table.End()); }
-
 }  // namespace pdp
@@ -1,8 +1,11 @@
 #pragma once
 
-#include "external/emhash8.h"
+#include "data/memory_tags.h"
+#include "data/vector.h"
+#include "path_probe_cache.h"
 #include "parser/expr.h"
 #include "strings/fixed_string.h"
+#include "strings/path_table.h"
 #include "system/no_suspend_lock.h"
 
 namespace pdp {
@@ -22,7 +25,7 @@ struct Breakpoint {
 
   Breakpoint();
 
-  FixedString fullname;
+  PathId fullname;
   FixedString script;
   Type type;
   bool enabled;
@@ -33,60 +36,32 @@ struct Breakpoint {
 template <>
 struct CanReallocate<Breakpoint> : std::true_type {};
 
-struct BreakpointAliases {
-  using _Map = emhash8::StringMap<Breakpoint>;
+/// @brief GDB breakpoint number "major" or "major.minor", packed as (major << 32) | minor.
+///
+/// A breakpoint sorts before its locations, and the locations of one breakpoint are adjacent.
+using BreakpointId = uint64_t;
 
-  struct NoSuspendIterator {
-    NoSuspendIterator(_Map *t) : table(t), alias_it(NullTerminateSplit::Iterator::End()) {}
+inline BreakpointId MakeBreakpointId(uint32_t major, uint32_t minor = 0) {
+  return (static_cast<uint64_t>(major) << 32) | minor;
+}
 
-    NoSuspendIterator(_Map *t, NullTerminateSplit::Iterator it) : table(t), alias_it(it) {}
+inline uint32_t BreakpointMajor(BreakpointId id) { return id >> 32; }
+inline uint32_t BreakpointMinor(BreakpointId id) { return id & UINT32_MAX; }
 
-    static NoSuspendIterator End(_Map *t) { return NoSuspendIterator(t); }
+BreakpointId ParseBreakpointId(const StringSlice &id);
 
-    _Map::Entry &operator*() {
-      auto it = table->Find(*alias_it);
-      pdp_assert(it != table->End());
-      return *it;
-    }
-
-    NoSuspendIterator &operator++() {
-      ++alias_it;
-      return (*this);
-    }
-
-    bool operator==(const NoSuspendIterator &rhs) const {
-      pdp_assert(table == rhs.table);
-      return alias_it == rhs.alias_it;
-    }
-
-    bool operator!=(const NoSuspendIterator &rhs) const {
-      pdp_assert(table == rhs.table);
-      return alias_it != rhs.alias_it;
-    }
-
-   private:
-    _Map *table;
-    NullTerminateSplit::Iterator alias_it;
-    NoSuspendGuard suspend_guard;
-  };
+struct BreakpointEntry {
+  BreakpointEntry(BreakpointId k) : key(k) {}
 
-  BreakpointAliases(_Map *t, StringVector &v) : fwd_table(t), fwd_it(v.Begin(), v.End()) {}
-
-  BreakpointAliases(_Map *t, FixedString &f) : fwd_table(t), fwd_it(f.Begin(), f.End()) {}
-
-  BreakpointAliases(_Map *t) : fwd_table(t), fwd_it(NullTerminateSplit::Iterator::End()) {}
-
-  NoSuspendIterator begin() { return NoSuspendIterator(fwd_table, fwd_it); }
-
-  NoSuspendIterator end() { return NoSuspendIterator::End(fwd_table); }
-
- private:
-  _Map *fwd_table;
-  NullTerminateSplit::Iterator fwd_it;
+  BreakpointId key;
+  Breakpoint value;
 };
 
+template <>
+struct CanReallocate<BreakpointEntry> : std::true_type {};
+
 struct BreakpointTable : public NonCopyableNonMovable {
-  using _Entry = emhash8::StringMap<Breakpoint>::Entry;
+  using _Entry = BreakpointEntry;
 
   struct NoSuspendIterator : public NonMoveable {
     NoSuspendIterator(_Entry *it) : it(it) {}
@@ -118,24 +93,39 @@ struct BreakpointTable : public NonCopyableNonMovable {
     bool is_new;
   };
 
-  BreakpointTable();
+  /// @brief Contiguous run of entries, a breakpoint together with all of its locations.
+  struct Aliases {
+    Aliases(_Entry *b, _Entry *e) : first(b), last(e) {}
+
+    NoSuspendIterator begin() { return NoSuspendIterator(first); }
+    NoSuspendIterator end() { return NoSuspendIterator(last); }
+
+   private:
+    _Entry *first;
+    _Entry *last;
+  };
+
+  BreakpointTable(PathProbeCache &path_cache);
 
   InsertionResult Insert(GdbExprView bkpt, GdbExprView parent);
 
-  void Delete(const StringSlice &id);
+  /// @brief Deletes a single location "N.M", or breakpoint "N" together with all its locations.
+  void Delete(BreakpointId id);
 
-  BreakpointAliases GetAliases(const StringSlice &id);
+  /// @brief Same range as Delete() would remove.
+  Aliases GetAliases(BreakpointId id);
 
-  NoSuspendIterator Find(const StringSlice &id);
+  NoSuspendIterator Find(BreakpointId id);
 
   NoSuspendIterator End();
 
  private:
-  FixedString RealPathFromSlice(const StringSlice &str);
+  size_t LowerBound(BreakpointId id) const;
+  void GetRange(BreakpointId id, size_t *begin, size_t *end) const;
 
-  emhash8::StringMap<Breakpoint> table;
-  emhash8::StringMap<StringVector> aliases;
-  StringBuffer buffer;
+  // Sorted by key. GDB hands out increasing numbers, so insertion is almost always an append.
+  Vector<BreakpointEntry, TaggedAllocator<MemoryTag::kBreakpoints>> table;
+  PathProbeCache &path_cache;
 };
 
 }  // namespace pdp
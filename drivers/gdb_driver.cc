@@ -2,7 +2,10 @@
 
 #include "core/check.h"
 #include "core/log.h"
+#include "latency_stats.h"
 #include "parser/mi_parser.h"
+#include "tracing/execution_tracer.h"
+#include "tracing/span_tracer.h"
 
 #include <unistd.h>
 
@@ -179,6 +182,8 @@ GdbDriver::~GdbDriver() {
   }
 }
 
+void GdbDriver::WaitForRecords(Milliseconds timeout) { gdb_stdout.WaitForLine(timeout); }
+
 GdbRecordKind GdbDriver::PollForRecords(GdbRecord *res) {
   MutableLine line = gdb_stdout.ReadLine();
   if (PDP_LIKELY(line.Empty())) {
@@ -219,6 +224,7 @@ GdbRecordKind GdbDriver::PollForRecords(GdbRecord *res) {
     return res->SetResult(token, kind, results);
   } else if (PDP_LIKELY(IsAsyncMarker(marker))) {
     GdbAsyncKind kind = ClassifyAsync(StringSlice(name_begin, name_end));
+    PDP_TRACE_INSTANT("GdbAsyncRecord", static_cast<uint64_t>(kind));
     return res->SetAsync(kind, results);
   }
   return GdbRecordKind::kNone;
@@ -242,6 +248,7 @@ void GdbDriver::Send(uint32_t token, const StringSlice &fmt, PackedValue *args,
   builder.AppendPack(fmt, args, type_bits);
   builder.Append('\n');
 
+  g_latency_stats.OnCommandSent(token, fmt);
   bool success = gdb_stdin.WriteExactly(builder.Data(), builder.Size(), Milliseconds(1000));
   if (PDP_UNLIKELY(!success)) {
     pdp_warning("Failed to submit request {}", builder.ToSlice());
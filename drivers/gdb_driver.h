@@ -6,10 +6,9 @@
 #include "strings/rolling_buffer.h"
 #include "system/child_reaper.h"
 #include "system/file_descriptor.h"
-#include "tracing/execution_tracer.h"
+#include "system/process_spawn.h"
 
 #include <fcntl.h>
-#include <sys/prctl.h>
 #include <unistd.h>
 #include <csignal>
 
@@ -73,25 +72,16 @@ struct GdbDriver {
     CheckFatal(pipe2(out, O_CLOEXEC), "GDB pipe(out)");
     CheckFatal(pipe2(err, O_CLOEXEC), "GDB pipe(err)");
 
-    pid_t pid = g_recorder.SyscallFork();
-    CheckFatal(pid, "GDB fork");
-    if (pid == 0) {
-      // child: GDB
-      prctl(PR_SET_PDEATHSIG, SIGTERM);
+    SpawnActions actions;
+    actions.SetDeathSignal(SIGTERM);
+    actions.AddDup2(in[0], STDIN_FILENO);
+    actions.AddDup2(out[1], STDOUT_FILENO);
+    actions.AddDup2(err[1], STDERR_FILENO);
 
-      dup2(in[0], STDIN_FILENO);
-      dup2(out[1], STDOUT_FILENO);
-      dup2(err[1], STDERR_FILENO);
+    const char *const exec_argv[] = {path, argv..., nullptr};
+    pid_t pid = SpawnProcess(actions, path, exec_argv);
+    CheckFatal(pid, "GDB spawn");
 
-      close(in[1]);
-      close(out[0]);
-      close(err[0]);
-
-      execl(path, path, argv..., (char *)0);
-      _exit(127);
-    }
-
-    // parent
     close(in[0]);
     close(out[1]);
     close(err[1]);
@@ -123,7 +113,12 @@ struct GdbDriver {
   int GetDescriptor() const;
   int GetErrorDescriptor() const;
 
+  void WaitForRecords(Milliseconds timeout);
   GdbRecordKind PollForRecords(GdbRecord *res);
+  /// @brief ReadTsc() when the last polled record arrived, see RollingBuffer::LastReadTsc().
+  uint64_t LastRecordArrivalTsc() const { return gdb_stdout.LastReadTsc(); }
+  /// @brief GDB closed its stdout, no more records will arrive.
+  bool IsOutputClosed() const { return gdb_stdout.ReachedEnd(); }
   StringSlice PollForErrors();
 
  private:
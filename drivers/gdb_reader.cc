@@ -0,0 +1,87 @@
+#include "gdb_reader.h"
+
+#include "parser/mi_parser.h"
+#include "tracing/execution_tracer.h"
+
+#include <sched.h>
+
+namespace pdp {
+
+GdbParsedRecord::GdbParsedRecord(const StringSlice &msg)
+    : kind(GdbRecordKind::kStream), token(0), sub_kind(0), message(msg), arrival_tsc(0) {}
+
+GdbParsedRecord::GdbParsedRecord(GdbRecordKind k, const GdbRecord &record,
+                                 UniquePtr<ExprBase> e)
+    : kind(k),
+      token(record.result_or_async.token),
+      sub_kind(record.result_or_async.kind),
+      expr(std::move(e)),
+      arrival_tsc(0) {}
+
+GdbParsedRecord GdbParsedRecord::Exited() {
+  GdbParsedRecord record(StringSlice(""));
+  record.kind = GdbRecordKind::kNone;
+  return record;
+}
+
+GdbReader::GdbReader(GdbDriver &d) : driver(d), records(max_pending_records) {}
+
+GdbReader::~GdbReader() { Stop(); }
+
+void GdbReader::Start() {
+  pdp_assert(g_recorder.IsNormal());
+  thread.Start(ReaderLoop, this);
+}
+
+void GdbReader::Stop() { thread.Stop(); }
+
+int GdbReader::GetDescriptor() const { return wakeup.GetDescriptor(); }
+
+void GdbReader::AcknowledgeWakeup() { wakeup.Drain(); }
+
+GdbParsedRecord *GdbReader::Front() { return records.Front(); }
+
+void GdbReader::PopFront() { records.PopFront(); }
+
+void GdbReader::Publish(std::atomic_bool *is_running, GdbParsedRecord &&record) {
+  while (PDP_UNLIKELY(!records.TryEmplaceBack(std::move(record)))) {
+    // The main thread is behind. Make sure it is awake and wait for it to catch up.
+    wakeup.Notify();
+    if (!is_running->load(std::memory_order_relaxed)) {
+      return;
+    }
+    sched_yield();
+  }
+  wakeup.Notify();
+}
+
+void GdbReader::ReaderLoop(std::atomic_bool *is_running, GdbReader *reader) {
+  GdbDriver &driver = reader->driver;
+  ChainedArena<> scratch;
+  while (is_running->load(std::memory_order_relaxed)) {
+    driver.WaitForRecords(poll_timeout);
+
+    GdbRecord record;
+    GdbRecordKind kind = driver.PollForRecords(&record);
+    while (kind != GdbRecordKind::kNone) {
+      if (kind == GdbRecordKind::kStream) {
+        reader->Publish(is_running, GdbParsedRecord(record.stream.message));
+      } else {
+        UniquePtr<ExprBase> expr = ParseMiResults(record.result_or_async.results, scratch);
+        if (PDP_LIKELY(expr)) {
+          GdbParsedRecord parsed(kind, record, std::move(expr));
+          parsed.arrival_tsc = driver.LastRecordArrivalTsc();
+          reader->Publish(is_running, std::move(parsed));
+        }
+      }
+      kind = driver.PollForRecords(&record);
+    }
+    if (PDP_UNLIKELY(driver.IsOutputClosed())) {
+      // Polling a hung up pipe returns at once, staying in the loop would spin.
+      reader->Publish(is_running, GdbParsedRecord::Exited());
+      return;
+    }
+  }
+}
+
+}  // namespace pdp
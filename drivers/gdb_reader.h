@@ -0,0 +1,69 @@
+#pragma once
+
+#include "data/spsc_queue.h"
+#include "gdb_driver.h"
+#include "parser/expr.h"
+#include "strings/fixed_string.h"
+#include "system/thread.h"
+
+namespace pdp {
+
+/// @brief A GDB/MI record which was already parsed by the reader thread.
+struct GdbParsedRecord {
+  GdbParsedRecord(const StringSlice &msg);
+  GdbParsedRecord(GdbRecordKind kind, const GdbRecord &record, UniquePtr<ExprBase> expr);
+
+  GdbParsedRecord(GdbParsedRecord &&rhs) = default;
+
+  /// @brief The last record, of kind kNone, published once GDB closed its output.
+  static GdbParsedRecord Exited();
+
+  GdbRecordKind kind;
+  uint32_t token;
+  // GdbAsyncKind or GdbResultKind, depending on the kind of the record.
+  uint32_t sub_kind;
+  // Only set for stream records.
+  FixedString message;
+  // Only set for async and result records.
+  UniquePtr<ExprBase> expr;
+  // See GdbDriver::LastRecordArrivalTsc().
+  uint64_t arrival_tsc;
+};
+
+/// @brief Moves reading and parsing of GDB output to a dedicated thread.
+///
+/// Once started, the reader thread owns the stdout of the driver. Records are published in order
+/// through a lock-free ring and the descriptor returned by GetDescriptor() becomes readable. When
+/// GDB closes its output the thread publishes GdbParsedRecord::Exited() and stops reading.
+/// Only the main thread may call the consumer functions.
+///
+/// The thread bypasses the recording of ExecutionTracer, so it must only run in normal mode.
+struct GdbReader : public NonCopyableNonMovable {
+  GdbReader(GdbDriver &driver);
+  ~GdbReader();
+
+  void Start();
+  void Stop();
+
+  int GetDescriptor() const;
+
+  // Consumer side
+  void AcknowledgeWakeup();
+  GdbParsedRecord *Front();
+  void PopFront();
+
+ private:
+  static void ReaderLoop(std::atomic_bool *is_running, GdbReader *reader);
+
+  void Publish(std::atomic_bool *is_running, GdbParsedRecord &&record);
+
+  static constexpr size_t max_pending_records = 256;
+  static constexpr Milliseconds poll_timeout = 100_ms;
+
+  GdbDriver &driver;
+  SpscQueue<GdbParsedRecord> records;
+  EventDescriptor wakeup;
+  StoppableThread thread;
+};
+
+}  // namespace pdp
@@ -1,24 +1,22 @@
 #pragma once
 
-#include "strings/fixed_string.h"
+#include "data/vector.h"
+#include "strings/path_table.h"
 
 namespace pdp {
 
 struct JumpLocation {
-  JumpLocation(int k, int l, FixedString &&f) : key(k), jump_line(l), jump_file(std::move(f)) {}
+  JumpLocation(int k, int l, PathId f) : key(k), jump_line(l), jump_file(f) {}
 
   int key;
   int jump_line;
-  FixedString jump_file;
+  PathId jump_file;
 };
 
-template <>
-struct CanReallocate<JumpLocation> : std::true_type {};
-
 struct JumpTable {
-  void Insert(int key, const StringSlice &fullname, int lnum) {
+  void Insert(int key, PathId fullname, int lnum) {
     pdp_assert(jumps.Empty() || jumps.Last().key < key);
-    jumps.Emplace(key, lnum, FixedString(fullname));
+    jumps.Emplace(key, lnum, fullname);
   }
 
   JumpLocation &Find(int key) {
@@ -0,0 +1,146 @@
+#include "latency_stats.h"
+#include "core/clock.h"
+#include "core/log.h"
+
+#include <cstring>
+
+namespace pdp {
+
+LatencyStats g_latency_stats;
+
+static constexpr uint32_t no_verb = UINT32_MAX;
+
+static const char *const async_kind_names[] = {
+    "stopped",
+    "running",
+    "cmd-param-changed",
+    "breakpoint-created",
+    "breakpoint-deleted",
+    "breakpoint-modified",
+    "thread-created",
+    "thread-selected",
+    "thread-exited",
+    "thread-group-started",
+    "library-loaded",
+    "library-unloaded",
+    "unknown",
+};
+
+static_assert(sizeof(async_kind_names) / sizeof(async_kind_names[0]) ==
+              static_cast<size_t>(GdbAsyncKind::kUnknown) + 1);
+
+LatencyStats::LatencyStats() : num_unrendered{}, num_verbs(0), event_open(false) {
+  for (auto &command : pending) {
+    command.verb = no_verb;
+  }
+}
+
+void LatencyStats::BeginAsyncEvent(GdbAsyncKind kind, uint64_t arrival_tsc) {
+  EndAsyncEvent();
+  event_open = true;
+  event_kind = kind;
+  event_arrival_tsc = arrival_tsc;
+  event_last_write_tsc = 0;
+}
+
+void LatencyStats::EndAsyncEvent() {
+  if (!event_open) {
+    return;
+  }
+  event_open = false;
+  const size_t kind = static_cast<size_t>(event_kind);
+  if (event_last_write_tsc == 0) {
+    num_unrendered[kind] += 1;
+    return;
+  }
+  async_latency[kind].Record(TscTicksToNs(event_last_write_tsc - event_arrival_tsc));
+}
+
+void LatencyStats::OnRpcWritten() {
+  if (event_open) {
+    event_last_write_tsc = ReadTsc();
+  }
+}
+
+uint32_t LatencyStats::FindOrAddVerb(const StringSlice &verb) {
+  const size_t length = verb.Size() < max_verb_length ? verb.Size() : max_verb_length;
+  const StringSlice name(verb.Begin(), length);
+  for (uint32_t i = 0; i < num_verbs; ++i) {
+    if (name == StringSlice(verbs[i].name)) {
+      return i;
+    }
+  }
+  if (PDP_UNLIKELY(num_verbs >= other_verb)) {
+    // Named verbs never share the last slot, it is opened for the first one left out.
+    if (num_verbs == other_verb) {
+      strcpy(verbs[other_verb].name, "(other)");
+      num_verbs = max_verbs;
+    }
+    return other_verb;
+  }
+  memcpy(verbs[num_verbs].name, name.Begin(), name.Size());
+  verbs[num_verbs].name[name.Size()] = '\0';
+  return num_verbs++;
+}
+
+void LatencyStats::OnCommandSent(uint32_t token, const StringSlice &command) {
+  const char *space = command.MemChar(' ');
+  const StringSlice verb(command.Begin(), space ? space : command.End());
+  PendingCommand &slot = pending[token % max_pending_commands];
+  slot.token = token;
+  slot.verb = FindOrAddVerb(verb);
+  slot.sent_tsc = ReadTsc();
+}
+
+void LatencyStats::OnCommandResult(uint32_t token, uint64_t arrival_tsc) {
+  PendingCommand &slot = pending[token % max_pending_commands];
+  if (slot.verb == no_verb || slot.token != token) {
+    return;
+  }
+  if (PDP_LIKELY(arrival_tsc >= slot.sent_tsc)) {
+    verbs[slot.verb].round_trip.Record(TscTicksToNs(arrival_tsc - slot.sent_tsc));
+  }
+  slot.verb = no_verb;
+}
+
+const LatencyHistogram &LatencyStats::AsyncLatency(GdbAsyncKind kind) const {
+  return async_latency[static_cast<size_t>(kind)];
+}
+
+const LatencyHistogram *LatencyStats::RoundTrip(const StringSlice &verb) const {
+  for (uint32_t i = 0; i < num_verbs; ++i) {
+    if (verb == StringSlice(verbs[i].name)) {
+      return &verbs[i].round_trip;
+    }
+  }
+  return nullptr;
+}
+
+void LatencyStats::AppendReport(StringBuilder<> &out) const {
+  for (size_t i = 0; i < num_async_kinds; ++i) {
+    if (async_latency[i].Count() == 0 && num_unrendered[i] == 0) {
+      continue;
+    }
+    out.AppendFormat("*{} to last RPC: ", StringSlice(async_kind_names[i]));
+    async_latency[i].AppendSummary(out);
+    out.AppendFormat(" (no RPC {})\n", num_unrendered[i]);
+  }
+  for (uint32_t i = 0; i < num_verbs; ++i) {
+    out.AppendFormat("{} round trip: ", StringSlice(verbs[i].name));
+    verbs[i].round_trip.AppendSummary(out);
+    out.Append('\n');
+  }
+}
+
+void LatencyStats::LogReport() const {
+  StringBuilder<> report;
+  AppendReport(report);
+  if (report.Size() == 0) {
+    pdp_info("No latencies recorded");
+    return;
+  }
+  pdp_info("Latencies:");
+  pdp_info_multiline(report.ToSlice());
+}
+
+}  // namespace pdp
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "gdb_driver.h"
+#include "tracing/latency_histogram.h"
+
+namespace pdp {
+
+/// @brief Latencies of the GDB to Neovim pipeline. Main thread only.
+///
+/// An async record opens an event which lasts until the next async record or EndAsyncEvent(). The
+/// latency of an event is from the arrival of the record in the RollingBuffer until the last
+/// Neovim RPC written during the event, per GdbAsyncKind. Events which wrote nothing are only
+/// counted. GDB commands are timed from sending until the arrival of their result, per MI verb.
+struct LatencyStats {
+  LatencyStats();
+
+  void BeginAsyncEvent(GdbAsyncKind kind, uint64_t arrival_tsc);
+  void EndAsyncEvent();
+  void OnRpcWritten();
+
+  /// @param command The MI command, its verb is the text up to the first space.
+  void OnCommandSent(uint32_t token, const StringSlice &command);
+  void OnCommandResult(uint32_t token, uint64_t arrival_tsc);
+
+  const LatencyHistogram &AsyncLatency(GdbAsyncKind kind) const;
+  /// @return Null if no command of @p verb was sent.
+  const LatencyHistogram *RoundTrip(const StringSlice &verb) const;
+
+  /// @brief Appends one line per non empty histogram.
+  void AppendReport(StringBuilder<> &out) const;
+  void LogReport() const;
+
+ private:
+  static constexpr size_t num_async_kinds = static_cast<size_t>(GdbAsyncKind::kUnknown) + 1;
+  static constexpr size_t max_verbs = 16;
+  /// Reserved for the verbs which did not get a slot of their own.
+  static constexpr uint32_t other_verb = max_verbs - 1;
+  static constexpr size_t max_verb_length = 31;
+  static constexpr size_t max_pending_commands = 64;
+
+  struct VerbStats {
+    char name[max_verb_length + 1];
+    LatencyHistogram round_trip;
+  };
+
+  struct PendingCommand {
+    uint32_t token;
+    uint32_t verb;
+    uint64_t sent_tsc;
+  };
+
+  uint32_t FindOrAddVerb(const StringSlice &verb);
+
+  LatencyHistogram async_latency[num_async_kinds];
+  uint64_t num_unrendered[num_async_kinds];
+
+  VerbStats verbs[max_verbs];
+  uint32_t num_verbs;
+  /// Indexed by token modulo the size, older commands are forgotten.
+  PendingCommand pending[max_pending_commands];
+
+  bool event_open;
+  GdbAsyncKind event_kind;
+  uint64_t event_arrival_tsc;
+  uint64_t event_last_write_tsc;
+};
+
+extern LatencyStats g_latency_stats;
+
+}  // namespace pdp
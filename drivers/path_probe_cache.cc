@@ -0,0 +1,81 @@
+#include "path_probe_cache.h"
+#include "tracing/execution_tracer.h"
+
+#include <linux/limits.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace pdp {
+
+PathProbe::PathProbe() : readable(false) {}
+
+PathProbe::PathProbe(PathProbe &&rhs)
+    : real_path(std::move(rhs.real_path)), readable(rhs.readable), age(rhs.age) {}
+
+void PathProbe::Reset(PathProbe &&rhs) {
+  real_path.Reset(std::move(rhs.real_path));
+  readable = rhs.readable;
+  age = rhs.age;
+}
+
+PathProbeCache::PathProbeCache(Milliseconds t) : ttl(t) {}
+
+const PathProbe *PathProbeCache::Find(const StringSlice &path) const {
+  auto it = entries.Find(path);
+  if (it == entries.End() || !g_recorder.IsTimeLess(it->value.age.Elapsed(), ttl)) {
+    return nullptr;
+  }
+  return &it->value;
+}
+
+const PathProbe &PathProbeCache::Probe(const StringSlice &path) {
+  const PathProbe *probe = Find(path);
+  if (PDP_LIKELY(probe)) {
+    return *probe;
+  }
+  return Store(path, Resolve(path));
+}
+
+const PathProbe &PathProbeCache::Store(const StringSlice &path, PathProbe &&probe) {
+  probe.age.Reset();
+  if (PDP_UNLIKELY(entries.Size() >= max_entries) && entries.Find(path) == entries.End()) {
+    // Dropping everything also frees the keys, which erasing single entries would not.
+    entries.Clear();
+  }
+  auto [it, _] = entries.Emplace(path);
+  it->value.Reset(std::move(probe));
+  return it->value;
+}
+
+void PathProbeCache::Invalidate(const StringSlice &path) {
+  auto it = entries.Find(path);
+  if (it != entries.End()) {
+    entries.Erase(it);
+  }
+}
+
+void PathProbeCache::Clear() { entries.Clear(); }
+
+PathProbe PathProbeCache::Resolve(const StringSlice &path) {
+  char raw[PATH_MAX];
+  char absolute[PATH_MAX];
+
+  PathProbe probe;
+  if (PDP_UNLIKELY(path.Size() >= PATH_MAX)) {
+    probe.real_path.Reset(path);
+    return probe;
+  }
+  memcpy(raw, path.Data(), path.Size());
+  raw[path.Size()] = '\0';
+
+  if (realpath(raw, absolute)) {
+    probe.real_path.Reset(StringSlice(absolute, strlen(absolute)));
+    probe.readable = access(absolute, R_OK) == 0;
+  } else {
+    probe.real_path.Reset(path);
+  }
+  return probe;
+}
+
+}  // namespace pdp
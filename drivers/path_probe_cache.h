@@ -0,0 +1,63 @@
+#pragma once
+
+#include "external/emhash8.h"
+#include "strings/fixed_string.h"
+#include "system/time_units.h"
+
+namespace pdp {
+
+/// @brief Result of resolving a path on the filesystem.
+struct PathProbe {
+  PathProbe();
+  PathProbe(PathProbe &&rhs);
+
+  void Reset(PathProbe &&rhs);
+
+  // Canonical absolute path. The input path is kept as-is if it cannot be resolved.
+  FixedString real_path;
+  bool readable;
+  // Started when the probe was stored, compared to the TTL through the execution tracer.
+  Stopwatch age;
+};
+
+template <>
+struct CanReallocate<PathProbe> : std::true_type {};
+
+/// @brief Caches `realpath` and `access` results by the raw path string.
+///
+/// Source trees on network filesystems make every probe cost milliseconds and inotify does not
+/// report changes made by other NFS clients, so entries simply expire after a fixed TTL. Expiry
+/// goes through g_recorder.IsTimeLess(), so a replay takes the same decisions. The cache is emptied
+/// when it reaches `max_entries`, since the arena of its keys is only reclaimed that way.
+///
+/// Pointers and references returned by the cache are valid until it is modified.
+struct PathProbeCache : public NonCopyableNonMovable {
+  static constexpr Milliseconds default_ttl = 5000_ms;
+  static constexpr size_t max_entries = 4096;
+
+  PathProbeCache(Milliseconds ttl = default_ttl);
+
+  /// @brief Returns the cached probe or nullptr if the path is missing or stale.
+  const PathProbe *Find(const StringSlice &path) const;
+
+  /// @brief Returns the cached probe, resolving the path on this thread on a miss.
+  const PathProbe &Probe(const StringSlice &path);
+
+  /// @brief Inserts a probe obtained with Resolve(), possibly on another thread. May empty the
+  /// cache first, see `max_entries`.
+  const PathProbe &Store(const StringSlice &path, PathProbe &&probe);
+
+  void Invalidate(const StringSlice &path);
+  void Clear();
+
+  size_t Size() const { return entries.Size(); }
+
+  /// @brief Uncached lookup, safe to call from any thread.
+  static PathProbe Resolve(const StringSlice &path);
+
+ private:
+  Milliseconds ttl;
+  emhash8::ArenaStringMap<PathProbe> entries;
+};
+
+}  // namespace pdp
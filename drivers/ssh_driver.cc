@@ -2,12 +2,13 @@
 
 #include <fcntl.h>
 #include <sys/poll.h>
-#include <sys/prctl.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include "core/log.h"
 #include "system/file_descriptor.h"
-#include "tracing/execution_tracer.h"
+#include "system/process_spawn.h"
+
+#include <csignal>
 
 namespace pdp {
 
@@ -114,30 +115,17 @@ void SshDriver::SpawnChildAt(const StringSlice &command, size_t pos) {
   CheckFatal(pipe2(out, O_CLOEXEC), "SSH stdout pipe");
   CheckFatal(pipe2(err, O_CLOEXEC), "SSH stderr pipe");
 
-  pid_t pid = g_recorder.SyscallFork();
-  CheckFatal(pid, "SSH fork");
-
-  if (pid == 0) {
-    // child
-    prctl(PR_SET_PDEATHSIG, SIGTERM);
-
-    int devnull = open("/dev/null", O_RDONLY);
-    dup2(devnull, STDIN_FILENO);
-    close(devnull);
+  SpawnActions actions;
+  actions.SetDeathSignal(SIGTERM);
+  actions.AddOpen(STDIN_FILENO, "/dev/null", O_RDONLY);
+  actions.AddDup2(out[1], STDOUT_FILENO);
+  actions.AddDup2(err[1], STDERR_FILENO);
 
-    dup2(out[1], STDOUT_FILENO);
-    close(out[0]);
-    close(out[1]);
-
-    dup2(err[1], STDERR_FILENO);
-    close(err[0]);
-    close(err[1]);
-
-    execlp("ssh", "ssh", "-o", "ConnectTimeout=1", host.Cstr(), command.Data(), (char *)NULL);
-    _exit(127);
-  }
+  const char *const argv[] = {
+      "ssh", "-o", "ConnectTimeout=1", host.Cstr(), command.Data(), nullptr};
+  pid_t pid = SpawnProcessInPath(actions, "ssh", argv);
+  CheckFatal(pid, "SSH spawn");
 
-  // parent
   close(out[1]);
   close(err[1]);
 
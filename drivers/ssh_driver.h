@@ -2,6 +2,7 @@
 
 #include "data/allocator.h"
 #include "data/loop_queue.h"
+#include "data/memory_tags.h"
 #include "data/non_copyable.h"
 #include "data/small_capture.h"
 
@@ -35,7 +36,7 @@ struct SshDriver : public NonCopyableNonMovable {
     static_cast<SshDriver *>(user_data)->OnChildExited(pid, status);
   }
 
-  DefaultAllocator allocator;
+  TaggedAllocator<MemoryTag::kSsh> allocator;
 
   struct PendingOperation {
     PendingOperation(FixedString request) : request(std::move(request)) {}
@@ -44,7 +45,7 @@ struct SshDriver : public NonCopyableNonMovable {
     Capture callback;
   };
 
-  LoopQueue<PendingOperation> pending_queue;
+  LoopQueue<PendingOperation, TaggedAllocator<MemoryTag::kSsh>> pending_queue;
 
   struct ActiveOperation {
     ActiveOperation() : pid(-1) {}
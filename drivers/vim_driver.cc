@@ -1,5 +1,6 @@
 #include "vim_driver.h"
 
+#include "latency_stats.h"
 #include "parser/rpc_parser.h"
 
 namespace pdp {
@@ -36,6 +37,7 @@ void VimDriver::SendBytes(const void *bytes, size_t num_bytes) {
   if (PDP_UNLIKELY(!success)) {
     PDP_UNREACHABLE("Failed to send RPC request to VIM!");
   }
+  g_latency_stats.OnRpcWritten();
 }
 
 bool VimDriver::ReadBool() { return ReadRpcBoolean(vim_output); }
@@ -60,6 +62,9 @@ VimRpcEvent VimDriver::PollRpcEvent() {
       return VimRpcEvent(token);
     } else if (PDP_LIKELY(length == 3 && type == 2)) {
       return VimRpcEvent(VimRpcEvent::kNotify);
+    } else if (length == 4 && type == 0) {
+      const int64_t msgid = ReadRpcInteger(vim_output);
+      return VimRpcEvent(VimRpcEvent::kRequest, msgid);
     } else {
       PDP_FMT_UNREACHABLE("Unknown Vim RPC event type, length={} type={}", length, type);
     }
@@ -11,10 +11,11 @@ namespace pdp {
 FixedString Join(pdp::PackedValue *slots, uint64_t num_slots, uint64_t type_bits);
 
 struct VimRpcEvent {
-  enum Type { kNone, kResponse, kNotify };
+  enum Type { kNone, kResponse, kNotify, kRequest };
 
   VimRpcEvent(Type t) : type(static_cast<uint32_t>(t)) {}
   VimRpcEvent(uint32_t t) : type(kResponse), token(t) {}
+  VimRpcEvent(Type t, uint32_t msgid) : type(static_cast<uint32_t>(t)), token(msgid) {}
 
   operator bool() const { return type != kNone; }
 
@@ -22,8 +23,11 @@ struct VimRpcEvent {
 
   bool IsResponse() const { return type == kResponse; }
 
+  bool IsRequest() const { return type == kRequest; }
+
+  /// @brief The token of a response, or the msgid to answer a request with.
   uint32_t GetToken() const {
-    pdp_assert(type == kResponse);
+    pdp_assert(type == kResponse || type == kRequest);
     return token;
   }
 
@@ -49,11 +53,11 @@ struct VimDriver {
   uint32_t SendRpcRequest(const StringSlice &method, Args &&...args) {
     static_assert((IsRpcV<std::decay_t<Args>> && ...));
 
-#if PDP_TRACE_RPC_TOKENS
-    auto packed_args = MakePackedUnknownArgs(std::forward<Args>(args)...);
-    auto args_as_str = Join(packed_args.slots, packed_args.kNumSlots, packed_args.type_bits);
-    pdp_trace("Request, token={}: {}({})", token, method, args_as_str.ToSlice());
-#endif
+    if (PDP_TRACE_ENABLED(kRpcTokens)) {
+      auto packed_args = MakePackedUnknownArgs(std::forward<Args>(args)...);
+      auto args_as_str = Join(packed_args.slots, packed_args.kNumSlots, packed_args.type_bits);
+      pdp_trace_in(kRpcTokens, "Request, token={}: {}({})", token, method, args_as_str.ToSlice());
+    }
     RpcBuilder builder(token, method);
     builder.OpenShortArray();
     (builder.Add(std::forward<Args>(args)), ...);
@@ -66,11 +70,11 @@ struct VimDriver {
 
   template <typename... Args>
   uint32_t BeginRpcRequest(RpcBuilder &builder, const StringSlice &method, Args &&...args) {
-#if PDP_TRACE_RPC_TOKENS
-    auto packed_args = MakePackedUnknownArgs(std::forward<Args>(args)...);
-    auto args_as_str = Join(packed_args.slots, packed_args.kNumSlots, packed_args.type_bits);
-    pdp_trace("Request, token={}: {}({})", token, method, args_as_str.ToSlice());
-#endif
+    if (PDP_TRACE_ENABLED(kRpcTokens)) {
+      auto packed_args = MakePackedUnknownArgs(std::forward<Args>(args)...);
+      auto args_as_str = Join(packed_args.slots, packed_args.kNumSlots, packed_args.type_bits);
+      pdp_trace_in(kRpcTokens, "Request, token={}: {}({})", token, method, args_as_str.ToSlice());
+    }
     builder.Restart(token, method);
     builder.OpenShortArray();
     (builder.Add(std::forward<Args>(args)), ...);
@@ -83,6 +87,12 @@ struct VimDriver {
     SendBytes(data, size);
   }
 
+  /// @brief Sends a response started with RpcBuilder::RestartResponse().
+  void SendRpcResponse(RpcBuilder &builder) {
+    auto [data, size] = builder.Finish();
+    SendBytes(data, size);
+  }
+
   // Read RPC response methods
 
   bool ReadBool();
@@ -31,6 +31,7 @@
 #include "core/internals.h"
 #include "core/log.h"
 #include "data/allocator.h"
+#include "data/arena.h"
 #include "data/non_copyable.h"
 
 #include <cstdint>
@@ -55,7 +56,19 @@ struct Hash;
 
 namespace emhash8 {
 
-template <typename _K, typename K, typename V>
+/// @brief Hashes each key with the pdp::Hash specialization for its type.
+struct DefaultHasher {
+  template <typename T>
+  uint64_t operator()(const T &key) const {
+    return pdp::Hash<T>()(key);
+  }
+};
+
+/// @brief Hash map with stored keys of type K, looked up by keys of type _K.
+///
+/// H is called with both K and _K and must return the same hash for equal keys.
+template <typename _K, typename K, typename V, typename H = DefaultHasher,
+          typename A = pdp::DefaultAllocator>
 class Map3 : public pdp::NonCopyable {
  protected:
   struct Index {
@@ -81,7 +94,8 @@ class Map3 : public pdp::NonCopyable {
   static_assert(std::is_nothrow_destructible_v<Entry>, "K and V must be noexcept destructible");
   static_assert(pdp::CanReallocate<K>::value && pdp::CanReallocate<V>::value,
                 "K and V must be movable with realloc");
-  static_assert(std::is_invocable_v<const pdp::Hash<K>, K>, "Hash function missing for K");
+  static_assert(std::is_invocable_v<const H, const K &> && std::is_invocable_v<const H, const _K &>,
+                "Hash function missing for K");
 
   constexpr static float EMH_DEFAULT_LOAD_FACTOR = 0.80f;
   constexpr static float EMH_MIN_LOAD_FACTOR = 0.25f;
@@ -153,7 +167,7 @@ class Map3 : public pdp::NonCopyable {
   Entry *EmplaceUnchecked(KeyType &&key, Types &&...args) {
     CheckExpandNeed();
     const _K &key_view = static_cast<_K>(key);
-    const uint64_t key_hash = _hasher(key_view);
+    const uint64_t key_hash = hasher(key_view);
     uint32_t bucket = FindUniqueBucket(key_hash);
     uint32_t slot = _num_filled;
     EMH_NEW(std::forward<KeyType>(key), std::forward<Types>(args), bucket, key_hash);
@@ -165,7 +179,7 @@ class Map3 : public pdp::NonCopyable {
     CheckExpandNeed();
 
     _K key_view = static_cast<_K>(key);
-    const uint64_t key_hash = _hasher(key_view);
+    const uint64_t key_hash = hasher(key_view);
     const uint32_t bucket = FindOrAllocate(key_view, key_hash);
     const bool bempty = EMH_EMPTY(bucket);
     if (bempty) {
@@ -369,7 +383,7 @@ class Map3 : public pdp::NonCopyable {
 
   // Find the slot with this key, or return bucket size
   uint32_t FindFilledSlot(const _K &key) const {
-    const uint64_t key_hash = _hasher(key);
+    const uint64_t key_hash = hasher(key);
     const uint32_t bucket = uint32_t(key_hash & _mask);
     uint32_t next_bucket = _index[bucket].next;
     if ((int)next_bucket < 0) {
@@ -584,15 +598,119 @@ class Map3 : public pdp::NonCopyable {
   uint32_t _last;
   uint32_t _etail;
 
-  pdp::Hash<K> hasher;
-  pdp::Hash<_K> _hasher;
-  pdp::DefaultAllocator allocator;
+  H hasher;
+  A allocator;
+};
+
+template <typename V, typename H = DefaultHasher>
+using StringMap = Map3<pdp::StringSlice, pdp::FixedString, V, H>;
+
+template <typename K, typename V, typename H = DefaultHasher, typename A = pdp::DefaultAllocator>
+using Map = Map3<K, K, V, H, A>;
+
+/// @brief Key of ArenaStringMap. Points into the arena of the map, which never moves.
+///
+/// The full hash and the first 8 characters are kept next to the pointer, so most mismatches are
+/// rejected without touching the arena.
+struct ArenaKey {
+  pdp::StringSlice ToSlice() const { return pdp::StringSlice(ptr, size); }
+  const char *Cstr() const { return ptr; }
+  uint32_t Size() const { return size; }
+
+  bool operator==(const pdp::StringSlice &rhs) const {
+    if (size != rhs.Size() || prefix != LoadPrefix(rhs.Begin(), size)) {
+      return false;
+    }
+    return size <= sizeof(prefix) ||
+           memcmp(ptr + sizeof(prefix), rhs.Begin() + sizeof(prefix), size - sizeof(prefix)) == 0;
+  }
+
+  static uint64_t LoadPrefix(const char *str, size_t n) {
+    uint64_t res = 0;
+    memcpy(&res, str, n < sizeof(res) ? n : sizeof(res));
+    return res;
+  }
+
+  const char *ptr;
+  uint32_t size;
+  uint32_t hash;
+  uint64_t prefix;
+};
+
+namespace impl {
+
+// Keys already in the arena carry their hash.
+template <typename H>
+struct _ArenaKeyHasher : private H {
+  uint64_t operator()(const ArenaKey &key) const { return key.hash; }
+  uint64_t operator()(const pdp::StringSlice &key) const { return H::operator()(key); }
 };
 
-template <typename V>
-using StringMap = Map3<pdp::StringSlice, pdp::FixedString, V>;
+}  // namespace impl
+
+/// @brief StringMap which copies keys into an append-only arena instead of a FixedString each.
+///
+/// Inserting a new key is a bump allocation and a rehash never recomputes string hashes. Lookup is
+/// by StringSlice. Space of erased keys is only reclaimed by Clear().
+template <typename V, typename H = DefaultHasher>
+class ArenaStringMap : public Map3<pdp::StringSlice, ArenaKey, V, impl::_ArenaKeyHasher<H>> {
+  using Base = Map3<pdp::StringSlice, ArenaKey, V, impl::_ArenaKeyHasher<H>>;
+  using Base::_etail;
+  using Base::hasher;
+  using Base::_index;
+  using Base::_mask;
+  using Base::_num_filled;
+  using Base::_pairs;
+
+ public:
+  using Entry = typename Base::Entry;
+  using EmplaceResult = typename Base::EmplaceResult;
+
+  static constexpr size_t first_arena_block = 4096;
 
-template <typename K, typename V>
-using Map = Map3<K, K, V>;
+  ArenaStringMap(uint32_t bucket = 2) : Base(bucket), arena(first_arena_block) {}
+
+  template <typename... Types>
+  Entry *EmplaceUnchecked(const pdp::StringSlice &key, Types &&...args) {
+    this->CheckExpandNeed();
+    const uint64_t key_hash = hasher(key);
+    uint32_t bucket = this->FindUniqueBucket(key_hash);
+    uint32_t slot = _num_filled;
+    ArenaKey stored = StoreKey(key, key_hash);
+    EMH_NEW(stored, std::forward<Types>(args), bucket, key_hash);
+    return _pairs + slot;
+  }
+
+  template <typename... Types>
+  EmplaceResult Emplace(const pdp::StringSlice &key, Types &&...args) {
+    this->CheckExpandNeed();
+    const uint64_t key_hash = hasher(key);
+    const uint32_t bucket = this->FindOrAllocate(key, key_hash);
+    const bool bempty = EMH_EMPTY(bucket);
+    if (bempty) {
+      ArenaKey stored = StoreKey(key, key_hash);
+      EMH_NEW(stored, std::forward<Types>(args), bucket, key_hash);
+    }
+
+    const uint32_t slot = _index[bucket].slot & _mask;
+    return {_pairs + slot, bempty};
+  }
+
+  void Clear() {
+    Base::Clear();
+    arena.Reset();
+  }
+
+ private:
+  ArenaKey StoreKey(const pdp::StringSlice &key, uint64_t key_hash) {
+    char *ptr = static_cast<char *>(arena.Allocate(key.Size() + 1));
+    memcpy(ptr, key.Begin(), key.Size());
+    ptr[key.Size()] = '\0';
+    return ArenaKey{ptr, static_cast<uint32_t>(key.Size()), static_cast<uint32_t>(key_hash),
+                    ArenaKey::LoadPrefix(key.Begin(), key.Size())};
+  }
+
+  pdp::ChainedArena<> arena;
+};
 
 }  // namespace emhash8
@@ -7,6 +7,7 @@
 #include <unistd.h>
 #include <cstring>
 
+#include "core/ring_log.h"
 #include "data/vector.h"
 #include "external/emhash8.h"
 #include "strings/fixed_string.h"
@@ -276,6 +277,95 @@ bool RedirectInput() {
   return true;
 }
 
+constexpr int max_function_length = 120;
+constexpr bool enable_inlining = true;
+
+/// @brief Prints the line [begin, end), which ends with a new line, with its address resolved.
+void ProcessLine(char *begin, char *end, emhash8::StringMap<FileSymbolResolver> &resolver_map) {
+  const pdp::StringSlice line(begin, end);
+  auto [exe, addr] = SplitExecutableAndAddress(begin, end - 1);
+  if (!exe.Empty() && !addr.Empty()) {
+    auto it = resolver_map.Find(exe);
+    if (it == resolver_map.End()) {
+      const char *hm = exe.Data();
+      it = resolver_map.EmplaceUnchecked(exe, hm, max_function_length, enable_inlining);
+    }
+    const auto &source_lines = it->value.Resolve(addr);
+    pdp::StringBuilder builder;
+    for (size_t i = 0; i < source_lines.Size(); ++i) {
+      it->value.Format(source_lines[i], builder);
+      builder.Append("\n");
+    }
+    if (!source_lines.Empty()) {
+      WriteSlice(builder.ToSlice());
+    } else {
+      WriteSlice(line);
+    }
+  } else {
+    WriteSlice(line);
+  }
+}
+
+/// @brief Prints a log written by RedirectLoggingToRing(), from its oldest line, until the writer
+/// lets go of the file.
+int FollowRing(pdp::RingLogReader &reader, emhash8::StringMap<FileSymbolResolver> &resolver_map) {
+  pdp::StringBuilder<> pending;
+  pdp::StringBuilder<> chunk;
+  bool writer_gone = false;
+  uint32_t session = reader.session;
+  while (true) {
+    chunk.Clear();
+    const uint64_t lost = pdp::ReadRingLog(reader, writer_gone, chunk);
+    pdp::StringSlice fresh = chunk.ToSlice();
+    if (reader.session != session) {
+      // The unfinished line belonged to the previous session.
+      session = reader.session;
+      WriteSlice(pending.ToSlice());
+      pending.Clear();
+      WriteSlice("\n\e[33m\e[1m[follow_log] a new session started\e[0m\n");
+    }
+    if (lost > 0) {
+      // The partial line is gone, resume at the next complete one.
+      pending.Clear();
+      const char *next_line = fresh.MemChar('\n');
+      fresh.DropLeft(next_line ? next_line + 1 : fresh.End());
+      pdp::StringBuilder builder;
+      builder.AppendFormat("\e[33m\e[1m[follow_log] {} bytes overwritten\e[0m\n", lost);
+      WriteSlice(builder.ToSlice());
+    }
+    pending.Append(fresh);
+
+    // Lines are cut in place by SplitExecutableAndAddress(), the builder owns the bytes.
+    char *begin = const_cast<char *>(pending.Data());
+    char *end = begin + pending.Size();
+    char *line = begin;
+    for (char *it = line; it < end; ++it) {
+      if (*it == '\n') {
+        ProcessLine(line, it + 1, resolver_map);
+        line = it + 1;
+      }
+    }
+    if (line > begin) {
+      pdp::StringBuilder<> rest;
+      rest.Append(pdp::StringSlice(line, end));
+      pending.Clear();
+      pending.Append(rest.ToSlice());
+    }
+
+    if (writer_gone) {
+      WriteSlice(pending.ToSlice());
+      return 0;
+    }
+    if (fresh.Empty()) {
+      // Once the lock is ours, one last read picks up whatever the writer left.
+      writer_gone = pdp::LockLogFile(reader.fd);
+      if (!writer_gone) {
+        usleep(50'000);
+      }
+    }
+  }
+}
+
 int main() {
   prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY);
 
@@ -284,8 +374,6 @@ int main() {
     return 1;
   }
 
-  const int max_function_length = 120;
-  const bool enable_inlining = true;
   emhash8::StringMap<FileSymbolResolver> resolver_map;
 
   int fd = open(PDP_LOG_PATH, O_RDONLY, 0644);
@@ -294,6 +382,11 @@ int main() {
     return 1;
   }
 
+  pdp::RingLogReader reader;
+  if (pdp::OpenRingLog(fd, reader)) {
+    return FollowRing(reader, resolver_map);
+  }
+
   pdp::RollingBuffer input;
   input.SetDescriptor(fd);
 
@@ -307,28 +400,7 @@ int main() {
         continue;
       }
     }
-
-    auto [exe, addr] = SplitExecutableAndAddress(line.Begin(), line.End() - 1);
-    if (!exe.Empty() && !addr.Empty()) {
-      auto it = resolver_map.Find(exe);
-      if (it == resolver_map.End()) {
-        const char *hm = exe.Data();
-        it = resolver_map.EmplaceUnchecked(exe, hm, max_function_length, enable_inlining);
-      }
-      const auto &source_lines = it->value.Resolve(addr);
-      pdp::StringBuilder builder;
-      for (size_t i = 0; i < source_lines.Size(); ++i) {
-        it->value.Format(source_lines[i], builder);
-        builder.Append("\n");
-      }
-      if (!source_lines.Empty()) {
-        WriteSlice(builder.ToSlice());
-      } else {
-        WriteSlice(line.ToSlice());
-      }
-    } else {
-      WriteSlice(line.ToSlice());
-    }
+    ProcessLine(line.Begin(), line.End(), resolver_map);
   }
 
   return 0;
@@ -1,34 +1,97 @@
 #include "core/log.h"
 #include "coroutines/debug_coordinator.h"
+#include "data/memory_tags.h"
+#include "drivers/latency_stats.h"
+#include "system/async_log.h"
 #include "system/poll_table.h"
+#include "tracing/branch_profile.h"
+#include "tracing/span_tracer.h"
+#include "tracing/tracing_counter.h"
 
 #include <sys/prctl.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
 
 using pdp::operator""_ms;
 using pdp::g_recorder;
 
-void ApplicationMain() {
+static bool HasArgument(int argc, char **argv, const char *arg) {
+  for (int i = 1; i < argc; ++i) {
+    if (pdp::StringSlice(argv[i]) == arg) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char *ArgumentValue(int argc, char **argv, const char *arg) {
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (pdp::StringSlice(argv[i]) == arg) {
+      return argv[i + 1];
+    }
+  }
+  return nullptr;
+}
+
+#ifdef PDP_DEBUG_BUILD
+/// @brief Parses the megabytes of --ring-log, zero if @p str is not a number in [1, 4096].
+static size_t ParseRingMegabytes(const char *str) {
+  constexpr unsigned long max_megabytes = 4096;
+  char *end = nullptr;
+  errno = 0;
+  const unsigned long megabytes = strtoul(str, &end, 10);
+  if (errno != 0 || end == str || *end != '\0' || *str == '-' || megabytes > max_megabytes) {
+    return 0;
+  }
+  return megabytes;
+}
+#endif
+
+void ApplicationMain(bool gdb_reader_thread) {
   pdp_info("Setting up SIGCHLD handler");
   pdp::ChildReaper reaper;
 
   pdp_info("Starting coordinator");
   pdp::StringSlice host("");
   pdp::DebugCoordinator coordinator(host, pdp::DuplicateForThisProcess(STDOUT_FILENO),
-                                    pdp::DuplicateForThisProcess(STDIN_FILENO), reaper);
+                                    pdp::DuplicateForThisProcess(STDIN_FILENO), reaper,
+                                    gdb_reader_thread);
 
   pdp::PollTable poller;
   pdp_info("Polling until idle state is reached");
 
+  // A line of memory usage every two seconds, also available with the pdp/stats request. Timed
+  // through g_recorder like the loop itself, so a replay logs the same reports.
+  constexpr pdp::Milliseconds memory_report_period = 2000_ms;
+  pdp::Stopwatch memory_report_stopwatch;
+
   pdp::Stopwatch stopwatch;
   while (g_recorder.IsTimeLess(stopwatch.Elapsed(), 5000_ms)) {
     // Poll file descriptors
     coordinator.RegisterForPoll(poller);
-    poller.Poll(pdp::Milliseconds(100));
+    if (!poller.Poll(pdp::Milliseconds(100))) {
+      // Idle, whatever the last GDB event triggered was written.
+      pdp::g_latency_stats.EndAsyncEvent();
+    }
     coordinator.OnPollResults(poller);
     poller.Reset();
     // Check for exited children.
     reaper.Reap();
+    // Export spans and counters if SIGUSR1 arrived.
+    pdp::CheckTraceExportRequest(PDP_TRACE_PATH);
+    pdp::CheckTracingCountersRequest(PDP_COUNTERS_PATH);
+    if (!g_recorder.IsTimeLess(memory_report_stopwatch.Elapsed(), memory_report_period)) {
+      pdp::LogMemoryReport();
+      memory_report_stopwatch.Reset();
+    }
   }
+  pdp::g_latency_stats.EndAsyncEvent();
+  pdp::g_latency_stats.LogReport();
+  pdp::LogMemoryReport();
+#ifdef PDP_TRACE_BRANCH
+  pdp::LogBranchProfile();
+#endif
   pdp_info("Done! Exitting ApplicationMain()...");
 }
 
@@ -39,21 +102,74 @@ int main(int argc, char **argv) {
 
   // TODO for Release logging not working
 
+  // Replays a recording in any build, this is how the PGO build is trained.
+  const char *replay_file = ArgumentValue(argc, argv, "--replay-file");
+  if (replay_file) {
+    g_recorder.StartReplaying(replay_file);
+  }
+
 #ifdef PDP_DEBUG_BUILD
   if (argc > 2 && pdp::StringSlice(argv[2]) == "--output") {
     pdp::RedirectLogging(pdp::DuplicateForThisProcess(STDOUT_FILENO));
+  } else if (const char *ring_mb = ArgumentValue(argc, argv, "--ring-log")) {
+    // Bounded log for long sessions, holds the last <ring_mb> megabytes.
+    const size_t megabytes = ParseRingMegabytes(ring_mb);
+    if (megabytes == 0) {
+      pdp::RedirectLogging(PDP_LOG_PATH);
+      pdp_error("Invalid --ring-log {}, expected megabytes between 1 and 4096",
+                pdp::StringSlice(ring_mb));
+      return 1;
+    }
+    pdp::RedirectLoggingToRing(PDP_LOG_PATH, megabytes << 20);
   } else {
     pdp::RedirectLogging(PDP_LOG_PATH);
   }
 
-  if (argc > 1 && pdp::StringSlice(argv[1]) == "--replay") {
+  if (replay_file) {
+    // Already replaying.
+  } else if (argc > 1 && pdp::StringSlice(argv[1]) == "--replay") {
     g_recorder.StartReplaying();
   } else {
     g_recorder.StartRecording();
   }
 #endif
 
-  ApplicationMain();
+  // Trace categories can also be switched with the pdp/trace notification.
+  if (const char *trace = getenv("PDP_TRACE")) {
+    pdp::SetTraceCategories(trace);
+  }
+
+  if (HasArgument(argc, argv, "--binary-log")) {
+    if (pdp::IsRingLogging()) {
+      pdp_warning("Binary logging does not work with --ring-log, ignored");
+    } else {
+      pdp::StartBinaryLogging();
+    }
+  }
+  const bool async_log = HasArgument(argc, argv, "--async-log");
+  if (async_log) {
+    pdp::StartAsyncLogging(pdp::LogOverflow::kDrop);
+  }
+
+  // SA_RESTART so that the signal does not cut a write to vim or gdb short.
+  struct sigaction sa;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  sa.sa_handler = [](int) {
+    pdp::RequestTraceExport();
+    pdp::RequestTracingCounters();
+  };
+  pdp::CheckFatal(sigaction(SIGUSR1, &sa, nullptr), "SIGUSR1: sigaction");
+
+  ApplicationMain(HasArgument(argc, argv, "--gdb-reader-thread"));
+
+  if (HasArgument(argc, argv, "--export-trace")) {
+    pdp::ExportChromeTrace(PDP_TRACE_PATH);
+  }
+
+  if (async_log) {
+    pdp::StopAsyncLogging();
+  }
 
   g_recorder.CheckForEndOfStream();
   g_recorder.Stop();
@@ -1,7 +1,5 @@
 #include "expr.h"
 
-#include "external/ankerl_hash.h"
-
 namespace pdp {
 
 ExprBaseView::operator bool() const { return expr != nullptr; }
@@ -31,16 +29,25 @@ int64_t ExprBaseView::GetIntegerUnchecked(const ExprBase *e) {
   return integer->value;
 }
 
-const ExprBase *const *ExprBaseView::GetListUnchecked(const ExprBase *e) {
+const ExprBase *ExprBaseView::GetListElementUnchecked(const ExprBase *e, uint32_t index) {
   pdp_assert(e->kind == ExprBase::kList);
-  return reinterpret_cast<ExprBase **>((char *)e + sizeof(ExprList));
+  pdp_assert(index < e->size);
+  const char *payload = (const char *)e + sizeof(ExprList);
+  if (e->flags & ExprBase::kOffsets) {
+    const uint32_t *offsets = reinterpret_cast<const uint32_t *>(payload);
+    return reinterpret_cast<const ExprBase *>((const char *)e + offsets[index]);
+  } else {
+    return reinterpret_cast<const ExprBase *const *>(payload)[index];
+  }
 }
 
 StringSlice ExprBaseView::AsStringUnchecked() const { return GetStringUnchecked(expr); }
 
 int64_t ExprBaseView::AsIntegerUnchecked() const { return GetIntegerUnchecked(expr); }
 
-const ExprBase *const *ExprBaseView::AsListUnchecked() const { return GetListUnchecked(expr); }
+const ExprBase *ExprBaseView::AsListElementUnchecked(uint32_t index) const {
+  return GetListElementUnchecked(expr, index);
+}
 
 const ExprMap *ExprBaseView::AsMapUnchecked() const {
   pdp_assert(expr->kind == ExprBase::kMap);
@@ -70,11 +77,10 @@ static void RecursiveToJson(const ExprBase *expr, StringBuilder<DefaultAllocator
       builder.Append("[]");
     } else {
       builder.Append('[');
-      auto elements = ExprBaseView::GetListUnchecked(expr);
-      RecursiveToJson(elements[0], builder);
-      for (size_t i = 1; i < expr->size; ++i) {
+      RecursiveToJson(ExprBaseView::GetListElementUnchecked(expr, 0), builder);
+      for (uint32_t i = 1; i < expr->size; ++i) {
         builder.Append(", ");
-        RecursiveToJson(elements[i], builder);
+        RecursiveToJson(ExprBaseView::GetListElementUnchecked(expr, i), builder);
       }
       builder.Append(']');
     }
@@ -83,12 +89,11 @@ static void RecursiveToJson(const ExprBase *expr, StringBuilder<DefaultAllocator
       builder.Append("{}");
     } else {
       const ExprTuple *tuple = static_cast<const ExprTuple *>(expr);
-      const ExprTuple::Result *results = tuple->results;
-      builder.AppendFormat("{\"{}\":", StringSlice(results[0].key));
-      RecursiveToJson(results[0].value, builder);
-      for (size_t i = 1; i < expr->size; ++i) {
-        builder.AppendFormat(",\"{}\":", StringSlice(results[i].key));
-        RecursiveToJson(results[i].value, builder);
+      builder.AppendFormat("{\"{}\":", StringSlice(tuple->Key(0)));
+      RecursiveToJson(tuple->Value(0), builder);
+      for (uint32_t i = 1; i < expr->size; ++i) {
+        builder.AppendFormat(",\"{}\":", StringSlice(tuple->Key(i)));
+        RecursiveToJson(tuple->Value(i), builder);
       }
       builder.Append('}');
     }
@@ -126,12 +131,12 @@ GdbExprView GdbExprView::operator[](const StringSlice &key) const {
   RequireNotNull();
   if (PDP_LIKELY(expr->kind == ExprBase::kTuple)) {
     const ExprTuple *tuple = AsTupleUnchecked();
-    uint32_t hash = ankerl::unordered_dense::hash(key.Begin(), key.Size());
+    uint32_t hash = ExprKeyHash()(key.Begin(), key.Size());
+    const uint32_t *hashes = tuple->Hashes();
     for (uint32_t i = 0; i < tuple->size; ++i) {
-      if (PDP_UNLIKELY(tuple->hashes[i] == hash)) {
-        const ExprTuple::Result *result = tuple->results + i;
-        if (PDP_LIKELY(key == result->key)) {
-          return result->value;
+      if (PDP_UNLIKELY(hashes[i] == hash)) {
+        if (PDP_LIKELY(key == tuple->Key(i))) {
+          return tuple->Value(i);
         }
       }
     }
@@ -147,8 +152,7 @@ GdbExprView GdbExprView::operator[](uint32_t index) const {
   RequireNotNull();
   if (PDP_LIKELY(expr->kind == ExprBase::kList)) {
     if (PDP_LIKELY(index < expr->size)) {
-      auto elements = AsListUnchecked();
-      return elements[index];
+      return AsListElementUnchecked(index);
     }
   }
   return nullptr;
@@ -210,7 +214,7 @@ StrongTypedView::StrongTypedView(const ExprBase *expr) : ExprBaseView(expr) {}
 StrongTypedView StrongTypedView::operator[](const StringSlice &key) const {
   if (PDP_LIKELY(expr->kind == ExprBase::kMap)) {
     auto map = AsMapUnchecked();
-    uint32_t hash = ankerl::unordered_dense::hash(key.Begin(), key.Size());
+    uint32_t hash = ExprKeyHash()(key.Begin(), key.Size());
     for (uint32_t i = 0; i < map->size; ++i) {
       if (PDP_UNLIKELY(map->hashes[i] == hash)) {
         auto pair = map->pairs + i;
@@ -231,8 +235,7 @@ StrongTypedView StrongTypedView::operator[](const char *key) const {
 StrongTypedView StrongTypedView::operator[](uint32_t index) const {
   if (PDP_LIKELY(expr->kind == ExprBase::kList)) {
     if (PDP_LIKELY(index < expr->size)) {
-      auto elements = AsListUnchecked();
-      return elements[index];
+      return AsListElementUnchecked(index);
     }
   }
   return nullptr;
@@ -256,4 +259,49 @@ bool StrongTypedView::operator==(const StringSlice &str) const { return AsString
 
 bool StrongTypedView::operator!=(const StringSlice &str) const { return !(*this == str); }
 
+static bool RecursiveRelocatableEnd(const char *root, const ExprBase *expr, const char *&end) {
+  const char *expr_end = nullptr;
+  switch (expr->kind) {
+    case ExprBase::kString:
+      expr_end = (const char *)expr + sizeof(ExprString) + expr->size;
+      break;
+    case ExprBase::kList:
+      if (!(expr->flags & ExprBase::kOffsets)) {
+        return false;
+      }
+      expr_end = (const char *)expr + sizeof(ExprList) + expr->size * sizeof(uint32_t);
+      for (uint32_t i = 0; i < expr->size; ++i) {
+        if (!RecursiveRelocatableEnd(root, ExprBaseView::GetListElementUnchecked(expr, i), end)) {
+          return false;
+        }
+      }
+      break;
+    case ExprBase::kTuple: {
+      const ExprTuple *tuple = static_cast<const ExprTuple *>(expr);
+      expr_end = (const char *)(tuple->Results() + tuple->size);
+      for (uint32_t i = 0; i < tuple->size; ++i) {
+        const char *key = tuple->Key(i);
+        pdp_assert(key > root);
+        const char *key_end = key + strlen(key) + 1;
+        end = key_end > end ? key_end : end;
+        if (!RecursiveRelocatableEnd(root, tuple->Value(i), end)) {
+          return false;
+        }
+      }
+    } break;
+    default:
+      return false;
+  }
+  end = expr_end > end ? expr_end : end;
+  return true;
+}
+
+uint32_t RelocatableExprSize(const ExprBase *root) {
+  const char *end = (const char *)root;
+  if (!RecursiveRelocatableEnd((const char *)root, root, end)) {
+    return 0;
+  }
+  return AlignmentTraits::AlignUp(end - (const char *)root);
+}
+
 }  // namespace pdp
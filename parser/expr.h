@@ -2,17 +2,23 @@
 
 #include "data/unique_ptr.h"
 #include "strings/string_builder.h"
+#include "strings/string_hash.h"
 #include "strings/string_slice.h"
 
 #include <cstdint>
 
 namespace pdp {
 
+/// @brief Hash of tuple and map keys. Parsers store it and lookups recompute it.
+using ExprKeyHash = PortableStringHash;
+
 struct ExprBase {
   enum Kind { kNull, kInt, kString, kList, kTuple, kMap };
+  enum Flags { kOffsets = 1 };
 
   uint8_t kind;
-  uint8_t unused[3];
+  uint8_t flags;
+  uint8_t unused[2];
   uint32_t size;
 };
 
@@ -48,24 +54,42 @@ struct ExprString : public ExprBase {
 
 static_assert(sizeof(ExprString) == 8 && alignof(ExprString) <= 8);
 
+/// @brief Holds `size` pointers, or `size` 32-bit offsets from the list itself if `kOffsets` is
+/// set in `flags`.
 struct ExprList : public ExprBase {
   char payload[0];
 };
 
 static_assert(sizeof(ExprList) == 8 && alignof(ExprList) <= 8);
 
+/// @brief Followed by `size` key hashes and then `size` results. Both members of a result are
+/// offsets from the tuple itself, which makes a tree of tuples, offset lists and strings
+/// relocatable. Keys are null terminated and shared between tuples, so a key may lie before the
+/// tuple which refers to it.
 struct ExprTuple : public ExprBase {
   struct Result {
-    const char *key;
-    ExprBase *value;
+    int32_t key;
+    uint32_t value;
   };
 
-  uint32_t *hashes;
-  Result *results;
+  const uint32_t *Hashes() const { return reinterpret_cast<const uint32_t *>(payload); }
+  const Result *Results() const {
+    return reinterpret_cast<const Result *>(payload + size * sizeof(uint32_t));
+  }
+
+  const char *Key(uint32_t index) const {
+    return reinterpret_cast<const char *>(this) + Results()[index].key;
+  }
+  const ExprBase *Value(uint32_t index) const {
+    return reinterpret_cast<const ExprBase *>(reinterpret_cast<const char *>(this) +
+                                              Results()[index].value);
+  }
+
   char payload[0];
 };
 
-static_assert(sizeof(ExprTuple) == 24 && alignof(ExprTuple) <= 8);
+static_assert(sizeof(ExprTuple) == 8 && alignof(ExprTuple) <= 8);
+static_assert(sizeof(ExprTuple::Result) == 8);
 
 struct ExprMap : public ExprBase {
   struct Pair {
@@ -90,12 +114,12 @@ struct ExprBaseView {
 
   static StringSlice GetStringUnchecked(const ExprBase *e);
   static int64_t GetIntegerUnchecked(const ExprBase *e);
-  static const ExprBase *const *GetListUnchecked(const ExprBase *e);
+  static const ExprBase *GetListElementUnchecked(const ExprBase *e, uint32_t index);
 
  protected:
   StringSlice AsStringUnchecked() const;
   int64_t AsIntegerUnchecked() const;
-  const ExprBase *const *AsListUnchecked() const;
+  const ExprBase *AsListElementUnchecked(uint32_t index) const;
   const ExprMap *AsMapUnchecked() const;
   const ExprTuple *AsTupleUnchecked() const;
 
@@ -138,4 +162,10 @@ struct StrongTypedView : public ExprBaseView {
   bool operator!=(const StringSlice &str) const;
 };
 
+/// @brief Number of bytes spanned by a tree whose lists and tuples all hold offsets, counted from
+/// @p root, which comes first in memory. Such a tree is a single blob that can be copied with
+/// memcpy, shared between threads or written to disk, and viewed in place at its new address.
+/// @return Zero if any node of the tree holds pointers.
+uint32_t RelocatableExprSize(const ExprBase *root);
+
 }  // namespace pdp
@@ -1,6 +1,6 @@
 #include "mi_parser.h"
 #include "core/log.h"
-#include "external/ankerl_hash.h"
+#include "tracing/span_tracer.h"
 #include "tracing/trace_likely.h"
 
 namespace pdp {
@@ -24,8 +24,12 @@ char ReverseEscapeCharacter(char c) {
   }
 }
 
-MiFirstPass::MiFirstPass(const StringSlice &s)
-    : input(s), nesting_stack(50), sizes_stack(500), total_bytes(0) {}
+MiFirstPass::MiFirstPass(const StringSlice &s, ChainedArena<> &scratch_arena)
+    : input(s),
+      scratch(scratch_arena),
+      nesting_stack(50, &scratch_arena),
+      sizes_stack(500, &scratch_arena),
+      total_bytes(0) {}
 
 bool MiFirstPass::ReportError(const StringSlice &msg) {
   auto context_len = input.Size() > 50 ? 50 : input.Size();
@@ -47,6 +51,8 @@ bool MiFirstPass::ParseResult() {
 
   const uint32_t length_plus_one = it - input.Begin() + 1;
   sizes_stack[nesting_stack.Top()].total_string_size += length_plus_one;
+  // Upper bound, the second pass stores repeated keys only once.
+  total_bytes += AlignmentTraits::AlignUp(length_plus_one);
 
   input.DropLeft(length_plus_one);
   return ParseValue();
@@ -118,13 +124,11 @@ bool MiFirstPass::ParseResultOrValue() {
 void MiFirstPass::AccumulateBytes() {
   const auto &record = sizes_stack[nesting_stack.Top()];
   if (record.total_string_size > 0) {
-    total_bytes += AlignmentTraits::AlignUp(sizeof(ExprTuple));
-    total_bytes += AlignmentTraits::AlignUp(record.num_elements * sizeof(uint32_t));
-    total_bytes += AlignmentTraits::AlignUp(record.num_elements * sizeof(ExprTuple::Result));
-    total_bytes += AlignmentTraits::AlignUp(record.total_string_size);
+    total_bytes += AlignmentTraits::AlignUp(
+        sizeof(ExprTuple) + record.num_elements * (sizeof(uint32_t) + sizeof(ExprTuple::Result)));
   } else {
-    total_bytes += AlignmentTraits::AlignUp(sizeof(ExprList));
-    total_bytes += AlignmentTraits::AlignUp(record.num_elements * sizeof(ExprBase *));
+    total_bytes +=
+        AlignmentTraits::AlignUp(sizeof(ExprList) + record.num_elements * sizeof(uint32_t));
   }
 }
 
@@ -177,7 +181,11 @@ MiSecondPass::MiSecondPass(const StringSlice &s, MiFirstPass &first_pass)
       first_pass_stack(std::move(first_pass.sizes_stack)),
       first_pass_marker(0),
       arena(first_pass.total_bytes),
-      second_pass_stack(50) {}
+      second_pass_stack(50, &first_pass.scratch),
+      root(nullptr),
+      num_interned_keys(0) {
+  memset(key_slots, 0, sizeof(key_slots));
+}
 
 ExprBase *MiSecondPass::ReportError(const StringSlice &msg) {
   auto context_len = input.Size() > 50 ? 50 : input.Size();
@@ -185,19 +193,40 @@ ExprBase *MiSecondPass::ReportError(const StringSlice &msg) {
   return nullptr;
 }
 
+const char *MiSecondPass::InternKey(const char *key, uint32_t length, uint32_t hash) {
+  pdp_assert(root);
+  uint32_t pos = hash & (num_key_slots - 1);
+  while (key_slots[pos].offset != 0) {
+    if (key_slots[pos].hash == hash) {
+      const char *existing = root + key_slots[pos].offset;
+      if (PDP_LIKELY(memcmp(existing, key, length) == 0 && existing[length] == '\0')) {
+        return existing;
+      }
+    }
+    pos = (pos + 1) & (num_key_slots - 1);
+  }
+
+  char *copy = static_cast<char *>(arena.Allocate(length + 1));
+  memcpy(copy, key, length);
+  copy[length] = '\0';
+  if (PDP_LIKELY(num_interned_keys < max_interned_keys)) {
+    key_slots[pos].hash = hash;
+    key_slots[pos].offset = copy - root;
+    ++num_interned_keys;
+  }
+  return copy;
+}
+
 ExprBase *MiSecondPass::ParseResult() {
   pdp_assert(!input.Empty());
 
   pdp_assert(!second_pass_stack.Empty());
-  char *__restrict string_table_ptr = second_pass_stack.Top().string_table_ptr;
-  pdp_assert(string_table_ptr);
-  second_pass_stack.Top().tuple_members->key = string_table_ptr;
+  MiRecord &parent = second_pass_stack.Top();
+  pdp_assert(parent.hash_table_ptr);
 
   const char *__restrict it = input.Begin();
   while (IsMiIdentifier(*it)) {
     pdp_assert(it < input.End());
-    *string_table_ptr = *it;
-    ++string_table_ptr;
     ++it;
   }
   const bool failed = (*it != '=');
@@ -205,13 +234,12 @@ ExprBase *MiSecondPass::ParseResult() {
     return ReportError("Expecting variable=...");
   }
 
-  *string_table_ptr = '\0';
-  second_pass_stack.Top().string_table_ptr = string_table_ptr + 1;
-
-  const size_t length = it - input.Begin();
-  const uint32_t hash = ankerl::unordered_dense::hash(input.Begin(), length);
-  *second_pass_stack.Top().hash_table_ptr = hash;
-  ++second_pass_stack.Top().hash_table_ptr;
+  const uint32_t length = it - input.Begin();
+  const uint32_t hash = ExprKeyHash()(input.Begin(), length);
+  const char *key = InternKey(input.Begin(), length, hash);
+  parent.tuple_members->key = key - reinterpret_cast<char *>(parent.expr);
+  *parent.hash_table_ptr = hash;
+  ++parent.hash_table_ptr;
 
   input.DropLeft(length + 1);
   return ParseValue();
@@ -269,51 +297,39 @@ ExprBase *MiSecondPass::ParseString() {
 
 ExprBase *MiSecondPass::CreateListOrTuple() {
   uint32_t size = first_pass_stack[first_pass_marker].num_elements;
-  uint32_t string_table_size = first_pass_stack[first_pass_marker].total_string_size;
-  const bool is_tuple = string_table_size > 0;
+  const bool is_tuple = first_pass_stack[first_pass_marker].total_string_size > 0;
   ++first_pass_marker;
 
   if (is_tuple) {
-    ExprTuple *tuple = static_cast<ExprTuple *>(arena.AllocateUnchecked(sizeof(ExprTuple)));
+    ExprTuple *tuple = static_cast<ExprTuple *>(
+        arena.Allocate(sizeof(ExprTuple) + size * (sizeof(uint32_t) + sizeof(ExprTuple::Result))));
     tuple->kind = ExprBase::kTuple;
+    tuple->flags = ExprBase::kOffsets;
     tuple->size = size;
-    tuple->hashes = static_cast<uint32_t *>(arena.AllocateOrNull(size * sizeof(uint32_t)));
-    tuple->results =
-        static_cast<ExprTuple::Result *>(arena.AllocateOrNull(size * sizeof(ExprTuple::Result)));
-    char *string_table = static_cast<char *>(arena.AllocateOrNull(string_table_size));
 
     auto *expr_record = second_pass_stack.NewElement();
     expr_record->expr = tuple;
-    expr_record->tuple_members = tuple->results;
-    expr_record->hash_table_ptr = tuple->hashes;
-    expr_record->string_table_ptr = string_table;
+    expr_record->tuple_members = const_cast<ExprTuple::Result *>(tuple->Results());
+    expr_record->hash_table_ptr = const_cast<uint32_t *>(tuple->Hashes());
 #ifdef PDP_ENABLE_ASSERT
-    expr_record->record_end = string_table + string_table_size;
+    expr_record->record_end = expr_record->tuple_members + size;
 #endif
-
-    // Locality checks
-    pdp_assert((char *)tuple->hashes - (char *)tuple == sizeof(ExprTuple));
-    pdp_assert((char *)tuple->results - (char *)tuple->hashes <=
-               static_cast<ptrdiff_t>((size + 1) * sizeof(uint32_t)));
-    pdp_assert(string_table - (char *)tuple->results ==
-               static_cast<ptrdiff_t>(size * sizeof(ExprTuple::Result)));
     return tuple;
   } else {
-    ExprList *list = static_cast<ExprList *>(arena.AllocateUnchecked(sizeof(ExprList)));
+    ExprList *list =
+        static_cast<ExprList *>(arena.Allocate(sizeof(ExprList) + size * sizeof(uint32_t)));
     list->kind = ExprBase::kList;
+    list->flags = ExprBase::kOffsets;
     list->size = size;
-    ExprBase **members = static_cast<ExprBase **>(arena.AllocateOrNull(size * sizeof(ExprBase *)));
+    uint32_t *members = reinterpret_cast<uint32_t *>(list->payload);
 
     auto *expr_record = second_pass_stack.NewElement();
     expr_record->expr = list;
     expr_record->list_members = members;
-    expr_record->string_table_ptr = nullptr;
+    expr_record->hash_table_ptr = nullptr;
 #ifdef PDP_ENABLE_ASSERT
-    expr_record->record_end = (char *)members + size * sizeof(ExprBase *);
+    expr_record->record_end = members + size;
 #endif
-
-    // Validity allocation check
-    pdp_assert(!members || (char *)members - (char *)list == sizeof(ExprList));
     return list;
   }
 }
@@ -343,13 +359,17 @@ ExprBase *MiSecondPass::ParseResultOrValue() {
   }
 
   if (PDP_LIKELY(expr)) {
-    const bool is_tuple = second_pass_stack[parent_pos].string_table_ptr;
+    MiRecord &parent = second_pass_stack[parent_pos];
+    // Members are allocated after their parent, so the offset is positive.
+    pdp_assert(expr > parent.expr);
+    const uint32_t offset = reinterpret_cast<char *>(expr) - reinterpret_cast<char *>(parent.expr);
+    const bool is_tuple = parent.hash_table_ptr;
     if (is_tuple) {
-      second_pass_stack[parent_pos].tuple_members->value = expr;
-      ++second_pass_stack[parent_pos].tuple_members;
+      parent.tuple_members->value = offset;
+      ++parent.tuple_members;
     } else {
-      *second_pass_stack[parent_pos].list_members = expr;
-      ++second_pass_stack[parent_pos].list_members;
+      *parent.list_members = offset;
+      ++parent.list_members;
     }
   }
   return expr;
@@ -359,28 +379,26 @@ UniquePtr<ExprBase> MiSecondPass::Parse() {
   if (PDP_UNLIKELY(input.Empty())) {
     ExprTuple *tuple = static_cast<ExprTuple *>(arena.AllocateUnchecked(sizeof(ExprTuple)));
     tuple->kind = ExprBase::kTuple;
+    tuple->flags = ExprBase::kOffsets;
     tuple->size = 0;
-    tuple->hashes = nullptr;
-    tuple->results = nullptr;
 
     void *raw_mem = arena.Release();
     pdp_assert(raw_mem == tuple);
     return tuple;
   }
 
-  ExprBase *root = CreateListOrTuple();
-  bool okay = (root != nullptr);
+  ExprBase *root_expr = CreateListOrTuple();
+  root = reinterpret_cast<char *>(root_expr);
+  bool okay = (root_expr != nullptr);
   while (okay && !input.Empty()) {
     switch (input[0]) {
       case ']':
       case '}':
-        if (second_pass_stack.Top().string_table_ptr) {
-          pdp_assert(second_pass_stack.Top().string_table_ptr <=
-                     second_pass_stack.Top().record_end);
+        if (second_pass_stack.Top().hash_table_ptr) {
+          pdp_assert(second_pass_stack.Top().tuple_members == second_pass_stack.Top().record_end);
           [[maybe_unused]]
           ExprTuple *tuple = static_cast<ExprTuple *>(second_pass_stack.Top().expr);
-          pdp_assert(second_pass_stack.Top().tuple_members - tuple->results == tuple->size);
-          pdp_assert(second_pass_stack.Top().hash_table_ptr - tuple->hashes == tuple->size);
+          pdp_assert(second_pass_stack.Top().hash_table_ptr - tuple->Hashes() == tuple->size);
         } else {
           pdp_assert(second_pass_stack.Top().list_members <= second_pass_stack.Top().record_end);
         }
@@ -400,9 +418,33 @@ UniquePtr<ExprBase> MiSecondPass::Parse() {
   if (PDP_LIKELY(okay)) {
     void *raw_mem = arena.Release();
     pdp_assert(root == raw_mem);
-    return root;
+    return root_expr;
   }
   return nullptr;
 }
 
+static ExprBase *RunBothPasses(const StringSlice &results, ChainedArena<> &scratch) {
+  MiFirstPass first_pass(results, scratch);
+  if (PDP_UNLIKELY(!first_pass.Parse())) {
+    pdp_error("Pass #1 failed on: {}", results);
+    return nullptr;
+  }
+  MiSecondPass second_pass(results, first_pass);
+  UniquePtr<ExprBase> expr(second_pass.Parse());
+  if (PDP_UNLIKELY(!expr)) {
+    pdp_error("Pass #2 failed on: {}", results);
+  }
+  return expr.Release();
+}
+
+UniquePtr<ExprBase> ParseMiResults(const StringSlice &results, ChainedArena<> &scratch) {
+  PDP_TRACE_SPAN("ParseMiResults", results.Size());
+  const ArenaMark mark = scratch.Mark();
+  UniquePtr<ExprBase> expr(RunBothPasses(results, scratch));
+  scratch.Rewind(mark);
+  // A huge record would otherwise keep its blocks for the rest of the session.
+  scratch.TrimSpareBlocks();
+  return expr;
+}
+
 }  // namespace pdp
@@ -18,7 +18,7 @@ char ReverseEscapeCharacter(char c);
 struct MiFirstPass {
   friend struct MiSecondPass;
 
-  MiFirstPass(const StringSlice &s);
+  MiFirstPass(const StringSlice &s, ChainedArena<> &scratch);
 
   bool Parse();
 
@@ -39,12 +39,16 @@ struct MiFirstPass {
   };
 
   StringSlice input;
-  Stack<uint32_t> nesting_stack;
-  Stack<MiRecord> sizes_stack;
+  ChainedArena<> &scratch;
+  Stack<uint32_t, ArenaAllocator<>> nesting_stack;
+  Stack<MiRecord, ArenaAllocator<>> sizes_stack;
 
   uint32_t total_bytes;
 };
 
+/// @brief Builds the expression tree in a single block sized by the first pass. Tuples and lists
+/// refer to their members by offsets and keys are stored once per record, so the block is
+/// relocatable, see RelocatableExprSize().
 struct MiSecondPass {
   MiSecondPass(const StringSlice &s, MiFirstPass &first_pass);
 
@@ -53,6 +57,7 @@ struct MiSecondPass {
  private:
   ExprBase *ReportError(const StringSlice &msg);
   ExprBase *CreateListOrTuple();
+  const char *InternKey(const char *key, uint32_t length, uint32_t hash);
 
   ExprBase *ParseResult();
   ExprBase *ParseValue();
@@ -63,21 +68,39 @@ struct MiSecondPass {
   struct MiRecord {
     ExprBase *expr;
     union {
-      ExprBase **list_members;
+      uint32_t *list_members;
       ExprTuple::Result *tuple_members;
     };
-    char *string_table_ptr;
     uint32_t *hash_table_ptr;
 #ifdef PDP_ENABLE_ASSERT
     void *record_end;
 #endif
   };
 
+  // Keys seen so far in this record. Offsets are from the root, zero marks an empty slot since
+  // the root is never a key.
+  struct KeySlot {
+    uint32_t hash;
+    uint32_t offset;
+  };
+
+  static constexpr uint32_t num_key_slots = 64;
+  static constexpr uint32_t max_interned_keys = num_key_slots * 3 / 4;
+
   StringSlice input;
-  Stack<MiFirstPass::MiRecord> first_pass_stack;
+  Stack<MiFirstPass::MiRecord, ArenaAllocator<>> first_pass_stack;
   size_t first_pass_marker;
-  Arena<DefaultAllocator> arena;
-  Stack<MiRecord> second_pass_stack;
+  Arena<> arena;
+  Stack<MiRecord, ArenaAllocator<>> second_pass_stack;
+  char *root;
+  uint32_t num_interned_keys;
+  KeySlot key_slots[num_key_slots];
 };
 
+/// @brief Runs both passes over the results of a single MI record. Failures are logged.
+/// The parser stacks live in `scratch`, which is rewound before returning. Blocks the stacks
+/// needed past the current one are freed.
+/// @return The self-contained expression tree or null if the input is malformed.
+UniquePtr<ExprBase> ParseMiResults(const StringSlice &results, ChainedArena<> &scratch);
+
 }  // namespace pdp
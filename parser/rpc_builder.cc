@@ -1,5 +1,6 @@
 #include "rpc_builder.h"
 #include "core/internals.h"
+#include "tracing/span_tracer.h"
 
 namespace pdp {
 
@@ -23,6 +24,18 @@ void RpcBuilder::Restart(uint32_t token, const StringSlice &method) {
   Add(method);
 }
 
+void RpcBuilder::RestartResponse(uint32_t msgid) {
+  backfill[0].pos = 0;
+  backfill[0].num_elems = 1;
+  depth = 0;
+
+  builder.Clear();
+  PushByte(0x90);
+  PushByte(0x1);
+
+  Add(msgid);
+}
+
 void RpcBuilder::PushByte(byte b) { builder.AppendByte(b); }
 
 void RpcBuilder::PushUint8(uint8_t x) {
@@ -156,6 +169,12 @@ void RpcBuilder::Add(const StringSlice &str) {
 
 void RpcBuilder::Add(const char *str) { Add(StringSlice(str)); }
 
+void RpcBuilder::AddNil() {
+  PushByte(0xc0);
+
+  OnElementAdded();
+}
+
 void RpcBuilder::OnElementAdded() {
   pdp_assert(depth >= 0);
   backfill[depth].num_elems += 1;
@@ -233,6 +252,7 @@ bool RpcBuilder::SetRequestToken(uint32_t t) {
 }
 
 RpcBytes RpcBuilder::Finish() {
+  PDP_TRACE_SPAN("RpcBuilder::Finish");
   if (PDP_UNLIKELY(depth != 0)) {
     PDP_UNREACHABLE("RpcBuilder: Unclosed array!");
   }
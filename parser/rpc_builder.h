@@ -69,6 +69,9 @@ struct RpcBuilder {
   RpcBuilder(uint32_t token, const StringSlice &method);
 
   void Restart(uint32_t token, const StringSlice &method);
+  /// @brief Starts the response [1, msgid, error, result] to a request of Neovim. Add the error,
+  /// AddNil() on success, and then the result.
+  void RestartResponse(uint32_t msgid);
 
   void Add(uint32_t value);
   void Add(int32_t value);
@@ -77,6 +80,7 @@ struct RpcBuilder {
   void Add(bool value);
   void Add(const StringSlice &str);
   void Add(const char *str);
+  void AddNil();
 
   template <typename T, std::enable_if_t<IsRpc<T>::value, int> = 0>
   void AddMapItem(const StringSlice &key, T value) {
@@ -383,7 +383,7 @@ void _RpcPassHelper<A>::AttachExpr(ExprBase *expr) {
   if (is_key && top.hashes) {
     if (PDP_LIKELY(expr->kind == ExprBase::kString)) {
       const char *str = (char *)expr + sizeof(ExprBase);
-      *top.hashes = ankerl::unordered_dense::hash(str, expr->size);
+      *top.hashes = ExprKeyHash()(str, expr->size);
       ++top.hashes;
     } else if (PDP_LIKELY(expr->kind == ExprBase::kInt)) {
       ExprInt *integer = static_cast<ExprInt *>(expr);
@@ -449,6 +449,7 @@ ExprBase *_RpcPassHelper<A>::CreateArray(uint32_t length) {
   ExprList *expr = static_cast<ExprList *>(
       allocator.AllocateUnchecked(sizeof(ExprList) + sizeof(ExprBase *) * length));
   expr->kind = ExprBase::kList;
+  expr->flags = 0;
   expr->size = length;
 
   return expr;
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "data/allocator.h"
+#include "data/memory_tags.h"
 #include "system/file_descriptor.h"
 
 #include <unistd.h>
@@ -42,12 +42,13 @@ struct ByteStream {
  private:
   void RequireAtLeast(size_t n);
 
+  // Must be constructed before `ptr`.
+  TaggedAllocator<MemoryTag::kByteStream> allocator;
+
   byte *__restrict__ const ptr;
   byte *__restrict__ begin;
   byte *__restrict__ end;
 
-  DefaultAllocator allocator;
-
   InputDescriptor stream;
 };
 
@@ -2,40 +2,60 @@
 
 namespace pdp {
 
-FixedString::FixedString() : ptr(nullptr), size(0) {}
+FixedString::FixedString() { InitInline("", 0); }
 
 FixedString::FixedString(const char *str, size_t len) {
-  ptr = Allocate<char>(allocator, len + 1);
-  memcpy(ptr, str, len);
-  ptr[len] = 0;
-  size = len;
+  if (PDP_LIKELY(len <= inline_capacity)) {
+    InitInline(str, len);
+  } else {
+    char *ptr = Allocate<char>(Allocator(), len + 1);
+    memcpy(ptr, str, len);
+    ptr[len] = 0;
+    InitHeap(ptr, len);
+  }
 }
 
 FixedString::FixedString(const char *begin, const char *end) : FixedString(begin, end - begin) {}
 
 FixedString::FixedString(const StringSlice &rhs) : FixedString(rhs.Begin(), rhs.Size()) {}
 
-FixedString::FixedString(FixedString &&rhs) : ptr(rhs.ptr), size(rhs.size) { rhs.ptr = nullptr; }
+FixedString::FixedString(FixedString &&rhs) {
+  memcpy(static_cast<void *>(&local), &rhs.local, sizeof(local));
+  rhs.InitInline("", 0);
+}
 
 FixedString::FixedString(StringVector &&rhs) {
   pdp_assert(rhs.Size() >= 1);
   pdp_assert(rhs.Last() == '\0');
-  size = rhs.Size() - 1;
   impl::_VectorPrivAcess<char, DefaultAllocator> _vector_priv(rhs);
-  ptr = _vector_priv.ReleaseData();
-  pdp_assert(ptr[size] == 0);
+  const size_t len = rhs.Size() - 1;
+  InitHeap(_vector_priv.ReleaseData(), len);
 }
 
 FixedString::FixedString(StringBuffer &&rhs, size_t length) {
   pdp_assert(rhs.Get() != nullptr);
-  ptr = rhs.Release();
-  size = length;
-  pdp_assert(ptr[size] == 0);
+  InitHeap(rhs.Release(), length);
 }
 
-FixedString::~FixedString() {
-  if (ptr) {
-    Deallocate<char>(allocator, ptr);
+FixedString::~FixedString() { ReleaseHeap(); }
+
+void FixedString::InitInline(const char *str, size_t len) {
+  pdp_assert(len <= inline_capacity);
+  memmove(local.chars, str, len);
+  local.chars[len] = 0;
+  local.tag = len;
+}
+
+void FixedString::InitHeap(char *ptr, size_t len) {
+  pdp_assert(ptr[len] == 0);
+  heap.ptr = ptr;
+  heap.size = len;
+  local.tag = heap_tag;
+}
+
+void FixedString::ReleaseHeap() {
+  if (!IsInline()) {
+    Deallocate<char>(Allocator(), heap.ptr);
   }
 }
 
@@ -43,36 +63,48 @@ FixedString FixedString::Copy() const { return FixedString(Begin(), Size()); }
 
 void FixedString::Reset(FixedString &&rhs) {
   pdp_assert(this != &rhs);
-  if (PDP_LIKELY(ptr)) {
-    Deallocate<char>(allocator, ptr);
-  }
-  ptr = rhs.ptr;
-  size = rhs.size;
-  rhs.ptr = nullptr;
+  ReleaseHeap();
+  memcpy(static_cast<void *>(&local), &rhs.local, sizeof(local));
+  rhs.InitInline("", 0);
 }
 
 void FixedString::Reset(const StringSlice &rhs) {
-  if (PDP_LIKELY(ptr)) {
-    const bool insufficient_memory = (allocator.GetAllocationSize(ptr) < rhs.Size() + 1);
+  const size_t len = rhs.Size();
+  if (len <= inline_capacity) {
+    // The inline chars overlap the heap pointer and rhs may point into the heap block, so copy
+    // out before releasing it.
+    char chars[inline_capacity];
+    memcpy(chars, rhs.Begin(), len);
+    ReleaseHeap();
+    InitInline(chars, len);
+    return;
+  }
+
+  char *ptr;
+  if (!IsInline()) {
+    ptr = heap.ptr;
+    const bool insufficient_memory = (Allocator().GetAllocationSize(ptr) < len + 1);
     if (insufficient_memory) {
-      ptr = Reallocate<char>(allocator, ptr, rhs.Size() + 1);
+      ptr = Reallocate<char>(Allocator(), ptr, len + 1);
     }
+  } else {
+    ptr = Allocate<char>(Allocator(), len + 1);
   }
-
-  memcpy(ptr, rhs.Begin(), rhs.Size());
-  size = rhs.Size();
-  ptr[size] = 0;
+  // A slice of this string fits without reallocating, but may overlap the destination.
+  memmove(ptr, rhs.Begin(), len);
+  ptr[len] = 0;
+  InitHeap(ptr, len);
 }
 
-const char *FixedString::Cstr() const { return ptr; }
-const char *FixedString::Begin() const { return ptr; }
-const char *FixedString::End() const { return ptr + size; }
+const char *FixedString::Cstr() const { return Begin(); }
+const char *FixedString::Begin() const { return IsInline() ? local.chars : heap.ptr; }
+const char *FixedString::End() const { return Begin() + Size(); }
 
-bool FixedString::Empty() const { return size == 0; }
-size_t FixedString::Size() const { return size; }
-size_t FixedString::Length() const { return size; }
+bool FixedString::Empty() const { return Size() == 0; }
+size_t FixedString::Size() const { return IsInline() ? local.tag : heap.size; }
+size_t FixedString::Length() const { return Size(); }
 
-const StringSlice FixedString::ToSlice() const { return StringSlice(ptr, size); }
+const StringSlice FixedString::ToSlice() const { return StringSlice(Begin(), Size()); }
 
 FixedString::operator StringSlice() const { return ToSlice(); }
 
@@ -86,6 +118,6 @@ bool FixedString::operator!=(const FixedString &other) const { return !(*this ==
 
 bool FixedString::operator!=(const StringSlice &other) const { return !(*this == other); }
 
-const char &FixedString::operator[](size_t index) const { return ptr[index]; }
+const char &FixedString::operator[](size_t index) const { return Begin()[index]; }
 
 };  // namespace pdp
@@ -8,7 +8,11 @@
 
 namespace pdp {
 
-struct FixedString : public NonCopyable {
+/// @brief Immutable, null terminated string. Strings of up to 22 characters are stored inline.
+///
+/// The inline characters live inside the object itself (no pointer into it), so a FixedString can
+/// still be moved with a plain memcpy/realloc.
+struct FixedString : private DefaultAllocator, public NonCopyable {
   FixedString();
 
   FixedString(const char *str, size_t len);
@@ -48,12 +52,42 @@ struct FixedString : public NonCopyable {
   const char &operator[](size_t index) const;
 
  private:
-  char *ptr;
-  size_t size;
+  void InitInline(const char *str, size_t len);
+  void InitHeap(char *ptr, size_t len);
+  void ReleaseHeap();
 
-  DefaultAllocator allocator;
+  bool IsInline() const { return local.tag != heap_tag; }
+
+  DefaultAllocator &Allocator() { return *this; }
+
+ public:
+  static constexpr size_t inline_capacity = 22;
+
+ private:
+  static constexpr uint8_t heap_tag = 0xff;
+
+  struct HeapRep {
+    char *ptr;
+    size_t size;
+    char unused[inline_capacity - 2 * sizeof(size_t) + 1];
+    uint8_t tag;
+  };
+
+  struct InlineRep {
+    char chars[inline_capacity + 1];
+    // Length of the inline string or heap_tag.
+    uint8_t tag;
+  };
+
+  union {
+    HeapRep heap;
+    InlineRep local;
+  };
 };
 
+static_assert(sizeof(FixedString) == 24 || !std::is_empty_v<DefaultAllocator>,
+              "Inline storage should not grow the string");
+
 template <>
 struct CanReallocate<FixedString> : std::true_type {};
 
@@ -0,0 +1,96 @@
+#include "path_table.h"
+#include "external/ankerl_hash.h"
+
+namespace pdp {
+
+PathTable g_path_table;
+
+PathTable::PathTable() : arena(4_KB), arena_bytes(0), entries(min_buckets / 2) {
+  entries += Entry{"", 0, 0};
+  owner = pthread_self();
+
+  buckets = Allocate<PathId>(allocator, min_buckets);
+  memset(buckets, 0, min_buckets * sizeof(PathId));
+  bucket_mask = min_buckets - 1;
+}
+
+PathTable::~PathTable() { Deallocate<PathId>(allocator, buckets); }
+
+PathId PathTable::Intern(const StringSlice &path) {
+  pdp_assert(IsOwnerThread());
+  if (PDP_UNLIKELY(path.Empty())) {
+    return no_path;
+  }
+  const uint32_t hash = ankerl::unordered_dense::hash(path.Begin(), path.Size());
+  uint32_t pos = FindBucket(path, hash);
+  if (buckets[pos] != no_path) {
+    return buckets[pos];
+  }
+
+  pdp_assert(path.Size() < UINT32_MAX);
+  const uint32_t length = static_cast<uint32_t>(path.Size());
+  char *chars = static_cast<char *>(arena.Allocate(length + 1));
+  memcpy(chars, path.Begin(), length);
+  chars[length] = '\0';
+  arena_bytes += length + 1;
+
+  const PathId id = entries.Size();
+  entries += Entry{chars, length, hash};
+
+  buckets[pos] = id;
+  // Keep the load factor at or below one half.
+  if (PDP_UNLIKELY(entries.Size() * 2 > bucket_mask + 1)) {
+    Rehash((bucket_mask + 1) * 2);
+  }
+  return id;
+}
+
+PathId PathTable::Find(const StringSlice &path) const {
+  pdp_assert(IsOwnerThread());
+  if (PDP_UNLIKELY(path.Empty())) {
+    return no_path;
+  }
+  const uint32_t hash = ankerl::unordered_dense::hash(path.Begin(), path.Size());
+  return buckets[FindBucket(path, hash)];
+}
+
+StringSlice PathTable::Get(PathId id) const {
+  pdp_assert(IsOwnerThread());
+  const Entry &entry = entries[id];
+  return StringSlice(entry.chars, entry.length);
+}
+
+const char *PathTable::Cstr(PathId id) const {
+  pdp_assert(IsOwnerThread());
+  return entries[id].chars;
+}
+
+uint32_t PathTable::FindBucket(const StringSlice &path, uint32_t hash) const {
+  uint32_t pos = hash & bucket_mask;
+  while (buckets[pos] != no_path) {
+    const Entry &entry = entries[buckets[pos]];
+    if (entry.hash == hash && entry.length == path.Size() &&
+        memcmp(entry.chars, path.Begin(), path.Size()) == 0) {
+      break;
+    }
+    pos = (pos + 1) & bucket_mask;
+  }
+  return pos;
+}
+
+void PathTable::Rehash(uint32_t new_num_buckets) {
+  Deallocate<PathId>(allocator, buckets);
+  buckets = Allocate<PathId>(allocator, new_num_buckets);
+  memset(buckets, 0, new_num_buckets * sizeof(PathId));
+  bucket_mask = new_num_buckets - 1;
+
+  for (PathId id = 1; id < entries.Size(); ++id) {
+    uint32_t pos = entries[id].hash & bucket_mask;
+    while (buckets[pos] != no_path) {
+      pos = (pos + 1) & bucket_mask;
+    }
+    buckets[pos] = id;
+  }
+}
+
+}  // namespace pdp
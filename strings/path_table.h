@@ -0,0 +1,70 @@
+#pragma once
+
+#include "data/arena.h"
+#include "string_vector.h"
+
+#include <pthread.h>
+
+namespace pdp {
+
+/// @brief Stable 32-bit handle of an interned path.
+using PathId = uint32_t;
+
+/// @brief Interns file paths so each distinct path is stored exactly once.
+///
+/// Characters live null terminated in a chained arena, so they never move. Every path gets a stable
+/// id, and id->slice lookup is an index into a side table. Two paths are equal if and only if their
+/// ids are equal. Paths are never removed, only intern what is worth keeping for the whole session
+/// (e.g. readable source files, not every buffer name).
+///
+/// Not thread safe: every method must be called from the thread which created the table, asserted
+/// in debug builds. Copy a path out before handing it to another thread.
+struct PathTable : public NonCopyableNonMovable {
+  /// @brief Id of the empty path. Used as "no file".
+  static constexpr PathId no_path = 0;
+
+  PathTable();
+  ~PathTable();
+
+  /// @brief Returns the id of @p path, adding it to the table if not already present.
+  PathId Intern(const StringSlice &path);
+
+  /// @brief Returns the id of @p path, or `no_path` if it was never interned.
+  PathId Find(const StringSlice &path) const;
+
+  /// @brief The returned slice stays valid for the lifetime of the table.
+  StringSlice Get(PathId id) const;
+  const char *Cstr(PathId id) const;
+
+  /// @brief Number of ids handed out, including `no_path`.
+  size_t Size() const { return entries.Size(); }
+  size_t ArenaBytes() const { return arena_bytes; }
+
+ private:
+  struct Entry {
+    const char *chars;
+    uint32_t length;
+    uint32_t hash;
+  };
+
+  static constexpr uint32_t min_buckets = 64;
+
+  uint32_t FindBucket(const StringSlice &path, uint32_t hash) const;
+  void Rehash(uint32_t new_num_buckets);
+  bool IsOwnerThread() const { return pthread_equal(owner, pthread_self()); }
+
+  DefaultAllocator allocator;
+  ChainedArena<> arena;
+  size_t arena_bytes;
+  Vector<Entry> entries;
+  // Open addressing table with linear probing. Slots store ids, zero marks an empty slot since
+  // `no_path` is never inserted.
+  PathId *buckets;
+  uint32_t bucket_mask;
+  pthread_t owner;
+};
+
+/// @brief Table of all source file paths seen by the debugger.
+extern PathTable g_path_table;
+
+}  // namespace pdp
@@ -1,5 +1,8 @@
 #include "rolling_buffer.h"
 #include "core/check.h"
+#include "core/clock.h"
+#include "core/trace_category.h"
+#include "tracing/span_tracer.h"
 #include "tracing/trace_likely.h"
 
 #include <unistd.h>
@@ -9,17 +12,14 @@
 
 namespace pdp {
 
-RollingBuffer::RollingBuffer()
-#ifdef PDP_TRACE_ROLLING_BUFFER
-    : provide_bytes(names)
-#endif
-{
+RollingBuffer::RollingBuffer() : provide_bytes("RollingBuffer", names) {
   ptr = Allocate<char>(allocator, default_buffer_size);
   pdp_assert(ptr);
   begin = ptr;
   end = ptr;
   limit = begin + default_buffer_size;
   search_for_newlines = false;
+  last_read_tsc = 0;
 }
 
 RollingBuffer::~RollingBuffer() { Deallocate<char>(allocator, ptr); }
@@ -29,6 +29,7 @@ void RollingBuffer::SetDescriptor(int fd) { input_fd.SetDescriptor(fd); }
 int RollingBuffer::GetDescriptor() const { return input_fd.GetDescriptor(); }
 
 MutableLine RollingBuffer::ReadLine() {
+  PDP_TRACE_SPAN("RollingBuffer::ReadLine");
   if (PDP_UNLIKELY(search_for_newlines)) {
     char *pos = static_cast<char *>(memchr(begin, '\n', end - begin));
     search_for_newlines = (pos != nullptr);
@@ -46,6 +47,7 @@ MutableLine RollingBuffer::ReadLine() {
     pdp_assert(remaining_bytes >= min_read_size);
     ssize_t ret = input_fd.ReadOnce(end, remaining_bytes);
     if (PDP_LIKELY(ret > 0)) {
+      last_read_tsc = ReadTsc();
       char *pos = static_cast<char *>(memchr(end, '\n', ret));
       end += ret;
       pdp_assert(end <= limit);
@@ -72,17 +74,17 @@ void RollingBuffer::ReserveForRead() {
   if (PDP_LIKELY(empty)) {
     begin = ptr;
     end = ptr;
-#ifdef PDP_TRACE_ROLLING_BUFFER
-    provide_bytes.Count(kEmptyOptimization);
-#endif
+    if (PDP_TRACE_ENABLED(kRollingBuffer)) {
+      provide_bytes.Count(kEmptyOptimization);
+    }
     return;
   }
 
   const size_t curr_free = limit - end;
   if (PDP_LIKELY(curr_free >= min_read_size)) {
-#ifdef PDP_TRACE_ROLLING_BUFFER
-    provide_bytes.Count(kMinSize);
-#endif
+    if (PDP_TRACE_ENABLED(kRollingBuffer)) {
+      provide_bytes.Count(kMinSize);
+    }
     return;
   }
 
@@ -92,9 +94,9 @@ void RollingBuffer::ReserveForRead() {
     memcpy(ptr, begin, used_size);
     begin -= fragmented_size;
     end -= fragmented_size;
-#ifdef PDP_TRACE_ROLLING_BUFFER
-    provide_bytes.Count(kMoved);
-#endif
+    if (PDP_TRACE_ENABLED(kRollingBuffer)) {
+      provide_bytes.Count(kMoved);
+    }
     return;
   }
 
@@ -114,9 +116,9 @@ void RollingBuffer::ReserveForRead() {
   begin = new_ptr;
   end = new_ptr + used_size;
   limit = new_ptr + capacity;
-#ifdef PDP_TRACE_ROLLING_BUFFER
-  provide_bytes.Count(kAllocation);
-#endif
+  if (PDP_TRACE_ENABLED(kRollingBuffer)) {
+    provide_bytes.Count(kAllocation);
+  }
 }
 
 }  // namespace pdp
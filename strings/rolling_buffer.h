@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/memory_tags.h"
 #include "system/file_descriptor.h"
 #include "tracing/tracing_counter.h"
 
@@ -45,6 +46,13 @@ struct RollingBuffer {
   int GetDescriptor() const;
 
   MutableLine ReadLine();
+  /// @brief The writer closed its end and every complete line was read.
+  bool ReachedEnd() const { return input_fd.ReachedEnd(); }
+
+  /// @brief ReadTsc() right after the read which returned the newline of the last line. Lines are
+  /// only searched for in previous reads if those already held a newline, so this is when the last
+  /// line completely arrived.
+  uint64_t LastReadTsc() const { return last_read_tsc; }
 
   void WaitForLine(Milliseconds timeout);
 
@@ -57,15 +65,15 @@ struct RollingBuffer {
   const char *__restrict__ limit;
 
   bool search_for_newlines;
+  uint64_t last_read_tsc;
   InputDescriptor input_fd;
-  DefaultAllocator allocator;
+  TaggedAllocator<MemoryTag::kRollingBuffer> allocator;
 
-#ifdef PDP_TRACE_ROLLING_BUFFER
+  /// Counted while the rolling-buffer trace category is enabled.
   enum Counters { kEmptyOptimization, kMinSize, kMoved, kAllocation, kTotal };
-  static constexpr std::array<const char *, kTotal> names{"Empty optimization", "Have min size",
-                                                          "Moved", "Allocation"};
+  static constexpr const char *names[kTotal]{"Empty optimization", "Have min size", "Moved",
+                                              "Allocation"};
   TracingCounter<kTotal> provide_bytes;
-#endif
 };
 
 }  // namespace pdp
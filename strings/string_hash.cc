@@ -0,0 +1,139 @@
+#include "string_hash.h"
+
+#include <immintrin.h>
+
+namespace pdp {
+
+namespace impl {
+
+static inline uint64_t _Load8(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+static inline uint64_t _Load4(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+// Packs up to 8 bytes into an integer. Loads overlap instead of looping over the tail.
+static inline uint64_t _LoadShort(const uint8_t *p, size_t n) {
+  if (n >= 4) {
+    return (_Load4(p) << 32) | _Load4(p + n - 4);
+  } else if (n > 0) {
+    return (uint64_t(p[0]) << 16) | (uint64_t(p[n >> 1]) << 8) | p[n - 1];
+  } else {
+    return 0;
+  }
+}
+
+// Murmur3 finalizer. CRC is linear, this spreads every input bit into the low bucket bits.
+static inline uint32_t _Mix32(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+}  // namespace impl
+
+__attribute__((target("sse4.2"))) uint32_t HashBytesCrc32c(const void *data, size_t n) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  uint64_t a = n;
+  if (PDP_LIKELY(n <= 8)) {
+    a = _mm_crc32_u64(a, impl::_LoadShort(p, n));
+  } else {
+    // Two independent chains hide the latency of the crc32 instruction.
+    uint64_t b = 0x9E3779B97F4A7C15ull;
+    const uint8_t *end = p + n;
+    while (end - p > 16) {
+      a = _mm_crc32_u64(a, impl::_Load8(p));
+      b = _mm_crc32_u64(b, impl::_Load8(p + 8));
+      p += 16;
+    }
+    if (end - p > 8) {
+      a = _mm_crc32_u64(a, impl::_Load8(p));
+    }
+    b = _mm_crc32_u64(b, impl::_Load8(end - 8));
+    a ^= b << 32 | b >> 32;
+    a = _mm_crc32_u64(a, b);
+  }
+  return impl::_Mix32(static_cast<uint32_t>(a ^ (a >> 32)));
+}
+
+__attribute__((target("aes,sse4.1"))) uint32_t HashBytesAes(const void *data, size_t n) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  const __m128i key0 = _mm_set_epi64x(0x243F6A8885A308D3ull, 0x13198A2E03707344ull ^ n);
+  const __m128i key1 = _mm_set_epi64x(0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull);
+
+  __m128i acc;
+  if (PDP_LIKELY(n <= 16)) {
+    uint64_t lo, hi;
+    if (n > 8) {
+      lo = impl::_Load8(p);
+      hi = impl::_Load8(p + n - 8);
+    } else {
+      lo = impl::_LoadShort(p, n);
+      hi = 0;
+    }
+    acc = _mm_xor_si128(_mm_set_epi64x(hi, lo), key0);
+  } else {
+    acc = key0;
+    const uint8_t *last = p + n - 16;
+    while (p < last) {
+      acc = _mm_aesenc_si128(_mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)p)), key1);
+      p += 16;
+    }
+    acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)last));
+  }
+  // One round only mixes within columns, two reach every byte.
+  acc = _mm_aesenc_si128(acc, key1);
+  acc = _mm_aesenc_si128(acc, key0);
+  acc = _mm_aesenc_si128(acc, key1);
+  return _mm_cvtsi128_si32(acc) ^ _mm_extract_epi32(acc, 3);
+}
+
+bool CheckCpuCrc32c() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+
+bool CheckCpuAes() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1");
+}
+
+}  // namespace pdp
+
+using _HashBytesFn = uint32_t (*)(const void *, size_t);
+
+// Runs before any constructor, so every hash in the process is computed by the same function.
+extern "C" _HashBytesFn pdp_resolve_hash_bytes() {
+  if (pdp::CheckCpuAes()) {
+    return pdp::HashBytesAes;
+  } else if (pdp::CheckCpuCrc32c()) {
+    return pdp::HashBytesCrc32c;
+  }
+  return pdp::HashBytesPortable;
+}
+
+namespace pdp {
+
+uint32_t HashBytes(const void *data, size_t n) __attribute__((ifunc("pdp_resolve_hash_bytes")));
+
+const char *HashBytesName() {
+  _HashBytesFn fn = pdp_resolve_hash_bytes();
+  if (fn == HashBytesAes) {
+    return "aes";
+  } else if (fn == HashBytesCrc32c) {
+    return "crc32c";
+  } else {
+    return "portable";
+  }
+}
+
+}  // namespace pdp
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "external/ankerl_hash.h"
+#include "fixed_string.h"
+#include "string_slice.h"
+
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief 32-bit hashes of short byte strings: MI and RPC keys, file paths, breakpoint ids.
+///
+/// The hardware variants may only be called when the matching CheckCpu* function returns true.
+/// Values differ between variants, so a hash must not outlive the process.
+inline uint32_t HashBytesPortable(const void *data, size_t n) {
+  return ankerl::unordered_dense::hash(data, n);
+}
+uint32_t HashBytesCrc32c(const void *data, size_t n);
+uint32_t HashBytesAes(const void *data, size_t n);
+
+bool CheckCpuCrc32c();
+bool CheckCpuAes();
+
+/// @brief Fastest hardware variant this CPU supports, picked once when the binary is loaded.
+///
+/// It is an indirect call. Hash tables keep the inlined HashBytesPortable, which is as fast on
+/// short keys, see bench_string_hash.
+uint32_t HashBytes(const void *data, size_t n);
+const char *HashBytesName();
+
+/// @brief Adapts a HashBytes* function to the hasher interface of emhash8 maps.
+template <uint32_t (*Fn)(const void *, size_t)>
+struct BytesHash {
+  uint32_t operator()(const void *data, size_t n) const { return Fn(data, n); }
+  uint64_t operator()(const StringSlice &s) const { return Fn(s.Begin(), s.Size()); }
+  uint64_t operator()(const FixedString &s) const { return Fn(s.Begin(), s.Size()); }
+};
+
+using StringHash = BytesHash<HashBytes>;
+using PortableStringHash = BytesHash<HashBytesPortable>;
+using Crc32cStringHash = BytesHash<HashBytesCrc32c>;
+using AesStringHash = BytesHash<HashBytesAes>;
+
+}  // namespace pdp
@@ -0,0 +1,233 @@
+#include "async_log.h"
+#include "core/binary_log.h"
+#include "core/log.h"
+#include "data/mpsc_queue.h"
+#include "queue_notifier.h"
+#include "thread.h"
+
+#include <sched.h>
+#include <sys/uio.h>
+#include <climits>
+
+namespace pdp {
+
+namespace {
+
+/// @brief Writes @p text straight to the output, bypassing the queue.
+void WriteNote(const StringSlice &text) {
+  if (IsBinaryLogging()) {
+    // Keep the stream decodable.
+    PackedValue args[2];
+    args[0]._str = text.Begin();
+    args[1]._uint64 = text.Size();
+    char record[max_binary_record_size];
+    const size_t size = EncodeBinaryRecord(raw_text_site, 0, args, kStr, record);
+    WriteLogOutput(StringSlice(record, size));
+  } else {
+    WriteLogOutput(text);
+  }
+}
+
+struct LogSlot {
+  static constexpr size_t max_length = 252;
+
+  uint32_t length;
+  char text[max_length];
+};
+
+static_assert(sizeof(LogSlot) == 256);
+
+struct AsyncLogger : public NonCopyableNonMovable {
+  // Slots which are pushed with a single CAS, longer messages may interleave with other threads.
+  static constexpr size_t max_group = 16;
+  static constexpr size_t max_batch = 64;
+
+  AsyncLogger(LogOverflow policy, size_t num_slots)
+      : policy(policy), queue(num_slots), num_dropped(0), num_reported(0) {
+    pdp_assert(num_slots >= max_group);
+    batch = Allocate<LogSlot>(allocator, max_batch);
+  }
+
+  ~AsyncLogger() { Deallocate<LogSlot>(allocator, batch); }
+
+  void Push(const StringSlice &str) {
+    const char *data = str.Begin();
+    size_t remaining = str.Size();
+    while (remaining > 0) {
+      LogSlot group[max_group];
+      size_t count = 0;
+      while (count < max_group && remaining > 0) {
+        const size_t length = remaining < LogSlot::max_length ? remaining : LogSlot::max_length;
+        group[count].length = length;
+        memcpy(group[count].text, data, length);
+        data += length;
+        remaining -= length;
+        ++count;
+      }
+      PushGroup(group, count);
+    }
+  }
+
+  void PushGroup(LogSlot *group, size_t count) {
+    while (PDP_UNLIKELY(!queue.TryPushBatch(group, count))) {
+      if (policy == LogOverflow::kDrop) {
+        num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      notifier.Notify();
+      sched_yield();
+    }
+    notifier.Notify();
+  }
+
+  void FlusherLoop(std::atomic_bool *is_running) {
+    while (is_running->load(std::memory_order_relaxed)) {
+      if (notifier.WaitForElements(queue, 50_ms)) {
+        LockConsumer();
+        Drain();
+        UnlockConsumer();
+      }
+    }
+    LockConsumer();
+    Drain();
+    UnlockConsumer();
+  }
+
+  /// @brief Consumer side. Only one thread may drain at a time, see LockConsumer().
+  void Drain() {
+    const int fd = GetLogDescriptor();
+    const bool ring = IsRingLogging();
+    ReportDropped();
+
+    struct iovec iov[max_batch];
+    size_t count = queue.PopBatch(batch, max_batch);
+    while (count > 0) {
+      if (ring) {
+        // Copying into the ring is cheaper than any system call.
+        for (size_t i = 0; i < count; ++i) {
+          WriteLogOutput(StringSlice(batch[i].text, batch[i].length));
+        }
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          iov[i].iov_base = batch[i].text;
+          iov[i].iov_len = batch[i].length;
+        }
+        WritevFully(fd, iov, count);
+      }
+      count = queue.PopBatch(batch, max_batch);
+    }
+  }
+
+  void LockConsumer() {
+    while (draining.test_and_set(std::memory_order_acquire)) {
+      sched_yield();
+    }
+  }
+
+  /// @brief Used when crashing. The flusher may hold the lock forever if it is the thread which
+  /// crashed, so give up after a while. Returns whether the lock was taken.
+  bool TryLockConsumer() {
+    for (int i = 0; i < 1000; ++i) {
+      if (!draining.test_and_set(std::memory_order_acquire)) {
+        return true;
+      }
+      sched_yield();
+    }
+    return false;
+  }
+
+  void UnlockConsumer() { draining.clear(std::memory_order_release); }
+
+  uint64_t NumDropped() const { return num_dropped.load(std::memory_order_relaxed); }
+
+  StoppableThread flusher;
+
+ private:
+  void ReportDropped() {
+    const uint64_t dropped = num_dropped.load(std::memory_order_relaxed);
+    if (PDP_UNLIKELY(dropped != num_reported)) {
+      StringBuilder<> builder;
+      builder.AppendFormat("[{} log messages dropped]\n", dropped - num_reported);
+      WriteNote(builder.ToSlice());
+      num_reported = dropped;
+    }
+  }
+
+  static void WritevFully(int fd, struct iovec *iov, size_t count) {
+    while (count > 0) {
+      ssize_t ret = writev(fd, iov, count < IOV_MAX ? count : IOV_MAX);
+      if (PDP_UNLIKELY(ret < 0)) {
+        // Same as WriteFully(), accept the loss and move on.
+        return;
+      }
+      size_t written = BitCast<size_t>(ret);
+      while (count > 0 && written >= iov->iov_len) {
+        written -= iov->iov_len;
+        ++iov;
+        --count;
+      }
+      if (count > 0) {
+        iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+        iov->iov_len -= written;
+      }
+    }
+  }
+
+  LogOverflow policy;
+  MpscQueue<LogSlot> queue;
+  QueueNotifier notifier;
+  std::atomic_uint64_t num_dropped;
+  // Owned by the consumer.
+  uint64_t num_reported;
+  LogSlot *batch;
+  std::atomic_flag draining = ATOMIC_FLAG_INIT;
+  DefaultAllocator allocator;
+};
+
+AsyncLogger *active_logger = nullptr;
+uint64_t last_num_dropped = 0;
+
+void WriteAsync(const StringSlice &str) { active_logger->Push(str); }
+
+void FlushAsync() {
+  if (active_logger->TryLockConsumer()) {
+    active_logger->Drain();
+    active_logger->UnlockConsumer();
+  } else {
+    // Draining next to the consumer would break the single consumer queue.
+    WriteNote("[async log busy, queued messages were not written]\n");
+  }
+}
+
+constexpr LogBackend async_backend{WriteAsync, FlushAsync};
+
+}  // namespace
+
+void StartAsyncLogging(LogOverflow policy, size_t num_slots) {
+  pdp_assert(active_logger == nullptr);
+  DefaultAllocator allocator;
+  active_logger = Allocate<AsyncLogger>(allocator, 1);
+  new (active_logger) AsyncLogger(policy, num_slots);
+  active_logger->flusher.Start(
+      [](std::atomic_bool *is_running) { active_logger->FlusherLoop(is_running); });
+  SetLogBackend(&async_backend);
+}
+
+void StopAsyncLogging() {
+  pdp_assert(active_logger);
+  SetLogBackend(nullptr);
+  // Writes out the messages of producers which still saw the backend.
+  active_logger->flusher.Stop();
+
+  last_num_dropped = active_logger->NumDropped();
+  active_logger->~AsyncLogger();
+  DefaultAllocator allocator;
+  Deallocate<AsyncLogger>(allocator, active_logger);
+  active_logger = nullptr;
+}
+
+uint64_t NumDroppedLogMessages() {
+  return active_logger ? active_logger->NumDropped() : last_num_dropped;
+}
+
+}  // namespace pdp
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief What a producer does when the log ring is full.
+enum class LogOverflow {
+  // Throw the message away and count it. The flusher reports the count in the log.
+  kDrop,
+  // Spin until the flusher frees a slot.
+  kBlock
+};
+
+/// @brief Moves log writes off the calling threads.
+///
+/// Producers copy the formatted message into preallocated slots of a lock-free ring, a background
+/// thread collects the slots and writes them out with writev(2). Messages longer than a slot take
+/// consecutive slots. OnFatalError flushes whatever is still queued from the crashing thread.
+/// Must be called after RedirectLogging().
+void StartAsyncLogging(LogOverflow policy, size_t num_slots = 4096);
+
+/// @brief Writes out the queued messages, stops the flusher and goes back to synchronous writes.
+/// Other threads must have stopped logging, the ring is freed.
+void StopAsyncLogging();
+
+/// @brief Messages thrown away by LogOverflow::kDrop since StartAsyncLogging().
+uint64_t NumDroppedLogMessages();
+
+}  // namespace pdp
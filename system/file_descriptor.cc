@@ -2,9 +2,11 @@
 
 #include "core/check.h"
 #include "tracing/execution_tracer.h"
+#include "tracing/span_tracer.h"
 
 #include <fcntl.h>
 #include <linux/limits.h>
+#include <sys/eventfd.h>
 #include <sys/poll.h>
 #include <unistd.h>
 #include <cerrno>
@@ -137,7 +139,11 @@ size_t InputDescriptor::ReadAvailable(StringVector &out) {
 size_t InputDescriptor::ReadOnce(void *buf, size_t size) {
   pdp_assert(size > 0);
   ssize_t ret = g_recorder.SyscallRead(fd, buf, size);
-  if (ret <= 0) {
+  if (ret == 0) {
+    reached_end = true;
+    return 0;
+  }
+  if (ret < 0) {
     if (PDP_UNLIKELY(errno != EAGAIN && errno != EWOULDBLOCK)) {
       Check(ret, "read");
     }
@@ -152,6 +158,7 @@ bool OutputDescriptor::WaitForOutput(Milliseconds timeout) {
 
 bool OutputDescriptor::WriteExactly(const void *buf, size_t bytes, Milliseconds timeout) {
   pdp_assert(bytes > 0);
+  PDP_TRACE_SPAN("OutputDescriptor::WriteExactly", bytes);
 
   Stopwatch stopwatch;
   size_t num_written = 0;
@@ -177,7 +184,11 @@ bool OutputDescriptor::WriteExactly(const void *buf, size_t bytes, Milliseconds
 
 size_t OutputDescriptor::WriteOnce(const void *buf, size_t size) {
   pdp_assert(size > 0);
-  ssize_t ret = g_recorder.SyscallWrite(fd, buf, size);
+  ssize_t ret = 0;
+  do {
+    // Interrupted before anything was written, a partial message would corrupt the stream.
+    ret = g_recorder.SyscallWrite(fd, buf, size);
+  } while (PDP_UNLIKELY(ret < 0 && errno == EINTR));
   if (ret <= 0) {
     if (PDP_UNLIKELY(errno != EAGAIN && errno != EWOULDBLOCK)) {
       Check(ret, "read");
@@ -187,4 +198,37 @@ size_t OutputDescriptor::WriteOnce(const void *buf, size_t size) {
   return BitCast<size_t>(ret);
 }
 
+EventDescriptor::EventDescriptor() : FileDescriptor() {
+  fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  CheckFatal(fd, "eventfd");
+}
+
+void EventDescriptor::Notify() {
+  uint64_t one = 1;
+  ssize_t ret = write(fd, &one, sizeof(one));
+  if (PDP_UNLIKELY(ret < 0 && errno != EAGAIN)) {
+    Check(ret, "EventDescriptor::Notify");
+  }
+}
+
+bool EventDescriptor::WaitForNotify(Milliseconds timeout) {
+  struct pollfd poll_args;
+  poll_args.fd = fd;
+  poll_args.events = POLLIN;
+  poll_args.revents = 0;
+  return poll(&poll_args, 1, timeout.Get()) > 0;
+}
+
+uint64_t EventDescriptor::Drain() {
+  uint64_t count = 0;
+  ssize_t ret = read(fd, &count, sizeof(count));
+  if (ret < 0) {
+    if (PDP_UNLIKELY(errno != EAGAIN)) {
+      Check(ret, "EventDescriptor::Drain");
+    }
+    return 0;
+  }
+  return count;
+}
+
 }  // namespace pdp
@@ -43,6 +43,12 @@ struct InputDescriptor : public FileDescriptor {
   size_t ReadAvailable(StringVector &out);
 
   size_t ReadOnce(void *buf, size_t size);
+
+  /// @brief Whether a read found the write end closed, e.g. the child process exited.
+  bool ReachedEnd() const { return reached_end; }
+
+ private:
+  bool reached_end = false;
 };
 
 struct OutputDescriptor : public FileDescriptor {
@@ -54,4 +60,17 @@ struct OutputDescriptor : public FileDescriptor {
   size_t WriteOnce(const void *buf, size_t size);
 };
 
+/// @brief Wakeup channel between threads backed by an eventfd. Notifications are not routed
+/// through the execution tracer, they never cross a process boundary.
+struct EventDescriptor : public FileDescriptor {
+  EventDescriptor();
+
+  void Notify();
+  bool WaitForNotify(Milliseconds timeout);
+
+  /// @brief Consumes all pending notifications.
+  /// @return The number of notifications since the last call, zero if there were none.
+  uint64_t Drain();
+};
+
 }  // namespace pdp
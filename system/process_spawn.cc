@@ -0,0 +1,251 @@
+#include "process_spawn.h"
+
+#include "core/check.h"
+#include "data/allocator.h"
+#include "tracing/execution_tracer.h"
+
+#include <fcntl.h>
+#include <linux/limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+
+extern char **environ;
+
+namespace pdp {
+
+SpawnActions::SpawnActions() : num_actions(0), death_signal(0) {}
+
+void SpawnActions::AddDup2(int fd, int target_fd) {
+  pdp_assert(num_actions < max_actions);
+  actions[num_actions++] = Action{Kind::kDup2, fd, target_fd, 0, nullptr};
+}
+
+void SpawnActions::AddClose(int fd) {
+  pdp_assert(num_actions < max_actions);
+  actions[num_actions++] = Action{Kind::kClose, fd, -1, 0, nullptr};
+}
+
+void SpawnActions::AddOpen(int target_fd, const char *path, int flags) {
+  pdp_assert(num_actions < max_actions);
+  actions[num_actions++] = Action{Kind::kOpen, -1, target_fd, flags, path};
+}
+
+void SpawnActions::SetDeathSignal(int signal) { death_signal = signal; }
+
+namespace impl {
+
+struct _SpawnRequest {
+  const SpawnActions *actions;
+  const char *path;
+  const char *const *argv;
+  bool search_path;
+
+  pid_t parent_pid;
+  sigset_t parent_mask;
+  // Written by the child, which shares the address space of the parent.
+  volatile int child_error;
+
+  static pid_t Spawn(void *user_data);
+
+ private:
+  static bool FindInPath(const char *file, char *out);
+
+  static int ChildEntry(void *user_data);
+  static void ResetSignalHandlers();
+  static bool RunActions(const _SpawnRequest *request);
+
+  static constexpr size_t child_stack_size = 64_KB;
+};
+
+bool _SpawnRequest::FindInPath(const char *file, char *out) {
+  const size_t file_length = strlen(file);
+  if (strchr(file, '/')) {
+    if (file_length >= PATH_MAX) {
+      errno = ENAMETOOLONG;
+      return false;
+    }
+    memcpy(out, file, file_length + 1);
+    return true;
+  }
+
+  const char *dirs = getenv("PATH");
+  if (!dirs) {
+    dirs = "/usr/local/bin:/usr/bin:/bin";
+  }
+  while (*dirs) {
+    const char *end = strchrnul(dirs, ':');
+    size_t dir_length = end - dirs;
+    if (dir_length + file_length + 2 <= PATH_MAX) {
+      if (dir_length == 0) {
+        out[dir_length++] = '.';
+      } else {
+        memcpy(out, dirs, dir_length);
+      }
+      out[dir_length] = '/';
+      memcpy(out + dir_length + 1, file, file_length + 1);
+      if (access(out, X_OK) == 0) {
+        return true;
+      }
+    }
+    dirs = *end ? end + 1 : end;
+  }
+  errno = ENOENT;
+  return false;
+}
+
+pid_t _SpawnRequest::Spawn(void *user_data) {
+  auto *request = static_cast<_SpawnRequest *>(user_data);
+
+  char resolved_path[PATH_MAX];
+  if (request->search_path) {
+    if (!FindInPath(request->path, resolved_path)) {
+      return -1;
+    }
+    request->path = resolved_path;
+  }
+
+  void *stack = mmap(nullptr, child_stack_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (stack == MAP_FAILED) {
+    return -1;
+  }
+
+  // No signal handler of the parent may run on the child stack before it is reset.
+  sigset_t all_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_BLOCK, &all_signals, &request->parent_mask);
+
+  request->parent_pid = getpid();
+  request->child_error = 0;
+
+  // The parent is suspended until the child calls exec or exits.
+  byte *stack_top = static_cast<byte *>(stack) + child_stack_size;
+  pid_t pid = clone(ChildEntry, stack_top, CLONE_VM | CLONE_VFORK | SIGCHLD, request);
+  int clone_error = errno;
+
+  pthread_sigmask(SIG_SETMASK, &request->parent_mask, nullptr);
+  munmap(stack, child_stack_size);
+
+  if (PDP_UNLIKELY(pid < 0)) {
+    errno = clone_error;
+    return -1;
+  }
+  if (PDP_UNLIKELY(request->child_error != 0)) {
+    // The child never made it to exec and has already exited.
+    int status;
+    waitpid(pid, &status, 0);
+    errno = request->child_error;
+    return -1;
+  }
+  return pid;
+}
+
+void _SpawnRequest::ResetSignalHandlers() {
+  struct sigaction default_action;
+  memset(&default_action, 0, sizeof(default_action));
+  default_action.sa_handler = SIG_DFL;
+
+  for (int signal = 1; signal < _NSIG; ++signal) {
+    struct sigaction current;
+    if (sigaction(signal, nullptr, &current) == 0 && current.sa_handler != SIG_DFL &&
+        current.sa_handler != SIG_IGN) {
+      sigaction(signal, &default_action, nullptr);
+    }
+  }
+}
+
+bool _SpawnRequest::RunActions(const _SpawnRequest *request) {
+  const SpawnActions *actions = request->actions;
+  if (actions->death_signal != 0) {
+    if (prctl(PR_SET_PDEATHSIG, actions->death_signal) < 0) {
+      return false;
+    }
+    // The parent died before the death signal was armed.
+    if (getppid() != request->parent_pid) {
+      errno = ESRCH;
+      return false;
+    }
+  }
+
+  for (unsigned i = 0; i < actions->num_actions; ++i) {
+    const SpawnActions::Action &action = actions->actions[i];
+    switch (action.kind) {
+      case SpawnActions::Kind::kDup2:
+        if (action.fd == action.target_fd) {
+          // dup2 would be a no-op and the descriptor would still be closed on exec.
+          int flags = fcntl(action.fd, F_GETFD);
+          if (flags < 0 || fcntl(action.fd, F_SETFD, flags & ~FD_CLOEXEC) < 0) {
+            return false;
+          }
+        } else if (dup2(action.fd, action.target_fd) < 0) {
+          return false;
+        }
+        break;
+
+      case SpawnActions::Kind::kClose:
+        close(action.fd);
+        break;
+
+      case SpawnActions::Kind::kOpen: {
+        int fd = open(action.path, action.flags, 0644);
+        if (fd < 0) {
+          return false;
+        }
+        if (fd != action.target_fd) {
+          if (dup2(fd, action.target_fd) < 0) {
+            return false;
+          }
+          close(fd);
+        }
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+// Runs on a private stack inside the address space of the parent. Only raw system calls are
+// allowed from here on: no allocations, no logging and no locks.
+int _SpawnRequest::ChildEntry(void *user_data) {
+  auto *request = static_cast<_SpawnRequest *>(user_data);
+
+  ResetSignalHandlers();
+  if (RunActions(request)) {
+    sigprocmask(SIG_SETMASK, &request->parent_mask, nullptr);
+    execve(request->path, const_cast<char *const *>(request->argv), environ);
+  }
+  request->child_error = errno;
+  _exit(127);
+}
+
+}  // namespace impl
+
+static pid_t Spawn(const SpawnActions &actions, const char *path, const char *const *argv,
+                   bool search_path) {
+  pdp_assert(argv && argv[0]);
+
+  impl::_SpawnRequest request;
+  request.actions = &actions;
+  request.path = path;
+  request.argv = argv;
+  request.search_path = search_path;
+  return g_recorder.SyscallSpawn(impl::_SpawnRequest::Spawn, &request);
+}
+
+pid_t SpawnProcess(const SpawnActions &actions, const char *path, const char *const *argv) {
+  return Spawn(actions, path, argv, false);
+}
+
+pid_t SpawnProcessInPath(const SpawnActions &actions, const char *file, const char *const *argv) {
+  return Spawn(actions, file, argv, true);
+}
+
+}  // namespace pdp
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <sys/types.h>
+#include <cstddef>
+
+namespace pdp {
+
+namespace impl {
+struct _SpawnRequest;
+}
+
+/// @brief Describes how the standard descriptors of a spawned child are wired up.
+/// The actions are carried out in the child, in order, right before it calls exec.
+struct SpawnActions {
+  SpawnActions();
+
+  void AddDup2(int fd, int target_fd);
+  void AddClose(int fd);
+  void AddOpen(int target_fd, const char *path, int flags);
+
+  /// @brief Signal delivered to the child when the spawning process dies (PR_SET_PDEATHSIG).
+  void SetDeathSignal(int signal);
+
+ private:
+  friend struct impl::_SpawnRequest;
+
+  enum class Kind : unsigned char { kDup2, kClose, kOpen };
+
+  struct Action {
+    Kind kind;
+    int fd;
+    int target_fd;
+    int flags;
+    const char *path;
+  };
+
+  static constexpr size_t max_actions = 8;
+
+  Action actions[max_actions];
+  unsigned num_actions;
+  int death_signal;
+};
+
+/// @brief Starts `path` with the given null-terminated argument list.
+///
+/// Unlike fork the child shares the address space of the parent until exec (vfork semantics),
+/// so the cost of spawning does not grow with the resident set size. The call goes through
+/// `g_recorder` and is recorded/replayed like a fork.
+/// @return The pid of the child or -1 with `errno` set if the child could not be started.
+pid_t SpawnProcess(const SpawnActions &actions, const char *path, const char *const *argv);
+
+/// @brief Same as SpawnProcess, but `file` is searched for in the directories listed in PATH.
+pid_t SpawnProcessInPath(const SpawnActions &actions, const char *file, const char *const *argv);
+
+}  // namespace pdp
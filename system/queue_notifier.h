@@ -0,0 +1,62 @@
+#pragma once
+
+#include "data/non_copyable.h"
+#include "file_descriptor.h"
+#include "time_units.h"
+
+#include <atomic>
+
+namespace pdp {
+
+/// @brief Lets the consumer of a lock-free queue (SpscQueue, MpscQueue) sleep until producers
+/// publish something.
+///
+/// The consumer announces that it is about to sleep before rechecking the queue, so producers
+/// only pay for the eventfd write when somebody is actually waiting. The descriptor can also be
+/// added to a PollTable, in which case the producers must use NotifyAlways().
+struct QueueNotifier : public NonCopyableNonMovable {
+  QueueNotifier() : is_waiting(false) {}
+
+  int GetDescriptor() const { return event.GetDescriptor(); }
+
+  /// @brief Producer side, call after publishing elements.
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (is_waiting.load(std::memory_order_relaxed)) {
+      event.Notify();
+    }
+  }
+
+  void NotifyAlways() { event.Notify(); }
+
+  /// @brief Consumer side, blocks until the queue is non-empty or the timeout expires.
+  /// @return True if the queue has elements.
+  template <typename Queue>
+  bool WaitForElements(Queue &queue, Milliseconds timeout) {
+    Stopwatch stopwatch;
+    while (queue.Empty()) {
+      const Milliseconds remaining = timeout - stopwatch.Elapsed();
+      if (remaining <= 0_ms) {
+        return false;
+      }
+      is_waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (queue.Empty()) {
+        event.WaitForNotify(remaining);
+      }
+      is_waiting.store(false, std::memory_order_relaxed);
+      // May consume a stale notification for elements which were already popped, hence the loop.
+      event.Drain();
+    }
+    return true;
+  }
+
+  /// @brief Consumes the pending wakeups after the descriptor was reported by poll.
+  void Acknowledge() { event.Drain(); }
+
+ private:
+  EventDescriptor event;
+  std::atomic_bool is_waiting;
+};
+
+}  // namespace pdp
@@ -45,7 +45,11 @@ static void ExpandAndInvoke(Fun &f, Pack<Pargs...> &pack, Eargs &...exp) {
 
 template <typename Fun, typename... Args>
 static void Invoke(Fun &f, Pack<Args...> &pack) {
-  ExpandAndInvoke(f, pack.GetTail(), pack.GetHead());
+  if constexpr (sizeof...(Args) > 1) {
+    ExpandAndInvoke(f, pack.GetTail(), pack.GetHead());
+  } else {
+    f(pack.GetHead());
+  }
 }
 
 template <typename Fun, typename... Args>
@@ -62,7 +66,9 @@ static void *ThreadEntry(void *user) {
   using Data = PthreadData<Fun, T, Args...>;
   Data *p = (Data *)user;
   Invoke(p->fun, p->args);
-  free(p);
+  p->~Data();
+  DefaultAllocator allocator;
+  Deallocate<Data>(allocator, p);
   return NULL;
 }
 
@@ -70,13 +76,19 @@ template <typename Fun>
 static void *ThreadEntry(void *user) {
   Fun *p = (Fun *)user;
   (*p)();
-  free(p);
+  p->~Fun();
+  DefaultAllocator allocator;
+  Deallocate<Fun>(allocator, p);
   return NULL;
 }
 
 // TODO: add template of arguments?
 struct Thread {
-  Thread() : is_joinable(false) {}
+  Thread() {
+#ifdef PDP_ENABLE_ASSERT
+    is_joinable = false;
+#endif
+  }
 
   ~Thread() { pdp_assert(!is_joinable); }
 
@@ -107,12 +119,14 @@ struct Thread {
   void Wait() {
     pdp_assert(is_joinable);
     pthread_join(thread, NULL);
+#ifdef PDP_ENABLE_ASSERT
     is_joinable = false;
+#endif
   }
 
  private:
   pthread_t thread;
-#if PDP_ENABLE_ASSERT
+#ifdef PDP_ENABLE_ASSERT
   bool is_joinable;
 #endif
   DefaultAllocator allocator;
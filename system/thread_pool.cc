@@ -0,0 +1,189 @@
+#include "thread_pool.h"
+
+#include "core/check.h"
+#include "core/log.h"
+#include "tracing/execution_tracer.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace pdp {
+
+thread_local ThreadPool::Worker *ThreadPool::current_worker = nullptr;
+
+ThreadPool::Worker::Worker(ThreadPool *p, unsigned i)
+    : pool(p), index(i), random_state(2654435761u * (i + 1)), deque(max_queued_tasks) {}
+
+ThreadPool::ThreadPool(unsigned requested_workers)
+    : num_workers(g_recorder.IsNormal() ? requested_workers : 0),
+      workers(nullptr),
+      submissions(max_queued_tasks),
+      is_running(true),
+      completed(nullptr),
+      num_pending(0),
+      work_semaphore(-1) {
+  if (num_workers == 0) {
+    return;
+  }
+
+  work_semaphore = eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE);
+  CheckFatal(work_semaphore, "ThreadPool eventfd");
+
+  workers = Allocate<Worker>(allocator, num_workers);
+  for (unsigned i = 0; i < num_workers; ++i) {
+    new (workers + i) Worker(this, i);
+  }
+  for (unsigned i = 0; i < num_workers; ++i) {
+    Worker *worker = workers + i;
+    workers[i].thread.Start([worker]() { WorkerLoop(worker); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  if (NumPending() > 0) {
+    pdp_warning("Thread pool destroyed with {} pending tasks", NumPending());
+  }
+  if (num_workers == 0) {
+    return;
+  }
+
+  is_running.store(false);
+  WakeWorkers(num_workers);
+  for (unsigned i = 0; i < num_workers; ++i) {
+    workers[i].thread.Wait();
+    workers[i].~Worker();
+  }
+  Deallocate<Worker>(allocator, workers);
+  Check(close(work_semaphore), "ThreadPool close");
+}
+
+void ThreadPool::Submit(PoolTask *task) {
+  num_pending.fetch_add(1, std::memory_order_relaxed);
+  if (IsInline()) {
+    task->run(task);
+    num_pending.fetch_sub(1, std::memory_order_relaxed);
+    task->complete(task);
+    return;
+  }
+
+  Worker *worker = current_worker;
+  WorkStealingDeque<PoolTask> &deque = worker ? worker->deque : submissions;
+  while (PDP_UNLIKELY(!deque.Push(task))) {
+    // Workers are saturated, help them out.
+    PoolTask *newest = deque.Pop();
+    if (newest) {
+      Execute(newest);
+    }
+  }
+  WakeWorkers(1);
+}
+
+void ThreadPool::RegisterForPoll(PollTable &table) {
+  if (!IsInline()) {
+    table.Register(completions_event.GetDescriptor());
+  }
+}
+
+void ThreadPool::OnPollResults(PollTable &table) {
+  if (!IsInline() && table.HasInputEvents(completions_event.GetDescriptor())) {
+    DrainCompletions();
+  }
+}
+
+void ThreadPool::DrainCompletions() {
+  // Acknowledge first, completions pushed from now on will trigger another wakeup.
+  completions_event.Drain();
+  PoolTask *list = completed.exchange(nullptr, std::memory_order_acquire);
+
+  // The list is in LIFO order, restore the order of completion.
+  PoolTask *reversed = nullptr;
+  while (list) {
+    PoolTask *next = list->next;
+    list->next = reversed;
+    reversed = list;
+    list = next;
+  }
+
+  while (reversed) {
+    PoolTask *next = reversed->next;
+    pdp_assert(NumPending() > 0);
+    num_pending.fetch_sub(1, std::memory_order_relaxed);
+    // The callback is allowed to release the task.
+    reversed->complete(reversed);
+    reversed = next;
+  }
+}
+
+void ThreadPool::Execute(PoolTask *task) {
+  task->run(task);
+
+  PoolTask *head = completed.load(std::memory_order_relaxed);
+  do {
+    task->next = head;
+  } while (!completed.compare_exchange_weak(head, task, std::memory_order_release,
+                                            std::memory_order_relaxed));
+  if (head == nullptr) {
+    // First completion since the main thread last looked.
+    completions_event.Notify();
+  }
+}
+
+PoolTask *ThreadPool::FindTask(Worker *worker) {
+  PoolTask *task = worker->deque.Pop();
+  if (task) {
+    return task;
+  }
+
+  task = submissions.Steal();
+  if (task) {
+    return task;
+  }
+
+  // xorshift32 for picking the first victim.
+  uint32_t x = worker->random_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  worker->random_state = x;
+
+  for (unsigned i = 0; i < num_workers; ++i) {
+    unsigned victim = (x + i) % num_workers;
+    if (victim != worker->index) {
+      task = workers[victim].deque.Steal();
+      if (task) {
+        return task;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void ThreadPool::WakeWorkers(uint64_t count) {
+  ssize_t ret = write(work_semaphore, &count, sizeof(count));
+  Check(ret, "ThreadPool wake");
+}
+
+void ThreadPool::WaitForWork() {
+  uint64_t count;
+  ssize_t ret;
+  do {
+    ret = read(work_semaphore, &count, sizeof(count));
+  } while (ret < 0 && errno == EINTR);
+  Check(ret, "ThreadPool wait");
+}
+
+void ThreadPool::WorkerLoop(Worker *worker) {
+  current_worker = worker;
+  ThreadPool *pool = worker->pool;
+  while (pool->is_running.load(std::memory_order_relaxed)) {
+    PoolTask *task = pool->FindTask(worker);
+    if (task) {
+      pool->Execute(task);
+    } else {
+      pool->WaitForWork();
+    }
+  }
+}
+
+}  // namespace pdp
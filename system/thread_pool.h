@@ -0,0 +1,95 @@
+#pragma once
+
+#include "data/allocator.h"
+#include "data/non_copyable.h"
+#include "data/work_stealing_deque.h"
+#include "file_descriptor.h"
+#include "poll_table.h"
+#include "thread.h"
+
+#include <atomic>
+
+namespace pdp {
+
+/// @brief Unit of work for the ThreadPool. The storage is owned by the submitter and must stay
+/// alive until the completion callback is invoked.
+struct PoolTask {
+  using Callback = void (*)(PoolTask *);
+
+  PoolTask(Callback run, Callback complete) : run(run), complete(complete), next(nullptr) {}
+
+  // Invoked on a worker thread.
+  Callback run;
+  // Invoked on the main thread once `run` has returned.
+  Callback complete;
+  PoolTask *next;
+};
+
+/// @brief Work-stealing pool for offloading CPU-heavy or blocking work from the main loop.
+///
+/// Tasks are submitted from the main thread or from tasks already running on the pool. Every
+/// worker owns a Chase-Lev deque for the tasks it spawns and steals from the submission deque of
+/// the main thread or from the other workers when it runs dry. Finished tasks are collected on a
+/// lock-free list and the main loop is woken up through an eventfd, where the completion
+/// callbacks are invoked.
+///
+/// Worker threads are not deterministic, so while the execution is recorded or replayed (or
+/// when there are no workers) tasks are run inline by Submit().
+struct ThreadPool : public NonCopyableNonMovable {
+  ThreadPool(unsigned num_workers);
+  ~ThreadPool();
+
+  bool IsInline() const { return num_workers == 0; }
+
+  void Submit(PoolTask *task);
+
+  /// @brief Number of submitted tasks whose completion callback has not been invoked yet.
+  size_t NumPending() const { return num_pending.load(std::memory_order_relaxed); }
+
+  int GetDescriptor() const { return completions_event.GetDescriptor(); }
+
+  void RegisterForPoll(PollTable &table);
+  void OnPollResults(PollTable &table);
+
+  /// @brief Invokes the completion callbacks of all finished tasks.
+  void DrainCompletions();
+
+ private:
+  struct Worker {
+    Worker(ThreadPool *pool, unsigned index);
+
+    ThreadPool *pool;
+    unsigned index;
+    uint32_t random_state;
+    WorkStealingDeque<PoolTask> deque;
+    Thread thread;
+  };
+
+  static void WorkerLoop(Worker *worker);
+
+  static thread_local Worker *current_worker;
+
+  PoolTask *FindTask(Worker *worker);
+  void Execute(PoolTask *task);
+  void WakeWorkers(uint64_t count);
+  void WaitForWork();
+
+  static constexpr size_t max_queued_tasks = 1024;
+
+  unsigned num_workers;
+  Worker *workers;
+  // Tasks submitted by the main thread.
+  WorkStealingDeque<PoolTask> submissions;
+
+  std::atomic_bool is_running;
+  std::atomic<PoolTask *> completed;
+  std::atomic_size_t num_pending;
+
+  // Blocking semaphore, one count per submitted task.
+  int work_semaphore;
+  EventDescriptor completions_event;
+
+  DefaultAllocator allocator;
+};
+
+}  // namespace pdp
@@ -1,7 +1,8 @@
 #pragma once
 
+#include "core/clock.h"
+
 #include <cstdint>
-#include <ctime>
 
 namespace pdp {
 
@@ -44,19 +45,15 @@ struct Milliseconds {
 struct Stopwatch {
   Stopwatch() { Reset(); }
 
-  void Reset() { clock_gettime(CLOCK_MONOTONIC, &last_checkpoint); }
+  void Reset() { last_checkpoint = ReadTsc(); }
 
   Milliseconds Elapsed() const {
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
-
-    int64_t elapsed_ms = (now.tv_sec - last_checkpoint.tv_sec) * 1'000 +
-                         (now.tv_nsec - last_checkpoint.tv_nsec) / 1'000'000;
-    return Milliseconds(elapsed_ms);
+    const uint64_t elapsed_ns = TscTicksToNs(ReadTsc() - last_checkpoint);
+    return Milliseconds(elapsed_ns / 1'000'000);
   }
 
  private:
-  struct timespec last_checkpoint;
+  uint64_t last_checkpoint;
 };
 
 // @brief Milliseconds (ms)
@@ -0,0 +1,175 @@
+#include "data/arena.h"
+#include "data/pool_allocator.h"
+#include "data/vector.h"
+#include "parser/mi_parser.h"
+#include "parser/rpc_parser.h"
+#include "strings/string_builder.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace pdp;
+
+// Compares PoolAllocator and MallocAllocator on the allocation patterns of the MI and RPC
+// parsers, then runs the real parsers with whatever DefaultAllocator this build uses.
+// Usage: bench_allocators [rounds]
+
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+const char mi_record[] =
+    "bkpt={number=\"1\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\","
+    "addr=\"0x0000000000401136\","
+    "func=\"main\",file=\"main.c\",fullname=\"/home/user/src/main.c\",line=\"5\","
+    "thread-groups=[\"i1\"],times=\"0\",original-location=\"main.c:5\"},"
+    "frame={addr=\"0x0000000000401136\",func=\"main\",args=[{name=\"argc\",value=\"1\"},"
+    "{name=\"argv\",value=\"0x7fffffffe0b8\"}],file=\"main.c\",fullname=\"/home/user/src/main.c\","
+    "line=\"5\",arch=\"i386:x86-64\"}";
+
+// [2, "nvim_buf_lines_event", [1, 0, 10, 10, ["line1", "line2"]]]
+const unsigned char rpc_message[] = {
+    0x93, 0x02, 0xB4, 'n',  'v',  'i',  'm',  '_',  'b', 'u', 'f', '_', 'l', 'i',
+    'n',  'e',  's',  '_',  'e',  'v',  'e',  'n',  't', 0x95, 0x01, 0x00, 0x0A, 0x0A,
+    0x92, 0xA5, 'l',  'i',  'n',  'e',  '1',  0xA5, 'l', 'i', 'n', 'e', '2'};
+
+/// @brief One MI record: the second pass arena, a few short lived strings for the fields the
+/// handler keeps and a message which is built for the editor.
+template <typename Alloc>
+size_t MiShapedRound() {
+  Arena<Alloc> arena(1024);
+  size_t checksum = 0;
+  for (int i = 0; i < 24; ++i) {
+    checksum += reinterpret_cast<uintptr_t>(arena.Allocate(24)) & 0xff;
+  }
+
+  Alloc alloc;
+  void *strings[12];
+  for (int i = 0; i < 12; ++i) {
+    strings[i] = alloc.AllocateRaw(8 + i * 5);
+  }
+  StringBuilder<Alloc> builder;
+  for (int i = 0; i < 12; ++i) {
+    builder.Append(StringSlice("/home/user/src/main.c:"));
+    builder.Append(i);
+  }
+  checksum += builder.Size();
+  for (int i = 0; i < 12; ++i) {
+    alloc.DeallocateRaw(strings[i]);
+  }
+  return checksum;
+}
+
+/// @brief One RPC message: element and hash arrays for every container and a string per leaf.
+template <typename Alloc>
+size_t RpcShapedRound() {
+  Alloc alloc;
+  size_t checksum = 0;
+  void *containers[6];
+  for (int i = 0; i < 6; ++i) {
+    containers[i] = alloc.AllocateRaw((i + 2) * sizeof(void *) + (i + 2) * sizeof(uint32_t));
+  }
+  Vector<char, Alloc> lines;
+  for (int i = 0; i < 40; ++i) {
+    for (char c : "line of text ") {
+      lines += c;
+    }
+  }
+  checksum += lines.Size();
+  for (int i = 0; i < 6; ++i) {
+    alloc.DeallocateRaw(containers[i]);
+  }
+  // An occasional big buffer update.
+  void *big = alloc.AllocateRaw(64 * 1024);
+  checksum += reinterpret_cast<uintptr_t>(big) & 0xff;
+  alloc.DeallocateRaw(big);
+  return checksum;
+}
+
+double TimeShaped(size_t (*round)(), int rounds) {
+  size_t checksum = 0;
+  uint64_t begin = NowNs();
+  for (int r = 0; r < rounds; ++r) {
+    checksum += round();
+  }
+  uint64_t elapsed = NowNs() - begin;
+  if (checksum == 0) {
+    printf("unexpected checksum\n");
+  }
+  return double(elapsed) / rounds;
+}
+
+double TimeMiParser(int rounds) {
+  ChainedArena<> scratch;
+  StringSlice input(mi_record);
+  size_t checksum = 0;
+  uint64_t begin = NowNs();
+  for (int r = 0; r < rounds; ++r) {
+    auto ptr = ParseMiResults(input, scratch);
+    checksum += GdbExprView(ptr.Get()).Count();
+  }
+  uint64_t elapsed = NowNs() - begin;
+  return checksum ? double(elapsed) / rounds : 0;
+}
+
+double TimeRpcParser(int rounds) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return 0;
+  }
+  // Stay below the pipe capacity so the writes never block.
+  const int batch = 512;
+  ByteStream stream(fds[0]);
+  size_t checksum = 0;
+  uint64_t begin = NowNs();
+  for (int r = 0; r < rounds; r += batch) {
+    for (int i = 0; i < batch; ++i) {
+      if (write(fds[1], rpc_message, sizeof(rpc_message)) != sizeof(rpc_message)) {
+        return 0;
+      }
+    }
+    for (int i = 0; i < batch; ++i) {
+      RpcChunkArrayPass pass(stream);
+      StrongTypedView expr = pass.Parse();
+      checksum += expr[2].Count();
+      ChunkHandle chunks = pass.ReleaseChunks();
+    }
+  }
+  uint64_t elapsed = NowNs() - begin;
+  close(fds[0]);
+  close(fds[1]);
+  return checksum ? double(elapsed) / rounds : 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 200'000;
+
+  printf("%16s %16s %16s\n", "workload", "malloc ns/op", "pool ns/op");
+  printf("%16s %16.1f %16.1f\n", "mi-shaped", TimeShaped(MiShapedRound<MallocAllocator>, rounds),
+         TimeShaped(MiShapedRound<PoolAllocator>, rounds));
+  printf("%16s %16.1f %16.1f\n", "rpc-shaped", TimeShaped(RpcShapedRound<MallocAllocator>, rounds),
+         TimeShaped(RpcShapedRound<PoolAllocator>, rounds));
+
+#if defined(PDP_POOL_ALLOCATIONS)
+  const char *name = "pool";
+#elif defined(PDP_TRACE_ALLOCATIONS)
+  const char *name = "tracing";
+#else
+  const char *name = "malloc";
+#endif
+  printf("\nParsers with the %s DefaultAllocator:\n", name);
+  printf("%16s %16.1f ns/op\n", "mi parser", TimeMiParser(rounds));
+  printf("%16s %16.1f ns/op\n", "rpc parser", TimeRpcParser(rounds));
+
+  fflush(stdout);
+  PrintPoolAllocatorReport(STDOUT_FILENO);
+  return 0;
+}
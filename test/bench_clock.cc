@@ -0,0 +1,57 @@
+#include "core/clock.h"
+#include "core/log.h"
+
+#include <fcntl.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace pdp;
+
+// Measures the cost of reading the time: the system clocks, the raw TSC and its conversions, and
+// of a whole log line written to /dev/null. Usage: bench_clock [iterations]
+
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+uint64_t ReadRealtime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+template <typename Fn>
+void Measure(const char *name, int iterations, Fn fn) {
+  uint64_t sink = 0;
+  uint64_t begin = NowNs();
+  for (int i = 0; i < iterations; ++i) {
+    sink += fn();
+  }
+  uint64_t elapsed = NowNs() - begin;
+  printf("%-24s %10.1f ns/op  (%llu)\n", name, double(elapsed) / iterations,
+         static_cast<unsigned long long>(sink & 1));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 10'000'000;
+  printf("invariant TSC: %s\n", HasInvariantTsc() ? "yes" : "no");
+
+  Measure("clock_gettime(REALTIME)", iterations, ReadRealtime);
+  Measure("ReadTsc", iterations, ReadTsc);
+  Measure("MonotonicNs", iterations, MonotonicNs);
+  Measure("RealtimeNs", iterations, RealtimeNs);
+
+  RedirectLogging(open("/dev/null", O_WRONLY));
+  Measure("pdp_info", iterations / 10, []() {
+    pdp_info("value {}", 42);
+    return 0;
+  });
+  return 0;
+}
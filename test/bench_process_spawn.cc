@@ -0,0 +1,83 @@
+#include "data/allocator.h"
+#include "system/process_spawn.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+using namespace pdp;
+
+// Compares fork+exec against SpawnProcess as the resident set of the parent grows.
+// Usage: bench_process_spawn [iterations]
+
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+const char *const true_argv[] = {"true", nullptr};
+const char *true_path = "/bin/true";
+
+void WaitChild(pid_t pid) {
+  int status;
+  waitpid(pid, &status, 0);
+}
+
+uint64_t MeasureFork(int iterations) {
+  uint64_t begin = NowNs();
+  for (int i = 0; i < iterations; ++i) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      execv(true_path, const_cast<char *const *>(true_argv));
+      _exit(127);
+    }
+    WaitChild(pid);
+  }
+  return (NowNs() - begin) / iterations;
+}
+
+uint64_t MeasureSpawn(int iterations) {
+  SpawnActions actions;
+  uint64_t begin = NowNs();
+  for (int i = 0; i < iterations; ++i) {
+    pid_t pid = SpawnProcess(actions, true_path, true_argv);
+    WaitChild(pid);
+  }
+  return (NowNs() - begin) / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 200;
+  const size_t rss_steps[] = {0, 64_MB, 256_MB, 1_GB};
+
+  printf("%10s %14s %14s\n", "rss", "fork+exec(us)", "spawn(us)");
+  for (size_t rss : rss_steps) {
+    void *ballast = nullptr;
+    if (rss > 0) {
+      ballast = mmap(nullptr, rss, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ballast == MAP_FAILED) {
+        printf("%10zu MB: cannot map ballast\n", rss / 1_MB);
+        continue;
+      }
+      // Touch every page, so that fork has to copy the page tables.
+      memset(ballast, 0xAB, rss);
+    }
+
+    uint64_t fork_ns = MeasureFork(iterations);
+    uint64_t spawn_ns = MeasureSpawn(iterations);
+    printf("%7zu MB %14.1f %14.1f\n", rss / 1_MB, fork_ns / 1000.0, spawn_ns / 1000.0);
+
+    if (ballast) {
+      munmap(ballast, rss);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,187 @@
+#include "data/mpsc_queue.h"
+#include "data/spsc_queue.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+using namespace pdp;
+
+// Throughput and round-trip latency of the lock-free rings with the two sides pinned to
+// different core pairs. Usage: bench_ring_buffers [num_elements]
+
+namespace {
+
+constexpr size_t queue_size = 1024;
+constexpr size_t batch_size = 32;
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+void PinToCpu(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+template <typename Queue>
+void PushOne(Queue &q, uint64_t value) {
+  while (!q.TryEmplaceBack(value)) {
+    sched_yield();
+  }
+}
+
+template <typename Queue>
+uint64_t PopOne(Queue &q) {
+  uint64_t *front = q.Front();
+  while (!front) {
+    sched_yield();
+    front = q.Front();
+  }
+  uint64_t value = *front;
+  q.PopFront();
+  return value;
+}
+
+double SpscThroughput(int producer_cpu, int consumer_cpu, size_t count, bool batched) {
+  SpscQueue<uint64_t> q(queue_size);
+  uint64_t begin = NowNs();
+  std::thread producer([&]() {
+    PinToCpu(producer_cpu);
+    uint64_t batch[batch_size];
+    for (size_t i = 0; i < count;) {
+      if (batched) {
+        size_t n = count - i < batch_size ? count - i : batch_size;
+        for (size_t j = 0; j < n; ++j) {
+          batch[j] = i + j;
+        }
+        size_t pushed = 0;
+        while (pushed < n) {
+          size_t k = q.TryPushBatch(batch + pushed, n - pushed);
+          if (k == 0) {
+            sched_yield();
+          }
+          pushed += k;
+        }
+        i += n;
+      } else {
+        PushOne(q, i++);
+      }
+    }
+  });
+
+  PinToCpu(consumer_cpu);
+  uint64_t sum = 0;
+  uint64_t batch[batch_size];
+  for (size_t received = 0; received < count;) {
+    if (batched) {
+      size_t n = q.PopBatch(batch, batch_size);
+      if (n == 0) {
+        sched_yield();
+      }
+      for (size_t j = 0; j < n; ++j) {
+        sum += batch[j];
+      }
+      received += n;
+    } else {
+      sum += PopOne(q);
+      ++received;
+    }
+  }
+  producer.join();
+  uint64_t elapsed = NowNs() - begin;
+  if (sum != count * (count - 1) / 2) {
+    printf("checksum mismatch\n");
+  }
+  return count * 1e3 / elapsed;
+}
+
+double MpscThroughput(int producer_cpu, int consumer_cpu, size_t count, int num_producers) {
+  MpscQueue<uint64_t> q(queue_size);
+  const size_t per_producer = count / num_producers;
+  uint64_t begin = NowNs();
+  std::thread producers[4];
+  for (int p = 0; p < num_producers; ++p) {
+    producers[p] = std::thread([&]() {
+      PinToCpu(producer_cpu);
+      for (size_t i = 0; i < per_producer; ++i) {
+        PushOne(q, i);
+      }
+    });
+  }
+
+  PinToCpu(consumer_cpu);
+  for (size_t received = 0; received < per_producer * num_producers; ++received) {
+    PopOne(q);
+  }
+  for (int p = 0; p < num_producers; ++p) {
+    producers[p].join();
+  }
+  uint64_t elapsed = NowNs() - begin;
+  return per_producer * num_producers * 1e3 / elapsed;
+}
+
+double RoundTripNs(int first_cpu, int second_cpu, size_t count) {
+  SpscQueue<uint64_t> ping(queue_size);
+  SpscQueue<uint64_t> pong(queue_size);
+  std::thread echo([&]() {
+    PinToCpu(second_cpu);
+    for (size_t i = 0; i < count; ++i) {
+      PushOne(pong, PopOne(ping));
+    }
+  });
+
+  PinToCpu(first_cpu);
+  uint64_t begin = NowNs();
+  for (size_t i = 0; i < count; ++i) {
+    PushOne(ping, i);
+    PopOne(pong);
+  }
+  uint64_t elapsed = NowNs() - begin;
+  echo.join();
+  return double(elapsed) / count;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2'000'000;
+
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  int cpus[CPU_SETSIZE];
+  int num_cpus = 0;
+  for (int i = 0; i < CPU_SETSIZE; ++i) {
+    if (CPU_ISSET(i, &allowed)) {
+      cpus[num_cpus++] = i;
+    }
+  }
+
+  // Same core, a neighbour (likely the SMT sibling or same CCX) and the farthest core.
+  int pairs[3][2] = {{cpus[0], cpus[0]}, {cpus[0], cpus[1 % num_cpus]},
+                     {cpus[0], cpus[num_cpus - 1]}};
+  int num_pairs = num_cpus == 1 ? 1 : (num_cpus == 2 ? 2 : 3);
+
+  printf("%5s %5s %12s %12s %12s %12s %12s\n", "prod", "cons", "spsc Mop/s", "batch Mop/s",
+         "mpsc1 Mop/s", "mpsc2 Mop/s", "rtt ns");
+  for (int i = 0; i < num_pairs; ++i) {
+    int a = pairs[i][0];
+    int b = pairs[i][1];
+    double spsc = SpscThroughput(a, b, count, false);
+    double spsc_batch = SpscThroughput(a, b, count, true);
+    double mpsc1 = MpscThroughput(a, b, count, 1);
+    double mpsc2 = MpscThroughput(a, b, count, 2);
+    double rtt = RoundTripNs(a, b, count / 20);
+    printf("%5d %5d %12.1f %12.1f %12.1f %12.1f %12.1f\n", a, b, spsc, spsc_batch, mpsc1, mpsc2,
+           rtt);
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "data/vector.h"
+#include "external/emhash8.h"
+#include "strings/string_hash.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace pdp;
+
+// Measures the string hashers on the keys this program actually hashes: MI field names, absolute
+// source paths and breakpoint ids. Reports hashing speed, the average probe length of a linear
+// probing table at load factor 0.5 and 0.8, and emhash8 lookup speed.
+// Usage: bench_string_hash [rounds]
+
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+using HashFn = uint32_t (*)(const void *, size_t);
+
+struct KeySet {
+  const char *name;
+  // Keys are stored back to back, null separated.
+  Vector<char> chars;
+  Vector<StringSlice> keys;
+
+  explicit KeySet(const char *n) : name(n) {}
+
+  void Add(const char *str, size_t len) {
+    keys += StringSlice(nullptr, len);
+    for (size_t i = 0; i < len; ++i) {
+      chars += str[i];
+    }
+    chars += '\0';
+  }
+
+  // Slices can only point into the buffer once it stops growing.
+  void Finalize() {
+    const char *ptr = chars.Data();
+    for (size_t i = 0; i < keys.Size(); ++i) {
+      size_t len = keys[i].Size();
+      keys[i] = StringSlice(ptr, len);
+      ptr += len + 1;
+    }
+  }
+};
+
+const char *mi_fields[] = {
+    "number",  "type",    "disp",        "enabled",         "addr",       "func",
+    "file",    "fullname", "line",       "thread-groups",   "times",      "original-location",
+    "bkpt",    "frame",   "args",        "name",            "value",      "level",
+    "reason",  "thread-id", "stopped-threads", "core",      "arch",       "from",
+    "id",      "target-id", "state",     "current-thread-id", "threads",  "stack",
+    "locals",  "variables", "numchild",  "exp",             "has_more",   "changelist",
+    "in_scope", "type_changed", "bkptno", "signal-name",     "signal-meaning", "exit-code",
+    "pid",     "group-id", "library-loaded", "host-name",   "symbols-loaded", "ranges",
+    "param",   "msg",     "what",        "catch-type",      "pending",    "cond",
+    "ignore",  "mask",    "script",      "hit-count",       "at",         "evaluated-by",
+};
+
+void MakeMiFields(KeySet &set) {
+  for (const char *field : mi_fields) {
+    set.Add(field, strlen(field));
+  }
+}
+
+void MakePaths(KeySet &set, int count) {
+  const char *dirs[] = {"src", "include", "lib/support", "tools/driver", "third_party/abseil"};
+  char buf[256];
+  for (int i = 0; i < count; ++i) {
+    int len = snprintf(buf, sizeof(buf), "/home/user/work/project/%s/module%d/file_%d.%s",
+                       dirs[i % 5], i % 37, i, i % 3 ? "cc" : "h");
+    set.Add(buf, len);
+  }
+}
+
+void MakeBreakpointIds(KeySet &set, int count) {
+  char buf[32];
+  for (int i = 0; i < count; ++i) {
+    // Every breakpoint followed by 15 of its locations.
+    int len = i % 16 ? snprintf(buf, sizeof(buf), "%d.%d", 1 + i / 16, i % 16)
+                     : snprintf(buf, sizeof(buf), "%d", 1 + i / 16);
+    set.Add(buf, len);
+  }
+}
+
+double HashNs(HashFn fn, const KeySet &set, int rounds) {
+  uint32_t sink = 0;
+  uint64_t begin = NowNs();
+  for (int r = 0; r < rounds; ++r) {
+    for (size_t i = 0; i < set.keys.Size(); ++i) {
+      sink += fn(set.keys[i].Begin(), set.keys[i].Size());
+    }
+  }
+  uint64_t elapsed = NowNs() - begin;
+  if (sink == 42) {
+    printf(" ");
+  }
+  return double(elapsed) / (double(rounds) * set.keys.Size());
+}
+
+/// @brief Average number of slots visited to find a key in a linear probing table.
+double ProbeLength(HashFn fn, const KeySet &set, double load) {
+  // Largest table which the key set can fill up to the requested load.
+  size_t num_buckets = 8;
+  while (num_buckets * 2 * load <= set.keys.Size()) {
+    num_buckets *= 2;
+  }
+  const size_t num_keys = num_buckets * load;
+  Vector<uint32_t> occupied(num_buckets);
+  for (size_t i = 0; i < num_buckets; ++i) {
+    occupied += 0;
+  }
+  size_t total = 0;
+  for (size_t i = 0; i < num_keys; ++i) {
+    size_t pos = fn(set.keys[i].Begin(), set.keys[i].Size()) & (num_buckets - 1);
+    size_t probes = 1;
+    while (occupied[pos]) {
+      pos = (pos + 1) & (num_buckets - 1);
+      ++probes;
+    }
+    occupied[pos] = 1;
+    total += probes;
+  }
+  return double(total) / num_keys;
+}
+
+template <typename H>
+double MapFindNs(const KeySet &set, int rounds) {
+  emhash8::StringMap<uint32_t, H> map;
+  for (size_t i = 0; i < set.keys.Size(); ++i) {
+    map.Emplace(set.keys[i], i);
+  }
+  size_t found = 0;
+  uint64_t begin = NowNs();
+  for (int r = 0; r < rounds; ++r) {
+    for (size_t i = 0; i < set.keys.Size(); ++i) {
+      found += map.Find(set.keys[i]) != map.End();
+    }
+  }
+  uint64_t elapsed = NowNs() - begin;
+  return found ? double(elapsed) / (double(rounds) * set.keys.Size()) : 0;
+}
+
+struct Hasher {
+  const char *name;
+  HashFn fn;
+  double (*map_find)(const KeySet &, int);
+  bool supported;
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 200;
+
+  KeySet mi("mi fields");
+  MakeMiFields(mi);
+  KeySet paths("paths");
+  MakePaths(paths, 4000);
+  KeySet ids("breakpoint ids");
+  MakeBreakpointIds(ids, 4000);
+  KeySet *sets[] = {&mi, &paths, &ids};
+  for (KeySet *set : sets) {
+    set->Finalize();
+  }
+
+  Hasher hashers[] = {
+      {"portable", HashBytesPortable, MapFindNs<PortableStringHash>, true},
+      {"crc32c", HashBytesCrc32c, MapFindNs<Crc32cStringHash>, CheckCpuCrc32c()},
+      {"aes", HashBytesAes, MapFindNs<AesStringHash>, CheckCpuAes()},
+  };
+
+  printf("HashBytes resolved to: %s\n\n", HashBytesName());
+  printf("%16s %10s %10s %12s %12s %12s\n", "keys", "hasher", "hash ns", "probes@0.5",
+         "probes@0.8", "find ns");
+  for (KeySet *set : sets) {
+    // The MI key set is tiny, repeat it so the timings are comparable.
+    int set_rounds = set == &mi ? rounds * 64 : rounds;
+    for (const Hasher &h : hashers) {
+      if (!h.supported) {
+        printf("%16s %10s %10s\n", set->name, h.name, "n/a");
+        continue;
+      }
+      printf("%16s %10s %10.2f %12.3f %12.3f %12.2f\n", set->name, h.name,
+             HashNs(h.fn, *set, set_rounds), ProbeLength(h.fn, *set, 0.5),
+             ProbeLength(h.fn, *set, 0.8), h.map_find(*set, set_rounds));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include "system/thread_pool.h"
+
+#include <sys/poll.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace pdp;
+
+// Measures the cost of dispatching empty tasks to the pool and getting the completions back on
+// the main thread. Usage: bench_thread_pool [rounds]
+
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+struct EmptyTask : public PoolTask {
+  EmptyTask() : PoolTask(Run, Complete) {}
+
+  static void Run(PoolTask *) {}
+  static void Complete(PoolTask *) {}
+};
+
+void WaitForCompletions(ThreadPool &pool) {
+  while (pool.NumPending() > 0) {
+    struct pollfd poll_args;
+    poll_args.fd = pool.GetDescriptor();
+    poll_args.events = POLLIN;
+    poll_args.revents = 0;
+    poll(&poll_args, 1, -1);
+    pool.DrainCompletions();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+  const unsigned worker_counts[] = {1, 2, 4};
+  const size_t batch_sizes[] = {1, 16, 256};
+
+  static EmptyTask tasks[256];
+
+  printf("%8s %8s %16s\n", "workers", "batch", "ns/task");
+  for (unsigned workers : worker_counts) {
+    ThreadPool pool(workers);
+    for (size_t batch : batch_sizes) {
+      uint64_t begin = NowNs();
+      for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < batch; ++i) {
+          pool.Submit(&tasks[i]);
+        }
+        WaitForCompletions(pool);
+      }
+      uint64_t elapsed = NowNs() - begin;
+      printf("%8u %8zu %16.1f\n", workers, batch, double(elapsed) / (rounds * batch));
+    }
+  }
+  return 0;
+}
@@ -62,6 +62,9 @@ int main() {
       pdp_info("unlikely branch taken");
     }
   }
+#ifdef PDP_TRACE_BRANCH
+  pdp::LogBranchProfile();
+#endif
 
   pdp_info("Testing pdp_assert death");
   RunChildAndTerminate("pdp_assert", TestAssert);
@@ -2,6 +2,9 @@
 #include <doctest/doctest.h>
 
 #include "data/arena.h"
+#include "data/vector.h"
+
+#include <cstring>
 
 using namespace pdp;
 
@@ -195,3 +198,94 @@ TEST_CASE("Arena preserves data across mixed-size allocations") {
     }
   }
 }
+
+TEST_CASE("ChainedArena grows past the first block") {
+  ChainedArena<> arena(64);
+  CHECK(arena.NumBlocks() == 1);
+
+  void *small = arena.Allocate(48);
+  void *big = arena.Allocate(1000);
+  REQUIRE(small != nullptr);
+  REQUIRE(big != nullptr);
+  CHECK(reinterpret_cast<uintptr_t>(big) % ChainedArena<>::alignment == 0);
+  CHECK(arena.NumBlocks() == 2);
+
+  memset(big, 0xab, 1000);
+}
+
+TEST_CASE("ChainedArena Rewind hands back memory and keeps the blocks") {
+  ChainedArena<> arena(128);
+  arena.Allocate(16);
+  const ArenaMark mark = arena.Mark();
+
+  void *first = arena.Allocate(512);
+  arena.Allocate(64);
+  const size_t num_blocks = arena.NumBlocks();
+  CHECK(num_blocks > 1);
+
+  arena.Rewind(mark);
+  // The chained blocks are big enough to be reused.
+  CHECK(arena.Allocate(512) == first);
+  arena.Allocate(64);
+  CHECK(arena.NumBlocks() == num_blocks);
+}
+
+TEST_CASE("ChainedArena TrimSpareBlocks frees the blocks past the current one") {
+  ChainedArena<> arena(128);
+  void *first = arena.Allocate(16);
+  const ArenaMark mark = arena.Mark();
+  for (int i = 0; i < 10; ++i) {
+    arena.Allocate(1000);
+  }
+  CHECK(arena.NumBlocks() > 1);
+
+  arena.Rewind(mark);
+  arena.TrimSpareBlocks();
+  CHECK(arena.NumBlocks() == 1);
+  CHECK(static_cast<char *>(arena.Allocate(16)) == static_cast<char *>(first) + 16);
+}
+
+TEST_CASE("ChainedArena Reset keeps only the first block") {
+  ChainedArena<> arena(128);
+  void *first = arena.Allocate(8);
+  for (int i = 0; i < 10; ++i) {
+    arena.Allocate(1000);
+  }
+  CHECK(arena.NumBlocks() > 1);
+
+  arena.Reset();
+  CHECK(arena.NumBlocks() == 1);
+  CHECK(arena.Allocate(8) == first);
+}
+
+TEST_CASE("ArenaAllocator extends the last allocation in place") {
+  ChainedArena<> arena(1024);
+  ArenaAllocator<> alloc(&arena);
+
+  char *str = static_cast<char *>(alloc.AllocateRaw(10));
+  memcpy(str, "abcdefghi", 10);
+  CHECK(alloc.GetAllocationSize(str) == 10);
+  CHECK(alloc.ReallocateRaw(str, 100) == str);
+  CHECK(alloc.GetAllocationSize(str) == 100);
+
+  void *other = alloc.AllocateRaw(8);
+  char *moved = static_cast<char *>(alloc.ReallocateRaw(str, 200));
+  CHECK(moved != str);
+  CHECK(moved > other);
+  CHECK(strcmp(moved, "abcdefghi") == 0);
+}
+
+TEST_CASE("ArenaAllocator backs containers") {
+  ChainedArena<> arena(256);
+  const ArenaMark mark = arena.Mark();
+  {
+    Vector<uint32_t, ArenaAllocator<>> v(4, &arena);
+    for (uint32_t i = 0; i < 1000; ++i) {
+      v += i;
+    }
+    CHECK(v.Size() == 1000);
+    CHECK(v[999] == 999);
+  }
+  arena.Rewind(mark);
+  CHECK(arena.Mark().head == mark.head);
+}
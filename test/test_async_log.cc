@@ -0,0 +1,119 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/log.h"
+#include "system/async_log.h"
+#include "system/thread.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+
+using namespace pdp;
+
+// Logging can be redirected once per process, all tests share one file.
+static int LogFile() {
+  static int fd = -1;
+  if (fd < 0) {
+    char path[] = "/tmp/pdp_test_async_log_XXXXXX";
+    fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    unlink(path);
+    RedirectLogging(dup(fd));
+  }
+  return fd;
+}
+
+static size_t LogSize() {
+  struct stat st;
+  REQUIRE(fstat(LogFile(), &st) == 0);
+  return st.st_size;
+}
+
+/// @brief Counts the lines written since @p offset which contain @p marker.
+static size_t CountLines(size_t offset, const char *marker) {
+  const size_t size = LogSize() - offset;
+  char *buf = static_cast<char *>(malloc(size + 1));
+  REQUIRE(pread(LogFile(), buf, size, offset) == static_cast<ssize_t>(size));
+  buf[size] = '\0';
+  size_t count = 0;
+  for (char *line = buf; *line;) {
+    char *end = strchr(line, '\n');
+    REQUIRE(end);
+    *end = '\0';
+    count += strstr(line, marker) != nullptr;
+    line = end + 1;
+  }
+  free(buf);
+  return count;
+}
+
+TEST_CASE("blocking policy writes every message") {
+  const size_t offset = LogSize();
+  StartAsyncLogging(LogOverflow::kBlock, 64);
+
+  struct Producer {
+    int id;
+    void operator()() {
+      for (int i = 0; i < 2000; ++i) {
+        pdp_info("producer {} message {}", id, i);
+      }
+    }
+  };
+  Thread threads[3];
+  for (int t = 0; t < 3; ++t) {
+    threads[t].Start(Producer{t});
+  }
+  for (int t = 0; t < 3; ++t) {
+    threads[t].Wait();
+  }
+  StopAsyncLogging();
+
+  CHECK(NumDroppedLogMessages() == 0);
+  CHECK(CountLines(offset, "message") == 6000);
+  CHECK(CountLines(offset, "producer 1 message 1999") == 1);
+}
+
+TEST_CASE("drop policy accounts for every message") {
+  const size_t offset = LogSize();
+  StartAsyncLogging(LogOverflow::kDrop, 16);
+  for (int i = 0; i < 20000; ++i) {
+    pdp_info("burst {}", i);
+  }
+  StopAsyncLogging();
+
+  const size_t written = CountLines(offset, "burst");
+  CHECK(written + NumDroppedLogMessages() == 20000);
+  if (NumDroppedLogMessages() > 0) {
+    CHECK(CountLines(offset, "log messages dropped]") > 0);
+  }
+}
+
+TEST_CASE("long messages are not split") {
+  const size_t offset = LogSize();
+  StartAsyncLogging(LogOverflow::kBlock, 64);
+  char text[3000];
+  memset(text, 'x', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  for (int i = 0; i < 10; ++i) {
+    pdp_info("long {} {} end", i, StringSlice(text));
+  }
+  StopAsyncLogging();
+
+  CHECK(CountLines(offset, "x end") == 10);
+}
+
+TEST_CASE("flushing detaches the backend") {
+  const size_t offset = LogSize();
+  StartAsyncLogging(LogOverflow::kBlock, 64);
+  for (int i = 0; i < 100; ++i) {
+    pdp_info("queued {}", i);
+  }
+  // What OnFatalError does before printing the error.
+  FlushLogBackend();
+  CHECK(CountLines(offset, "queued") == 100);
+
+  pdp_info("synchronous");
+  CHECK(CountLines(offset, "synchronous") == 1);
+  StopAsyncLogging();
+}
@@ -0,0 +1,84 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/binary_log.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+
+using namespace pdp;
+
+static StringSlice TailFrom(const StringSlice &text, const char *marker) {
+  const char *it = text.MemMem(marker);
+  REQUIRE(it);
+  return StringSlice(it, text.End());
+}
+
+TEST_CASE("binary log renders like the text log") {
+  char path[] = "/tmp/pdp_test_binary_log_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  unlink(path);
+  RedirectLogging(dup(fd));
+
+  pdp_info("text before {}", 1);
+  StartBinaryLogging();
+  pdp_info("ints {} {} {}", 42, -7, uint64_t(1) << 40);
+  pdp_warning("string '{}' and char {}", StringSlice("hello"), 'x');
+  pdp_error("pointer {} size {}", MakeHex(0xbeefu), MakeByteSize(3u * 1024 * 1024));
+  LogUnformatted("raw text\n");
+
+  char long_text[6000];
+  memset(long_text, 'y', sizeof(long_text));
+  pdp_info("long {}", StringSlice(long_text, sizeof(long_text)));
+  pdp_info("after long");
+
+  struct stat st;
+  REQUIRE(fstat(fd, &st) == 0);
+  const size_t before_repeated = st.st_size;
+  for (int i = 0; i < 100; ++i) {
+    pdp_info("repeated {} {}", i, 12345678);
+  }
+  REQUIRE(fstat(fd, &st) == 0);
+  const size_t repeated_size = st.st_size - before_repeated;
+
+  StringBuilder<> log;
+  char *buf = log.AppendUninitialized(st.st_size);
+  REQUIRE(pread(fd, buf, st.st_size, 0) == st.st_size);
+
+  StringBuilder<> text;
+  REQUIRE(DecodeBinaryLog(log.ToSlice(), text));
+  StringSlice out = text.ToSlice();
+
+  CHECK(out.MemMem("text before 1\n"));
+  CHECK(out.MemMem("ints 42 -7 1099511627776\n"));
+  CHECK(out.MemMem("string 'hello' and char x\n"));
+  CHECK(out.MemMem("pointer 0xbeef size 3M\n"));
+  CHECK(out.MemMem("test_binary_log.cc:"));
+  CHECK(out.MemMem("\nraw text\n"));
+  CHECK(out.MemMem("after long\n"));
+
+  // The long string was cut to fit a record.
+  StringSlice long_line = TailFrom(out, "long yyy");
+  long_line = long_line.GetLeft(long_line.MemChar('\n'));
+  CHECK(long_line.Size() < max_binary_record_size);
+  CHECK(long_line.Size() > max_binary_record_size - 100);
+
+  // Once the site is defined a message is much smaller than its text.
+  StringSlice repeated_line = TailFrom(out, "repeated 99 ");
+  repeated_line = repeated_line.GetLeft(repeated_line.MemChar('\n'));
+  const char *line_begin = repeated_line.Begin();
+  while (line_begin[-1] != '\n') {
+    --line_begin;
+  }
+  const size_t line_size = repeated_line.End() - line_begin;
+  CHECK(repeated_size < 100 * line_size / 2);
+
+  // Truncated logs render up to the broken record.
+  StringBuilder<> partial;
+  CHECK(!DecodeBinaryLog(log.ToSlice().GetLeft(log.Size() - 3), partial));
+  CHECK(partial.ToSlice().MemMem("repeated 98 "));
+  CHECK(!partial.ToSlice().MemMem("repeated 99 "));
+  close(fd);
+}
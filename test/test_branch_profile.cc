@@ -0,0 +1,41 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+// The TRACE_BRANCH feature build already defines it.
+#ifndef PDP_TRACE_BRANCH
+#define PDP_TRACE_BRANCH
+#endif
+#include "tracing/trace_likely.h"
+
+using namespace pdp;
+
+static bool HintedLikely(int i) { return PDP_TRACE_LIKELY(i % 4 != 0); }
+static bool HintedUnlikely(int i) { return PDP_TRACE_UNLIKELY(i % 2 == 0); }
+static bool NeverHit(int i) { return PDP_TRACE_LIKELY(i == 12345); }
+
+TEST_CASE("sites are ranked by mispredictions") {
+  StringBuilder<> empty;
+  AppendBranchProfile(empty);
+  CHECK(empty.Size() == 0);
+
+  int taken = 0;
+  for (int i = 0; i < 1000; ++i) {
+    taken += HintedLikely(i);
+    taken += HintedUnlikely(i);
+  }
+  CHECK(taken == 750 + 500);
+  (void)NeverHit;
+
+  StringBuilder<> report;
+  AppendBranchProfile(report);
+  const StringSlice text = report.ToSlice();
+  const char *unlikely = text.MemMem("mispredicted 500/1000 (50.0%) UNLIKELY(i % 2 == 0) "
+                                     "test_branch_profile.cc:13\n");
+  const char *likely = text.MemMem("mispredicted 250/1000 (25.0%) LIKELY(i % 4 != 0) "
+                                   "test_branch_profile.cc:12\n");
+  REQUIRE(unlikely);
+  REQUIRE(likely);
+  CHECK(unlikely < likely);
+  // Sites are only registered once hit.
+  CHECK(!text.MemMem("i == 12345"));
+}
@@ -0,0 +1,100 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "drivers/breakpoint_table.h"
+#include "parser/mi_parser.h"
+
+using namespace pdp;
+
+static UniquePtr<ExprBase> Parse(ChainedArena<> &scratch, const char *results) {
+  auto expr = ParseMiResults(results, scratch);
+  REQUIRE(expr);
+  return expr;
+}
+
+static size_t CountAliases(BreakpointTable &table, BreakpointId id) {
+  size_t count = 0;
+  for (auto &entry : table.GetAliases(id)) {
+    CHECK(BreakpointMajor(entry.key) == BreakpointMajor(id));
+    ++count;
+  }
+  return count;
+}
+
+TEST_CASE("ParseBreakpointId packs major and minor") {
+  CHECK(ParseBreakpointId("7") == MakeBreakpointId(7));
+  CHECK(ParseBreakpointId("7.12") == MakeBreakpointId(7, 12));
+  CHECK(BreakpointMajor(ParseBreakpointId("123.4")) == 123);
+  CHECK(BreakpointMinor(ParseBreakpointId("123.4")) == 4);
+  CHECK(ParseBreakpointId("2") < ParseBreakpointId("2.1"));
+  CHECK(ParseBreakpointId("2.9") < ParseBreakpointId("2.10"));
+  CHECK(ParseBreakpointId("2.10") < ParseBreakpointId("3"));
+}
+
+TEST_CASE("BreakpointTable single breakpoint") {
+  ChainedArena<> scratch;
+  PathProbeCache cache;
+  BreakpointTable table(cache);
+
+  auto bkpt = Parse(scratch, "number=\"3\",type=\"breakpoint\",enabled=\"y\",addr=\"0x1234\"");
+  auto [it, is_new] = table.Insert(bkpt, nullptr);
+  CHECK(is_new);
+  CHECK(it->key == MakeBreakpointId(3));
+  CHECK(it->value.type == Breakpoint::kBreak);
+  CHECK(it->value.enabled);
+
+  CHECK(table.Find(MakeBreakpointId(3)) != table.End());
+  CHECK(table.Find(MakeBreakpointId(4)) == table.End());
+  CHECK(CountAliases(table, MakeBreakpointId(3)) == 1);
+
+  auto [again, again_is_new] = table.Insert(bkpt, nullptr);
+  CHECK(!again_is_new);
+
+  table.Delete(MakeBreakpointId(3));
+  CHECK(table.Find(MakeBreakpointId(3)) == table.End());
+  CHECK(CountAliases(table, MakeBreakpointId(3)) == 0);
+}
+
+TEST_CASE("BreakpointTable locations form a contiguous range") {
+  ChainedArena<> scratch;
+  PathProbeCache cache;
+  BreakpointTable table(cache);
+
+  auto first = Parse(scratch, "number=\"1\",type=\"breakpoint\",enabled=\"y\",addr=\"0x10\"");
+  table.Insert(first, nullptr);
+  auto last = Parse(scratch, "number=\"3\",type=\"breakpoint\",enabled=\"y\",addr=\"0x30\"");
+  table.Insert(last, nullptr);
+
+  // Inserted out of order, in between two existing breakpoints.
+  auto parent = Parse(scratch, "id=\"2\",enabled=\"n\"");
+  const char *locations[] = {
+      "number=\"2.2\",type=\"breakpoint\",enabled=\"y\",addr=\"0x22\"",
+      "number=\"2.1\",type=\"breakpoint\",enabled=\"y\",addr=\"0x21\"",
+      "number=\"2.10\",type=\"breakpoint\",enabled=\"y\",addr=\"0x2a\"",
+  };
+  for (const char *loc : locations) {
+    auto bkpt = Parse(scratch, loc);
+    auto [it, is_new] = table.Insert(bkpt, parent);
+    CHECK(is_new);
+    // Disabled parent disables all locations.
+    CHECK(!it->value.enabled);
+  }
+
+  CHECK(CountAliases(table, MakeBreakpointId(2)) == 3);
+  CHECK(CountAliases(table, MakeBreakpointId(2, 10)) == 1);
+  CHECK(CountAliases(table, MakeBreakpointId(2, 3)) == 0);
+
+  BreakpointId prev = 0;
+  for (auto &entry : table.GetAliases(MakeBreakpointId(2))) {
+    CHECK(prev < entry.key);
+    prev = entry.key;
+  }
+
+  table.Delete(MakeBreakpointId(2, 2));
+  CHECK(CountAliases(table, MakeBreakpointId(2)) == 2);
+
+  table.Delete(MakeBreakpointId(2));
+  CHECK(CountAliases(table, MakeBreakpointId(2)) == 0);
+  CHECK(table.Find(MakeBreakpointId(1)) != table.End());
+  CHECK(table.Find(MakeBreakpointId(3)) != table.End());
+}
@@ -3,6 +3,8 @@
 
 #include "data/chunk_array.h"
 
+#include <cstring>
+
 using namespace pdp;
 
 TEST_CASE("ChunkArray basic allocation returns aligned pointers") {
@@ -181,3 +183,67 @@ TEST_CASE("ChunkArray preserves data across mixed-size allocations") {
     }
   }
 }
+
+TEST_CASE("ChunkHandle returns chunks to the cache") {
+  g_chunk_cache.Trim();
+  {
+    ChunkArray ca;
+    ca.Allocate(ChunkArray::chunk_size / 2);
+    ca.Allocate(ChunkArray::chunk_size / 2 + 8);
+    ca.Allocate(128_KB);
+    CHECK(ca.NumChunks() == 3);
+    ChunkHandle handle = ca.ReleaseChunks();
+  }
+  // The big chunk is not cached.
+  auto stats = g_chunk_cache.GetStats();
+  CHECK(stats.cached_chunks == 2);
+
+  {
+    ChunkArray ca;
+    ca.Allocate(ChunkArray::chunk_size);
+    ca.Allocate(8);
+  }
+  auto after = g_chunk_cache.GetStats();
+  CHECK(after.hits == stats.hits + 2);
+  CHECK(after.misses == stats.misses);
+  CHECK(after.cached_chunks == 2);
+}
+
+TEST_CASE("ChunkCache keeps a bounded free list") {
+  g_chunk_cache.Trim();
+  byte *chunks[ChunkCache::max_cached_chunks + 8];
+  for (byte *&chunk : chunks) {
+    chunk = g_chunk_cache.Acquire();
+    REQUIRE(chunk);
+  }
+  for (byte *chunk : chunks) {
+    g_chunk_cache.Release(chunk);
+  }
+  CHECK(g_chunk_cache.GetStats().cached_chunks == ChunkCache::max_cached_chunks);
+  g_chunk_cache.Trim();
+  CHECK(g_chunk_cache.GetStats().cached_chunks == 0);
+}
+
+TEST_CASE("ChunkCache serves misses from slabs") {
+  g_chunk_cache.Trim();
+  g_chunk_cache.EnableHugePageSlabs(true);
+
+  bool is_hit = true;
+  byte *first = g_chunk_cache.Acquire(&is_hit);
+  CHECK_FALSE(is_hit);
+  CHECK(g_chunk_cache.GetStats().num_slabs == 1);
+  CHECK(g_chunk_cache.GetStats().cached_chunks == ChunkCache::chunks_per_slab - 1);
+
+  byte *second = g_chunk_cache.Acquire(&is_hit);
+  CHECK(is_hit);
+  CHECK(second == first + ChunkCache::chunk_size);
+  memset(first, 1, ChunkCache::chunk_size);
+  memset(second, 2, ChunkCache::chunk_size);
+
+  g_chunk_cache.Release(first);
+  g_chunk_cache.Release(second);
+  // Slab chunks survive trimming.
+  g_chunk_cache.Trim();
+  CHECK(g_chunk_cache.GetStats().cached_chunks == ChunkCache::chunks_per_slab);
+  g_chunk_cache.EnableHugePageSlabs(false);
+}
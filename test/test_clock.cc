@@ -0,0 +1,57 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/clock.h"
+
+#include <unistd.h>
+#include <ctime>
+
+using namespace pdp;
+
+static int64_t ClockGetNs(clockid_t id) {
+  struct timespec ts;
+  clock_gettime(id, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000ll + ts.tv_nsec;
+}
+
+static void CheckAgreesWith(clockid_t id, uint64_t (*now)()) {
+  const int64_t max_error_ns = 100'000;
+  const int64_t before = ClockGetNs(id);
+  const int64_t value = now();
+  const int64_t after = ClockGetNs(id);
+  CHECK(value > before - max_error_ns);
+  CHECK(value < after + max_error_ns);
+}
+
+static void CheckAgreesWithSystem() {
+  CheckAgreesWith(CLOCK_MONOTONIC, MonotonicNs);
+  CheckAgreesWith(CLOCK_REALTIME, RealtimeNs);
+}
+
+TEST_CASE("conversions agree with the system clocks") {
+  CheckAgreesWithSystem();
+  usleep(20'000);
+  CheckAgreesWithSystem();
+}
+
+TEST_CASE("tick differences convert to durations") {
+  const uint64_t begin = ReadTsc();
+  usleep(20'000);
+  const uint64_t elapsed_ns = TscTicksToNs(ReadTsc() - begin);
+  CHECK(elapsed_ns >= 20'000'000);
+  CHECK(elapsed_ns < 40'000'000);
+}
+
+TEST_CASE("time does not go back across recalibrations") {
+  uint64_t last = MonotonicNs();
+  const int64_t end = ClockGetNs(CLOCK_MONOTONIC) + 1'200'000'000;
+  size_t num_reads = 0;
+  while (ClockGetNs(CLOCK_MONOTONIC) < end) {
+    const uint64_t now = MonotonicNs();
+    REQUIRE(now >= last);
+    last = now;
+    ++num_reads;
+  }
+  CHECK(num_reads > 1000);
+  CheckAgreesWithSystem();
+}
@@ -4,12 +4,14 @@
 #include "strings/fixed_string.h"
 #include "strings/string_slice.h"
 
+#include <cstring>
+
 using namespace pdp;
 
 TEST_CASE("DynamicString default construction") {
   FixedString s;
 
-  CHECK(s.Cstr() == nullptr);
+  CHECK(s.Cstr()[0] == '\0');
   CHECK(s.Size() == 0);
   CHECK(s.Empty());
 }
@@ -34,14 +36,67 @@ TEST_CASE("DynamicString construct from begin/end") {
 }
 
 TEST_CASE("DynamicString move constructor transfers ownership") {
-  FixedString a("move", 4);
+  const char *txt = "a string which does not fit inline";
+  FixedString a(txt, strlen(txt));
   const char *old_ptr = a.Cstr();
 
   FixedString b(std::move(a));
 
-  CHECK(b.Size() == 4);
+  CHECK(b.Size() == strlen(txt));
   CHECK(b.Cstr() == old_ptr);
-  CHECK(a.Cstr() == nullptr);  // must be null to avoid double free
+  CHECK(a.Empty());  // must not own the buffer to avoid double free
+}
+
+TEST_CASE("DynamicString short strings are stored inline") {
+  FixedString a("12.3", 4);
+  const char *begin = a.Begin();
+  CHECK(begin >= reinterpret_cast<const char *>(&a));
+  CHECK(begin < reinterpret_cast<const char *>(&a + 1));
+
+  FixedString b(std::move(a));
+  CHECK(b == StringSlice("12.3"));
+  CHECK(b.Cstr()[4] == '\0');
+  CHECK(a.Empty());
+
+  const char max_inline[] = "0123456789012345678901";
+  static_assert(sizeof(max_inline) - 1 == FixedString::inline_capacity);
+  FixedString c(max_inline, FixedString::inline_capacity);
+  CHECK(c == StringSlice(max_inline));
+  CHECK(c.Cstr()[FixedString::inline_capacity] == '\0');
+}
+
+TEST_CASE("DynamicString Reset switches between inline and heap storage") {
+  FixedString s("short", 5);
+  s.Reset(StringSlice("a considerably longer string than before"));
+  CHECK(s == StringSlice("a considerably longer string than before"));
+  s.Reset(StringSlice("tiny"));
+  CHECK(s == StringSlice("tiny"));
+  CHECK(s.Cstr()[4] == '\0');
+
+  FixedString other(StringSlice("another string that lives on the heap"));
+  s.Reset(std::move(other));
+  CHECK(s == StringSlice("another string that lives on the heap"));
+  CHECK(other.Empty());
+}
+
+TEST_CASE("DynamicString Reset to a slice of itself") {
+  FixedString s(StringSlice("a heap string which is reset to a part of itself"));
+  s.Reset(StringSlice(s.Begin(), 6));
+  CHECK(s == StringSlice("a heap"));
+
+  FixedString t(StringSlice("another heap string, this time keeping the tail"));
+  t.Reset(StringSlice(t.Begin() + 8, t.End()));
+  CHECK(t == StringSlice("heap string, this time keeping the tail"));
+  CHECK(t.Cstr()[t.Size()] == '\0');
+}
+
+TEST_CASE("DynamicString can be relocated with realloc") {
+  CHECK(CanReallocate<FixedString>::value);
+  FixedString a("inline", 6);
+  alignas(FixedString) char raw[sizeof(FixedString)];
+  memcpy(raw, static_cast<void *>(&a), sizeof(FixedString));
+  const FixedString *moved = reinterpret_cast<const FixedString *>(raw);
+  CHECK(*moved == StringSlice("inline"));
 }
 
 TEST_CASE("DynamicString equality with DynamicString") {
@@ -94,7 +149,7 @@ TEST_CASE("DynamicString Begin == End for empty string") {
   FixedString s;
 
   CHECK(s.Begin() == s.End());
-  CHECK(s.Cstr() == nullptr);
+  CHECK(s.Cstr()[0] == '\0');
 }
 
 TEST_CASE("DynamicString Size, Length, Empty are consistent") {
@@ -3,6 +3,9 @@
 #include <doctest/doctest.h>
 
 #include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
 #include <string>
 #include <utility>
 #include <vector>
@@ -14,6 +17,16 @@
 using pdp::Hash;
 using pdp::StringSlice;
 
+template <typename Map, typename Key>
+static bool EraseKey(Map &m, const Key &key) {
+  auto *it = m.Find(key);
+  if (it == m.End()) {
+    return false;
+  }
+  m.Erase(it);
+  return true;
+}
+
 TEST_CASE("Map<uint32_t, uint32_t>: basic empty invariants") {
   emhash8::Map<uint32_t, uint32_t> m;
 
@@ -29,7 +42,7 @@ TEST_CASE("Map<uint32_t, uint32_t>: basic empty invariants") {
 TEST_CASE("Map<uint32_t, uint32_t>: Emplace inserts and Find returns same entry") {
   emhash8::Map<uint32_t, uint32_t> m;
 
-  auto *e1 = m.EmplaceUnique(1, 111);
+  auto *e1 = m.Emplace(1, 111).it;
   REQUIRE(e1 != nullptr);
   CHECK(e1->key == 1);
   CHECK(e1->value == 111);
@@ -43,7 +56,7 @@ TEST_CASE("Map<uint32_t, uint32_t>: Emplace inserts and Find returns same entry"
   CHECK(f1->value == 111);
 
   // Emplace same key should not create a new element; should return existing slot.
-  auto *e1b = m.EmplaceUnique(1, 999);
+  auto *e1b = m.Emplace(1, 999).it;
   REQUIRE(e1b != nullptr);
   CHECK(m.Size() == 1);
   CHECK(e1b->key == 1);
@@ -55,7 +68,7 @@ TEST_CASE("Map<uint32_t, uint32_t>: multiple inserts, iteration covers all keys"
 
   constexpr uint32_t N = 200;
   for (uint32_t i = 0; i < N; ++i) {
-    auto *e = m.EmplaceUnique(i, i + 10);
+    auto *e = m.Emplace(i, i + 10).it;
     REQUIRE(e != nullptr);
   }
   CHECK(m.Size() == N);
@@ -84,7 +97,7 @@ TEST_CASE("Map<uint32_t, uint32_t>: Erase missing key returns false") {
 
   CHECK(m.Size() == 2);
 
-  CHECK(m.Erase(999) == false);
+  CHECK(EraseKey(m, 999) == false);
   CHECK(m.Size() == 2);
   CHECK(m.Find(1u) != m.End());
   CHECK(m.Find(2u) != m.End());
@@ -101,7 +114,7 @@ TEST_CASE("Map<uint32_t, uint32_t>: Erase by key removes element and keeps table
 
   // Remove evens.
   for (uint32_t i = 0; i < N; i += 2) {
-    CHECK(m.Erase(i) == true);
+    CHECK(EraseKey(m, i) == true);
   }
   CHECK(m.Size() == N / 2);
 
@@ -119,7 +132,7 @@ TEST_CASE("Map<uint32_t, uint32_t>: Erase by key removes element and keeps table
 
   // Now delete the remaining odds too.
   for (uint32_t i = 1; i < N; i += 2) {
-    CHECK(m.Erase(i) == true);
+    CHECK(EraseKey(m, i) == true);
   }
   CHECK(m.Empty());
   CHECK(m.Size() == 0);
@@ -176,44 +189,13 @@ TEST_CASE("Map<uint32_t, uint32_t>: Clear resets size but keeps container usable
   CHECK(e->value == 4242);
 }
 
-TEST_CASE("Map<uint32_t, uint32_t>: Swap swaps contents") {
-  emhash8::Map<uint32_t, uint32_t> a;
-  emhash8::Map<uint32_t, uint32_t> b;
-
-  for (uint32_t i = 0; i < 10; ++i) a.Emplace(i, i + 1);
-  for (uint32_t i = 100; i < 120; ++i) b.Emplace(i, i + 2);
-
-  a.Swap(b);
-
-  CHECK(b.Size() == 10);
-  for (uint32_t i = 0; i < 10; ++i) {
-    auto it = b.Find(i);
-    CHECK(it != b.End());
-    uint32_t j = i + 1;
-    CHECK(it->value == j);
-  }
-  CHECK(a.Size() == 20);
-  for (uint32_t i = 100; i < 120; ++i) {
-    auto it = a.Find(i);
-    CHECK(it != a.End());
-    uint32_t j = i + 2;
-    CHECK(it->value == j);
-  }
-}
-
 TEST_CASE("Map<uint32_t, uint32_t>: move ctor preserve values") {
-  pdp::TrackingAllocator::Stats stats;
-
-  emhash8::Map<uint32_t, uint32_t, pdp::TrackingAllocator> m(&stats);
+  emhash8::Map<uint32_t, uint32_t> m;
   for (uint32_t i = 0; i < 100; ++i) m.Emplace(i, i * 7);
 
-  auto was_bytes = stats.GetBytesUsed();
-
-  emhash8::Map<uint32_t, uint32_t, pdp::TrackingAllocator> moved(std::move(m));
+  emhash8::Map<uint32_t, uint32_t> moved(std::move(m));
   CHECK(moved.Size() == 100);
-
-  auto now_bytes = stats.GetBytesUsed();
-  CHECK(was_bytes == now_bytes);
+  CHECK(m.Size() == 0);
 
   for (uint32_t i = 0; i < 100; ++i) {
     auto *e = moved.Find(i);
@@ -242,12 +224,12 @@ TEST_CASE("Map<uint32_t, uint32_t>: high load / rehash stress") {
 
   // Remove a chunk, then insert again.
   for (uint32_t i = 0; i < N; i += 4) {
-    CHECK(m.Erase(i) == true);
+    CHECK(EraseKey(m, i) == true);
   }
   CHECK(m.Size() == N - (N + 3) / 4);
 
   for (uint32_t i = 0; i < N; i += 4) {
-    auto *e = m.EmplaceUnique(i, 123456u);
+    auto *e = m.Emplace(i, 123456u).it;
     REQUIRE(e != nullptr);
   }
   CHECK(m.Size() == N);
@@ -308,7 +290,7 @@ TEST_CASE("Map<StringSlice, uint32_t>: collisions & erase") {
   // Remove every 5th key.
   for (int i = 0; i < 1000; i += 5) {
     StringSlice k(storage[i].c_str());
-    CHECK(m.Erase(k) == true);
+    CHECK(EraseKey(m, k) == true);
   }
   CHECK(m.Size() == 1000 - 200);
 
@@ -347,36 +329,151 @@ TEST_CASE("Map<StringSlice, uint32_t>: Clear and reuse") {
   CHECK(e->value == 30u);
 }
 
-TEST_CASE("Map<StringSlice, uint32_t>: Swap / move semantics") {
+TEST_CASE("Map<StringSlice, uint32_t>: move semantics") {
   emhash8::Map<StringSlice, uint32_t> a;
-  emhash8::Map<StringSlice, uint32_t> b;
 
-  std::string a1 = "a1", a2 = "a2";
   std::string b1 = "b1", b2 = "b2", b3 = "b3";
+  a.Emplace(StringSlice(b1.c_str()), 10u);
+  a.Emplace(StringSlice(b2.c_str()), 20u);
+  a.Emplace(StringSlice(b3.c_str()), 30u);
+
+  emhash8::Map<StringSlice, uint32_t> c(std::move(a));
+  CHECK(c.Size() == 3);
+  CHECK(c.Find(StringSlice("b2")) != c.End());
+  CHECK(c.Find(StringSlice("a1")) == c.End());
+}
 
-  a.Emplace(StringSlice(a1.c_str()), 1u);
-  a.Emplace(StringSlice(a2.c_str()), 2u);
+// ------------------ ArenaStringMap ------------------
 
-  b.Emplace(StringSlice(b1.c_str()), 10u);
-  b.Emplace(StringSlice(b2.c_str()), 20u);
-  b.Emplace(StringSlice(b3.c_str()), 30u);
+TEST_CASE("ArenaStringMap: keys are copied into the arena") {
+  emhash8::ArenaStringMap<uint32_t> m;
 
-  a.Swap(b);
+  std::string key = "/home/user/src/a_rather_long_file_name.cc";
+  auto [it, is_new] = m.Emplace(StringSlice(key.c_str()), 7u);
+  CHECK(is_new);
+  CHECK(it->key.Cstr() != key.c_str());
+  CHECK(it->key.ToSlice() == StringSlice(key.c_str()));
+  CHECK(it->key.Cstr()[key.size()] == '\0');
 
-  CHECK(a.Size() == 3);
-  CHECK(b.Size() == 2);
+  // The caller's buffer may go away.
+  key.assign(key.size(), 'x');
+  auto *e = m.Find(StringSlice("/home/user/src/a_rather_long_file_name.cc"));
+  REQUIRE(e != m.End());
+  CHECK(e->value == 7u);
 
-  CHECK(a.Find(StringSlice("b1")) != a.End());
-  CHECK(a.Find(StringSlice("a1")) == a.End());
+  auto [again, again_is_new] =
+      m.Emplace(StringSlice("/home/user/src/a_rather_long_file_name.cc"));
+  CHECK(!again_is_new);
+  CHECK(again->value == 7u);
+}
 
-  emhash8::Map<StringSlice, uint32_t> c(std::move(a));
-  CHECK(c.Size() == 3);
-  CHECK(c.Find(StringSlice("b2")) != c.End());
+TEST_CASE("ArenaStringMap: keys sharing a prefix or a length") {
+  emhash8::ArenaStringMap<uint32_t> m;
+
+  const char *keys[] = {"", "a", "abcdefgh", "abcdefgi", "abcdefgh1", "abcdefgh2", "bbcdefgh1"};
+  for (uint32_t i = 0; i < std::size(keys); ++i) {
+    CHECK(m.Emplace(StringSlice(keys[i]), i).did_emplace);
+  }
+  CHECK(m.Size() == std::size(keys));
+
+  for (uint32_t i = 0; i < std::size(keys); ++i) {
+    auto *e = m.Find(StringSlice(keys[i]));
+    REQUIRE(e != m.End());
+    CHECK(e->value == i);
+    CHECK(e->key.Size() == strlen(keys[i]));
+  }
+  CHECK(m.Find(StringSlice("abcdefgh3")) == m.End());
+  CHECK(m.Find(StringSlice("abcdefg")) == m.End());
+}
+
+TEST_CASE("ArenaStringMap: rehash, erase and clear") {
+  emhash8::ArenaStringMap<uint32_t> m;
+
+  constexpr int N = 5000;
+  std::vector<std::string> storage;
+  storage.reserve(N);
+  for (int i = 0; i < N; ++i) {
+    storage.push_back("/src/dir" + std::to_string(i % 13) + "/file" + std::to_string(i) + ".cc");
+    m.EmplaceUnchecked(StringSlice(storage.back().c_str()), i);
+  }
+  CHECK(m.Size() == N);
+
+  for (int i = 0; i < N; i += 3) {
+    CHECK(EraseKey(m, StringSlice(storage[i].c_str())));
+  }
+  for (int i = 0; i < N; ++i) {
+    auto *e = m.Find(StringSlice(storage[i].c_str()));
+    if (i % 3 == 0) {
+      CHECK(e == m.End());
+    } else {
+      REQUIRE(e != m.End());
+      CHECK(e->value == (uint32_t)i);
+    }
+  }
+
+  m.Clear();
+  CHECK(m.Empty());
+  m.Emplace(StringSlice("again"), 1u);
+  CHECK(m.Find(StringSlice("again")) != m.End());
+  CHECK(m.Find(StringSlice(storage[1].c_str())) == m.End());
+}
+
+// ------------------ Benchmark ------------------
+
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1'000'000'000ull + ts.tv_nsec;
+}
+
+template <typename Map>
+void BenchStringMap(const char *name, const std::vector<std::string> &keys,
+                    const std::vector<std::string> &probes) {
+  constexpr int rounds = 20;
+  uint64_t insert_ns = 0;
+  uint64_t find_ns = 0;
+  uint64_t found = 0;
+  for (int r = 0; r < rounds; ++r) {
+    Map m;
+    uint64_t begin = NowNs();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      m.Emplace(StringSlice(keys[i].c_str(), keys[i].size()), (uint32_t)i);
+    }
+    uint64_t mid = NowNs();
+    for (const auto &probe : probes) {
+      found += m.Find(StringSlice(probe.c_str(), probe.size())) != m.End();
+    }
+    uint64_t end = NowNs();
+    insert_ns += mid - begin;
+    find_ns += end - mid;
+  }
+  printf("%-16s insert %6.1f ns/key, find %6.1f ns/key (%lu found)\n", name,
+         double(insert_ns) / (rounds * keys.size()), double(find_ns) / (rounds * probes.size()),
+         found / rounds);
+}
+
+}  // namespace
+
+TEST_CASE("StringMap vs ArenaStringMap benchmark") {
+  // Shaped like source paths: long shared directory prefix, distinct tails.
+  constexpr int N = 20000;
+  std::vector<std::string> keys;
+  std::vector<std::string> probes;
+  for (int i = 0; i < N; ++i) {
+    keys.push_back("/home/user/work/project/src/module" + std::to_string(i % 97) + "/file" +
+                   std::to_string(i) + ".cc");
+  }
+  std::mt19937 rng(123);
+  for (int i = 0; i < 4 * N; ++i) {
+    int idx = rng() % N;
+    // Half hits, half misses which agree on length and prefix.
+    probes.push_back(i % 2 ? keys[idx] : keys[idx].substr(0, keys[idx].size() - 2) + "cx");
+  }
 
-  emhash8::Map<StringSlice, uint32_t> d;
-  d = std::move(c);
-  CHECK(d.Size() == 3);
-  CHECK(d.Find(StringSlice("b3")) != d.End());
+  BenchStringMap<emhash8::StringMap<uint32_t>>("StringMap", keys, probes);
+  BenchStringMap<emhash8::ArenaStringMap<uint32_t>>("ArenaStringMap", keys, probes);
 }
 
 // ------------------ HASH test ------------------
@@ -4,7 +4,10 @@
 #include "tracing/execution_tracer.h"
 
 #include <fcntl.h>
+#include <sys/time.h>
 #include <unistd.h>
+#include <cerrno>
+#include <csignal>
 #include <cstring>
 
 using namespace pdp;
@@ -310,3 +313,89 @@ TEST_CASE("ExecutionTracer: waitpid error then fork+waitpid success (record/repl
   }
   tracer.StopReplaying();
 }
+
+TEST_CASE("ExecutionTracer: record and replay spawn") {
+  const char *record_path = "/tmp/pdp_spawn_record.bin";
+  unlink(record_path);
+
+  ExecutionTracer &tracer = g_recorder;
+
+  auto spawn_child = [](void *) -> pid_t {
+    pid_t pid = fork();
+    if (pid == 0) {
+      _exit(0);
+    }
+    return pid;
+  };
+  auto spawn_failure = [](void *) -> pid_t {
+    errno = ENOENT;
+    return -1;
+  };
+
+  // ------------------------------------------------------------
+  // RECORD
+  // ------------------------------------------------------------
+  tracer.StartRecording(record_path);
+
+  pid_t rec_pid = tracer.SyscallSpawn(spawn_child, nullptr);
+  REQUIRE(rec_pid > 0);
+  int status = 0;
+  CHECK(tracer.SyscallWaitPid(&status, 0) == rec_pid);
+
+  errno = 0;
+  CHECK(tracer.SyscallSpawn(spawn_failure, nullptr) == -1);
+  CHECK(errno == ENOENT);
+
+  tracer.StopRecording();
+
+  // ------------------------------------------------------------
+  // REPLAY
+  // ------------------------------------------------------------
+  tracer.StartReplaying(record_path);
+
+  auto must_not_run = [](void *) -> pid_t {
+    FAIL("spawn callback invoked during replay");
+    return -1;
+  };
+
+  CHECK(tracer.SyscallSpawn(must_not_run, nullptr) == rec_pid);
+  int replay_status = 0;
+  CHECK(tracer.SyscallWaitPid(&replay_status, 0) == rec_pid);
+  CHECK(replay_status == status);
+
+  errno = 0;
+  CHECK(tracer.SyscallSpawn(must_not_run, nullptr) == -1);
+  CHECK(errno == ENOENT);
+
+  tracer.StopReplaying();
+}
+
+TEST_CASE("ExecutionTracer: poll keeps waiting after a signal") {
+  int pipefd[2];
+  REQUIRE(pipe(pipefd) == 0);
+
+  struct sigaction sa;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  sa.sa_handler = [](int) {};
+  REQUIRE(sigaction(SIGALRM, &sa, nullptr) == 0);
+  struct itimerval timer{};
+  timer.it_value.tv_usec = 10'000;
+  REQUIRE(setitimer(ITIMER_REAL, &timer, nullptr) == 0);
+
+  ExecutionTracer &tracer = g_recorder;
+  struct pollfd pfd{};
+  pfd.fd = pipefd[0];
+  pfd.events = POLLIN;
+  struct timespec begin, end;
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  CHECK(tracer.SyscallPoll(&pfd, 1, 50) == 0);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  const long elapsed_ms =
+      (end.tv_sec - begin.tv_sec) * 1000 + (end.tv_nsec - begin.tv_nsec) / 1'000'000;
+  CHECK(elapsed_ms >= 45);
+
+  signal(SIGALRM, SIG_DFL);
+  close(pipefd[0]);
+  close(pipefd[1]);
+}
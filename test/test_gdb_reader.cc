@@ -0,0 +1,139 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "drivers/gdb_reader.h"
+
+#include <sys/poll.h>
+#include <unistd.h>
+#include <cstring>
+
+using namespace pdp;
+
+namespace {
+
+struct FakeGdb {
+  int stdin_read;
+  int stdout_write;
+  int stderr_write;
+
+  ~FakeGdb() {
+    close(stdin_read);
+    close(stdout_write);
+    close(stderr_write);
+  }
+
+  void WriteStdout(const char *s) { write(stdout_write, s, strlen(s)); }
+};
+
+FakeGdb SetupFakeGdb(GdbDriver &driver) {
+  int in[2];
+  int out[2];
+  int err[2];
+
+  pipe(in);
+  pipe(out);
+  pipe(err);
+
+  driver.Start(in[1], out[0], err[0]);
+  return {.stdin_read = in[0], .stdout_write = out[1], .stderr_write = err[1]};
+}
+
+bool WaitForWakeup(GdbReader &reader) {
+  struct pollfd poll_args;
+  poll_args.fd = reader.GetDescriptor();
+  poll_args.events = POLLIN;
+  poll_args.revents = 0;
+  return poll(&poll_args, 1, 1000) == 1;
+}
+
+}  // namespace
+
+TEST_CASE("GdbReader publishes parsed records in order") {
+  GdbDriver driver;
+  auto fake = SetupFakeGdb(driver);
+
+  GdbReader reader(driver);
+  reader.Start();
+
+  fake.WriteStdout("~\"hello\\n\"\n");
+  fake.WriteStdout("*stopped,reason=\"breakpoint-hit\",bkptno=\"1\"\n");
+  fake.WriteStdout("42^done,value=\"5\"\n");
+
+  int received = 0;
+  while (received < 3) {
+    REQUIRE(WaitForWakeup(reader));
+    reader.AcknowledgeWakeup();
+    for (GdbParsedRecord *record = reader.Front(); record; record = reader.Front()) {
+      switch (received) {
+        case 0:
+          CHECK(record->kind == GdbRecordKind::kStream);
+          CHECK(record->message == StringSlice("hello\n"));
+          break;
+        case 1:
+          CHECK(record->kind == GdbRecordKind::kAsync);
+          CHECK(record->sub_kind == static_cast<uint32_t>(GdbAsyncKind::kStopped));
+          CHECK(GdbExprView(record->expr)["reason"] == "breakpoint-hit");
+          CHECK(GdbExprView(record->expr)["bkptno"] == "1");
+          break;
+        case 2:
+          CHECK(record->kind == GdbRecordKind::kResult);
+          CHECK(record->token == 42);
+          CHECK(record->sub_kind == static_cast<uint32_t>(GdbResultKind::kDone));
+          CHECK(GdbExprView(record->expr)["value"] == "5");
+          break;
+      }
+      reader.PopFront();
+      ++received;
+    }
+  }
+  reader.Stop();
+  CHECK(received == 3);
+}
+
+TEST_CASE("GdbReader skips malformed records") {
+  GdbDriver driver;
+  auto fake = SetupFakeGdb(driver);
+
+  GdbReader reader(driver);
+  reader.Start();
+
+  fake.WriteStdout("1^done,value=\n");
+  fake.WriteStdout("2^done\n");
+
+  REQUIRE(WaitForWakeup(reader));
+  reader.AcknowledgeWakeup();
+  GdbParsedRecord *record = reader.Front();
+  REQUIRE(record);
+  CHECK(record->token == 2);
+  reader.PopFront();
+  reader.Stop();
+}
+
+TEST_CASE("GdbReader stops after GDB closes its output") {
+  GdbDriver driver;
+  auto fake = SetupFakeGdb(driver);
+
+  GdbReader reader(driver);
+  reader.Start();
+
+  fake.WriteStdout("1^done\n");
+  close(fake.stdout_write);
+  fake.stdout_write = -1;
+
+  GdbRecordKind kinds[2];
+  int received = 0;
+  while (received < 2) {
+    REQUIRE(WaitForWakeup(reader));
+    reader.AcknowledgeWakeup();
+    for (GdbParsedRecord *record = reader.Front(); record; record = reader.Front()) {
+      REQUIRE(received < 2);
+      kinds[received++] = record->kind;
+      reader.PopFront();
+    }
+  }
+  CHECK(kinds[0] == GdbRecordKind::kResult);
+  CHECK(kinds[1] == GdbRecordKind::kNone);
+  // The thread has left its loop, nothing else is published.
+  CHECK(!WaitForWakeup(reader));
+  reader.Stop();
+}
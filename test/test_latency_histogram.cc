@@ -0,0 +1,152 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/clock.h"
+#include "drivers/latency_stats.h"
+#include "tracing/latency_histogram.h"
+
+#include <unistd.h>
+#include <cstdio>
+
+using namespace pdp;
+
+TEST_CASE("small values are exact") {
+  LatencyHistogram hist;
+  for (uint64_t ns = 0; ns < 64; ++ns) {
+    CHECK(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(ns)) == ns);
+  }
+  hist.Record(7);
+  CHECK(hist.Count() == 1);
+  CHECK(hist.Percentile(50) == 7);
+  CHECK(hist.Max() == 7);
+}
+
+TEST_CASE("buckets bound the relative error") {
+  unsigned last_index = 0;
+  for (uint64_t ns = 1; ns < (uint64_t(1) << 39); ns += ns / 7 + 1) {
+    const unsigned index = LatencyHistogram::BucketIndex(ns);
+    REQUIRE(index < LatencyHistogram::num_buckets);
+    REQUIRE(index >= last_index);
+    last_index = index;
+    const uint64_t upper = LatencyHistogram::BucketUpperBound(index);
+    REQUIRE(upper >= ns);
+    REQUIRE(upper - ns <= ns / LatencyHistogram::sub_bucket_count);
+  }
+  // Huge values are clamped to the last bucket.
+  CHECK(LatencyHistogram::BucketIndex(UINT64_MAX) == LatencyHistogram::num_buckets - 1);
+}
+
+TEST_CASE("percentiles of a uniform distribution") {
+  LatencyHistogram hist;
+  for (uint64_t ns = 1; ns <= 100'000; ++ns) {
+    hist.Record(ns);
+  }
+  CHECK(hist.Count() == 100'000);
+  CHECK(hist.Max() == 100'000);
+  auto check_close = [](uint64_t value, uint64_t expected) {
+    CHECK(value >= expected);
+    CHECK(value <= expected + expected / 32);
+  };
+  check_close(hist.Percentile(50), 50'000);
+  check_close(hist.Percentile(90), 90'000);
+  check_close(hist.Percentile(99), 99'000);
+  CHECK(hist.Percentile(100) == 100'000);
+}
+
+TEST_CASE("merging adds the counts") {
+  LatencyHistogram low, high, both;
+  for (uint64_t ns = 1000; ns < 2000; ++ns) {
+    low.Record(ns);
+    both.Record(ns);
+  }
+  for (uint64_t ns = 1'000'000; ns < 1'001'000; ++ns) {
+    high.Record(ns);
+    both.Record(ns);
+  }
+  low.Merge(high);
+  CHECK(low.Count() == both.Count());
+  CHECK(low.Max() == both.Max());
+  CHECK(low.Percentile(25) == both.Percentile(25));
+  CHECK(low.Percentile(75) == both.Percentile(75));
+
+  low.Reset();
+  CHECK(low.Count() == 0);
+  CHECK(low.Percentile(50) == 0);
+}
+
+TEST_CASE("summary") {
+  LatencyHistogram hist;
+  hist.Record(1500);
+  StringBuilder<> out;
+  hist.AppendSummary(out);
+  CHECK(out.ToSlice() == "count 1 p50 1.5us p90 1.5us p99 1.5us max 1.5us");
+}
+
+TEST_CASE("async events are timed until their last RPC") {
+  LatencyStats stats;
+  const uint64_t arrival = ReadTsc();
+  stats.BeginAsyncEvent(GdbAsyncKind::kStopped, arrival);
+  stats.OnRpcWritten();
+  usleep(2000);
+  stats.OnRpcWritten();
+  // The next record ends the event.
+  stats.BeginAsyncEvent(GdbAsyncKind::kRunning, ReadTsc());
+  stats.EndAsyncEvent();
+
+  const LatencyHistogram &stopped = stats.AsyncLatency(GdbAsyncKind::kStopped);
+  REQUIRE(stopped.Count() == 1);
+  CHECK(stopped.Max() >= 2'000'000);
+  CHECK(stopped.Max() < 100'000'000);
+  // Nothing was written for it.
+  CHECK(stats.AsyncLatency(GdbAsyncKind::kRunning).Count() == 0);
+
+  StringBuilder<> report;
+  stats.AppendReport(report);
+  CHECK(report.ToSlice().MemMem("*stopped to last RPC: count 1"));
+  CHECK(report.ToSlice().MemMem("*running to last RPC: count 0"));
+  CHECK(report.ToSlice().MemMem("(no RPC 1)"));
+}
+
+TEST_CASE("commands are timed by verb") {
+  LatencyStats stats;
+  stats.OnCommandSent(1, "-break-insert {}");
+  stats.OnCommandSent(2, "-exec-run");
+  stats.OnCommandSent(3, "-break-insert {}");
+  usleep(1000);
+  stats.OnCommandResult(2, ReadTsc());
+  stats.OnCommandResult(1, ReadTsc());
+  stats.OnCommandResult(3, ReadTsc());
+  // Unknown and repeated tokens are ignored.
+  stats.OnCommandResult(3, ReadTsc());
+  stats.OnCommandResult(99, ReadTsc());
+
+  const LatencyHistogram *insert = stats.RoundTrip("-break-insert");
+  REQUIRE(insert);
+  CHECK(insert->Count() == 2);
+  CHECK(insert->Max() >= 1'000'000);
+  const LatencyHistogram *run = stats.RoundTrip("-exec-run");
+  REQUIRE(run);
+  CHECK(run->Count() == 1);
+  CHECK(!stats.RoundTrip("-exec-next"));
+}
+
+TEST_CASE("verbs past the limit share one slot") {
+  LatencyStats stats;
+  char command[32];
+  for (uint32_t token = 1; token <= 20; ++token) {
+    snprintf(command, sizeof(command), "-verb-%u", token);
+    stats.OnCommandSent(token, command);
+    stats.OnCommandResult(token, ReadTsc());
+  }
+  // 15 verbs get their own histogram, the other 5 are merged.
+  for (uint32_t token = 1; token <= 15; ++token) {
+    snprintf(command, sizeof(command), "-verb-%u", token);
+    const LatencyHistogram *own = stats.RoundTrip(command);
+    REQUIRE(own);
+    CHECK(own->Count() == 1);
+  }
+  CHECK(!stats.RoundTrip("-verb-16"));
+  const LatencyHistogram *other = stats.RoundTrip("(other)");
+  REQUIRE(other);
+  CHECK(other->Count() == 5);
+}
@@ -0,0 +1,66 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "data/arena.h"
+#include "data/memory_tags.h"
+#include "data/vector.h"
+
+using namespace pdp;
+
+TEST_CASE("live and peak bytes follow allocations") {
+  const int64_t live_before = MemoryTagLiveBytes(MemoryTag::kSsh);
+  TaggedAllocator<MemoryTag::kSsh> allocator;
+
+  void *small = allocator.AllocateRaw(100);
+  void *large = allocator.AllocateRaw(10'000);
+  REQUIRE(small);
+  REQUIRE(large);
+  const int64_t both = allocator.GetAllocationSize(small) + allocator.GetAllocationSize(large);
+  CHECK(MemoryTagLiveBytes(MemoryTag::kSsh) - live_before == both);
+
+  allocator.DeallocateRaw(large);
+  CHECK(MemoryTagLiveBytes(MemoryTag::kSsh) - live_before ==
+        int64_t(allocator.GetAllocationSize(small)));
+  CHECK(MemoryTagPeakBytes(MemoryTag::kSsh) >= live_before + both);
+
+  small = allocator.ReallocateRaw(small, 50'000);
+  REQUIRE(small);
+  CHECK(MemoryTagLiveBytes(MemoryTag::kSsh) - live_before ==
+        int64_t(allocator.GetAllocationSize(small)));
+  allocator.DeallocateRaw(small);
+  allocator.DeallocateRaw(nullptr);
+  CHECK(MemoryTagLiveBytes(MemoryTag::kSsh) == live_before);
+}
+
+TEST_CASE("containers charge their tag") {
+  const int64_t live_before = MemoryTagLiveBytes(MemoryTag::kBreakpoints);
+  {
+    Vector<int64_t, TaggedAllocator<MemoryTag::kBreakpoints>> vector;
+    for (int64_t i = 0; i < 1000; ++i) {
+      vector.Emplace(i);
+    }
+    CHECK(MemoryTagLiveBytes(MemoryTag::kBreakpoints) - live_before >=
+          int64_t(1000 * sizeof(int64_t)));
+  }
+  CHECK(MemoryTagLiveBytes(MemoryTag::kBreakpoints) == live_before);
+
+  // Arenas are tagged by default.
+  const int64_t arena_before = MemoryTagLiveBytes(MemoryTag::kArena);
+  {
+    ChainedArena<> arena(4096);
+    CHECK(MemoryTagLiveBytes(MemoryTag::kArena) - arena_before >= 4096);
+  }
+  CHECK(MemoryTagLiveBytes(MemoryTag::kArena) == arena_before);
+}
+
+TEST_CASE("report lists used tags") {
+  TaggedAllocator<MemoryTag::kPendingExtmarks> allocator;
+  allocator.DeallocateRaw(allocator.AllocateRaw(4096));
+
+  CHECK(ReadResidentBytes() > 0);
+  StringBuilder<> report;
+  AppendMemoryReport(report);
+  CHECK(report.ToSlice().StartsWith("rss "));
+  CHECK(report.ToSlice().MemMem(" pending-extmarks 0KB/"));
+  CHECK(!report.ToSlice().MemMem("rolling-buffer"));
+}
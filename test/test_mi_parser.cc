@@ -8,9 +8,10 @@
 using namespace pdp;
 
 TEST_CASE("simple param tuples") {
+  ChainedArena<> scratch;
   {
     StringSlice input("param=\"pagination\",value=\"off\"");
-    MiFirstPass first(input);
+    MiFirstPass first(input, scratch);
     REQUIRE(first.Parse());
 
     MiSecondPass second(input, first);
@@ -24,7 +25,7 @@ TEST_CASE("simple param tuples") {
 
   {
     StringSlice input("param=\"inferior-tty\",value=\"/dev/pts/0\"");
-    MiFirstPass first(input);
+    MiFirstPass first(input, scratch);
     REQUIRE(first.Parse());
 
     MiSecondPass second(input, first);
@@ -37,7 +38,7 @@ TEST_CASE("simple param tuples") {
 
   {
     StringSlice input("param=\"prompt\",value=\"\"");
-    MiFirstPass first(input);
+    MiFirstPass first(input, scratch);
     REQUIRE(first.Parse());
 
     MiSecondPass second(input, first);
@@ -50,7 +51,7 @@ TEST_CASE("simple param tuples") {
 
   {
     StringSlice input("param=\"max-completions\",value=\"20\"");
-    MiFirstPass first(input);
+    MiFirstPass first(input, scratch);
     REQUIRE(first.Parse());
 
     MiSecondPass second(input, first);
@@ -63,7 +64,7 @@ TEST_CASE("simple param tuples") {
 
   {
     StringSlice input("param=\"startup-with-shell\",value=\"off\"");
-    MiFirstPass first(input);
+    MiFirstPass first(input, scratch);
     REQUIRE(first.Parse());
 
     MiSecondPass second(input, first);
@@ -76,6 +77,7 @@ TEST_CASE("simple param tuples") {
 }
 
 TEST_CASE("bkpt tuple with mixed fields") {
+  ChainedArena<> scratch;
   StringSlice input(
       "bkpt={"
       "number=\"1\",type=\"breakpoint\",disp=\"del\",enabled=\"y\",addr=\"0x00000000000039fc\","
@@ -84,7 +86,7 @@ TEST_CASE("bkpt tuple with mixed fields") {
       "original-location=\"-qualified main\""
       "}");
 
-  MiFirstPass first(input);
+  MiFirstPass first(input, scratch);
   REQUIRE(first.Parse());
 
   MiSecondPass second(input, first);
@@ -107,12 +109,13 @@ TEST_CASE("bkpt tuple with mixed fields") {
 }
 
 TEST_CASE("shared object with ranges list") {
+  ChainedArena<> scratch;
   StringSlice input(
       "id=\"/lib/ld-linux-aarch64.so.1\",target-name=\"/lib/ld-linux-aarch64.so.1\","
       "host-name=\"/lib/ld-linux-aarch64.so.1\",symbols-loaded=\"0\",thread-group=\"i1\","
       "ranges=[{from=\"0x0000007ff7fc3d80\",to=\"0x0000007ff7fe1328\"}]");
 
-  MiFirstPass first(input);
+  MiFirstPass first(input, scratch);
   REQUIRE(first.Parse());
 
   MiSecondPass second(input, first);
@@ -132,13 +135,14 @@ TEST_CASE("shared object with ranges list") {
 }
 
 TEST_CASE("stop reason with nested frame and args") {
+  ChainedArena<> scratch;
   StringSlice input(
       "reason=\"breakpoint-hit\",disp=\"del\",bkptno=\"1\",frame={addr=\"0x00000055555539fc\","
       "func=\"main\",args=[{name=\"argc\"},{name=\"argv\"}],file=\"/home/stef/backtrace_tool.cc\","
       "fullname=\"/home/stef/backtrace_tool.cc\",line=\"182\",arch=\"aarch64\"},thread-id=\"1\","
       "stopped-threads=\"all\",core=\"2\"");
 
-  MiFirstPass first(input);
+  MiFirstPass first(input, scratch);
   REQUIRE(first.Parse());
 
   MiSecondPass second(input, first);
@@ -159,3 +163,74 @@ TEST_CASE("stop reason with nested frame and args") {
   CHECK(args[0u]["name"].RequireStr() == "argc");
   CHECK(args[1u]["name"].RequireStr() == "argv");
 }
+
+TEST_CASE("ParseMiResults rewinds the scratch arena") {
+  ChainedArena<> arena(256);
+  const ArenaMark mark = arena.Mark();
+
+  StringSlice input("frame={level=\"0\",args=[{name=\"argc\",value=\"1\"}],line=\"5\"}");
+  auto ptr = ParseMiResults(input, arena);
+  REQUIRE(ptr);
+  GdbExprView e(ptr.Get());
+  CHECK(e["frame"]["args"][0u]["name"].RequireStr() == "argc");
+
+  // The stacks did not fit in the first block, yet every block they needed was freed.
+  CHECK(arena.NumBlocks() == 1);
+  CHECK(arena.Mark().block == mark.block);
+  CHECK(arena.Mark().head == mark.head);
+
+  CHECK(ParseMiResults("frame={level=", arena).Get() == nullptr);
+  CHECK(arena.Mark().head == mark.head);
+}
+
+TEST_CASE("parsed record is a relocatable blob") {
+  ChainedArena<> scratch;
+  StringSlice input(
+      "threads=[{id=\"1\",frame={func=\"inner\",line=\"12\"}},{id=\"2\",frame={func=\"outer\","
+      "line=\"40\"}},{id=\"3\",frame={func=\"main\",line=\"7\"}}]");
+  auto ptr = ParseMiResults(input, scratch);
+  REQUIRE(ptr);
+
+  const uint32_t size = RelocatableExprSize(ptr.Get());
+  REQUIRE(size > 0);
+
+  StringBuilder<> before;
+  GdbExprView(ptr.Get()).ToJson(before);
+
+  // Copy the blob elsewhere and drop the original.
+  DefaultAllocator allocator;
+  void *copy = allocator.AllocateRaw(size);
+  memcpy(copy, ptr.Get(), size);
+  memset(ptr.Get(), 0xAB, size);
+
+  GdbExprView e(static_cast<ExprBase *>(copy));
+  CHECK(e["threads"].Count() == 3);
+  CHECK(e["threads"][1u]["frame"]["func"].RequireStr() == "outer");
+  CHECK(e["threads"][2u]["frame"]["line"].RequireInt() == 7);
+
+  StringBuilder<> after;
+  e.ToJson(after);
+  CHECK(before.ToSlice() == after.ToSlice());
+  allocator.DeallocateRaw(copy);
+}
+
+TEST_CASE("keys are stored once per record") {
+  ChainedArena<> scratch;
+  StringSlice input(
+      "a=[{level=\"0\",func=\"f\"},{level=\"1\",func=\"g\"},{func=\"h\",level=\"2\"}]");
+  auto ptr = ParseMiResults(input, scratch);
+  REQUIRE(ptr);
+
+  const ExprTuple *root = static_cast<const ExprTuple *>(ptr.Get());
+  const ExprBase *list = root->Value(0);
+  REQUIRE(list->kind == ExprBase::kList);
+  auto element = [&](uint32_t i) {
+    return static_cast<const ExprTuple *>(ExprBaseView::GetListElementUnchecked(list, i));
+  };
+
+  CHECK(StringSlice(element(0)->Key(0)) == "level");
+  CHECK(element(0)->Key(0) == element(1)->Key(0));
+  CHECK(element(0)->Key(0) == element(2)->Key(1));
+  CHECK(element(0)->Key(1) == element(2)->Key(0));
+  CHECK(GdbExprView(element(2))["level"].RequireInt() == 2);
+}
@@ -0,0 +1,98 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "data/mpsc_queue.h"
+#include "strings/fixed_string.h"
+#include "system/queue_notifier.h"
+
+#include <thread>
+
+using pdp::MpscQueue;
+
+TEST_CASE("MpscQueue push and pop in order") {
+  MpscQueue<int> q(4);
+
+  CHECK(q.Empty());
+  CHECK(q.Front() == nullptr);
+
+  CHECK(q.TryEmplaceBack(1));
+  CHECK(q.TryEmplaceBack(2));
+  CHECK(q.TryEmplaceBack(3));
+  CHECK(q.TryEmplaceBack(4));
+  CHECK_FALSE(q.TryEmplaceBack(5));
+
+  REQUIRE(q.Front());
+  CHECK(*q.Front() == 1);
+  q.PopFront();
+  CHECK(q.TryEmplaceBack(5));
+
+  int output[4];
+  CHECK(q.PopBatch(output, 4) == 4);
+  CHECK(output[0] == 2);
+  CHECK(output[3] == 5);
+  CHECK(q.Empty());
+}
+
+TEST_CASE("MpscQueue batch push is all or nothing") {
+  MpscQueue<int> q(8);
+
+  int input[6] = {0, 1, 2, 3, 4, 5};
+  CHECK(q.TryPushBatch(input, 6));
+  CHECK_FALSE(q.TryPushBatch(input, 3));
+  CHECK(q.TryPushBatch(input, 2));
+
+  int output[8];
+  CHECK(q.PopBatch(output, 8) == 8);
+  CHECK(output[5] == 5);
+  CHECK(output[6] == 0);
+  CHECK(output[7] == 1);
+}
+
+TEST_CASE("MpscQueue destroys remaining elements") {
+  MpscQueue<pdp::FixedString> q(4);
+  CHECK(q.TryEmplaceBack(pdp::StringSlice("a string which does not fit in place")));
+  CHECK(q.TryEmplaceBack(pdp::StringSlice("another one")));
+  q.PopFront();
+}
+
+TEST_CASE("MpscQueue keeps per-producer order") {
+  constexpr int num_producers = 4;
+  constexpr int count = 50'000;
+  MpscQueue<int> q(64);
+  pdp::QueueNotifier notifier;
+
+  std::thread producers[num_producers];
+  for (int p = 0; p < num_producers; ++p) {
+    producers[p] = std::thread([&, p]() {
+      for (int i = 0; i < count; i += 2) {
+        int batch[2] = {p * count + i, p * count + i + 1};
+        while (!q.TryPushBatch(batch, 2)) {
+          std::this_thread::yield();
+        }
+        notifier.Notify();
+      }
+    });
+  }
+
+  int expected[num_producers] = {};
+  bool in_order = true;
+  int received = 0;
+  while (received < num_producers * count) {
+    if (!notifier.WaitForElements(q, pdp::Milliseconds(1000))) {
+      break;
+    }
+    int value = *q.Front();
+    q.PopFront();
+    int p = value / count;
+    in_order &= (value % count == expected[p]);
+    ++expected[p];
+    ++received;
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  CHECK(in_order);
+  CHECK(received == num_producers * count);
+  CHECK(q.Empty());
+}
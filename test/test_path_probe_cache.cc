@@ -0,0 +1,134 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "coroutines/path_probe_awaiter.h"
+#include "drivers/path_probe_cache.h"
+
+#include <sys/poll.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace pdp;
+
+namespace {
+
+struct TempDir {
+  TempDir() {
+    strcpy(path, "/tmp/pdp_probe_XXXXXX");
+    REQUIRE(mkdtemp(path) != nullptr);
+    snprintf(file, sizeof(file), "%s/file.cc", path);
+    snprintf(link, sizeof(link), "%s/link.cc", path);
+
+    int fd = open(file, O_CREAT | O_WRONLY, 0644);
+    REQUIRE(fd >= 0);
+    close(fd);
+    REQUIRE(symlink(file, link) == 0);
+  }
+
+  ~TempDir() {
+    unlink(link);
+    unlink(file);
+    rmdir(path);
+  }
+
+  char path[64];
+  char file[96];
+  char link[96];
+};
+
+Coroutine ProbeOnPool(PathProbeCache &cache, ThreadPool &pool, StringSlice path, int *readable) {
+  const PathProbe &probe = co_await PathProbeAwaiter(cache, pool, path);
+  *readable = probe.readable;
+}
+
+}  // namespace
+
+TEST_CASE("PathProbeCache: resolves symlinks and readability") {
+  TempDir dir;
+  PathProbeCache cache;
+
+  const PathProbe &probe = cache.Probe(dir.link);
+  CHECK(probe.readable);
+  CHECK(probe.real_path.ToSlice() == StringSlice(dir.file));
+  CHECK(cache.Size() == 1);
+
+  const PathProbe *hit = cache.Find(dir.link);
+  REQUIRE(hit);
+  CHECK(hit->real_path.ToSlice() == StringSlice(dir.file));
+}
+
+TEST_CASE("PathProbeCache: missing file keeps the raw path") {
+  PathProbeCache cache;
+  const PathProbe &probe = cache.Probe("/nonexistent/pdp/file.cc");
+  CHECK_FALSE(probe.readable);
+  CHECK(probe.real_path.ToSlice() == StringSlice("/nonexistent/pdp/file.cc"));
+}
+
+TEST_CASE("PathProbeCache: entries expire and can be invalidated") {
+  TempDir dir;
+
+  PathProbeCache cache;
+  CHECK(cache.Probe(dir.file).readable);
+  // Stale answer until the entry is invalidated.
+  unlink(dir.link);
+  unlink(dir.file);
+  CHECK(cache.Probe(dir.file).readable);
+  cache.Invalidate(dir.file);
+  CHECK(cache.Find(dir.file) == nullptr);
+  CHECK_FALSE(cache.Probe(dir.file).readable);
+
+  PathProbeCache expired(0_ms);
+  expired.Probe(dir.file);
+  CHECK(expired.Find(dir.file) == nullptr);
+}
+
+TEST_CASE("PathProbeCache: a full cache starts over") {
+  PathProbeCache cache;
+  char path[64];
+  for (size_t i = 0; i < PathProbeCache::max_entries; ++i) {
+    snprintf(path, sizeof(path), "/nonexistent/pdp/%zu.cc", i);
+    cache.Probe(path);
+  }
+  CHECK(cache.Size() == PathProbeCache::max_entries);
+  // Refreshing a known path does not drop anything.
+  cache.Probe("/nonexistent/pdp/0.cc");
+  CHECK(cache.Size() == PathProbeCache::max_entries);
+
+  cache.Probe("/nonexistent/pdp/one_more.cc");
+  CHECK(cache.Size() == 1);
+  CHECK(cache.Find("/nonexistent/pdp/one_more.cc") != nullptr);
+}
+
+TEST_CASE("PathProbeAwaiter: misses are resolved on the pool") {
+  TempDir dir;
+  PathProbeCache cache;
+
+  ThreadPool pool(2);
+  int readable = -1;
+  ProbeOnPool(cache, pool, dir.link, &readable);
+  while (pool.NumPending() > 0) {
+    struct pollfd poll_args;
+    poll_args.fd = pool.GetDescriptor();
+    poll_args.events = POLLIN;
+    poll_args.revents = 0;
+    REQUIRE(poll(&poll_args, 1, 1000) == 1);
+    pool.DrainCompletions();
+  }
+  CHECK(readable == 1);
+  CHECK(cache.Find(dir.link) != nullptr);
+
+  // A hit does not suspend.
+  readable = -1;
+  ProbeOnPool(cache, pool, dir.link, &readable);
+  CHECK(readable == 1);
+  CHECK(pool.NumPending() == 0);
+
+  ThreadPool inline_pool(0);
+  PathProbeCache other_cache;
+  readable = -1;
+  ProbeOnPool(other_cache, inline_pool, dir.file, &readable);
+  CHECK(readable == 1);
+}
@@ -0,0 +1,82 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "strings/path_table.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace pdp;
+
+TEST_CASE("PathTable empty path is no_path") {
+  PathTable table;
+  CHECK(table.Intern("") == PathTable::no_path);
+  CHECK(table.Find("") == PathTable::no_path);
+  CHECK(table.Get(PathTable::no_path).Empty());
+  CHECK(table.Cstr(PathTable::no_path)[0] == '\0');
+  CHECK(table.Size() == 1);
+}
+
+TEST_CASE("PathTable interning is idempotent") {
+  PathTable table;
+  PathId a = table.Intern("/home/user/src/main.c");
+  PathId b = table.Intern("/home/user/src/util.c");
+  CHECK(a != PathTable::no_path);
+  CHECK(b != PathTable::no_path);
+  CHECK(a != b);
+
+  CHECK(table.Intern("/home/user/src/main.c") == a);
+  CHECK(table.Intern(StringSlice("/home/user/src/util.c")) == b);
+  CHECK(table.Size() == 3);
+
+  CHECK(table.Get(a) == StringSlice("/home/user/src/main.c"));
+  CHECK(strcmp(table.Cstr(b), "/home/user/src/util.c") == 0);
+}
+
+TEST_CASE("PathTable Find does not insert") {
+  PathTable table;
+  CHECK(table.Find("/usr/include/stdio.h") == PathTable::no_path);
+  CHECK(table.Size() == 1);
+
+  PathId id = table.Intern("/usr/include/stdio.h");
+  CHECK(table.Find("/usr/include/stdio.h") == id);
+  // Prefixes are distinct paths.
+  CHECK(table.Find("/usr/include/stdio") == PathTable::no_path);
+}
+
+TEST_CASE("PathTable ids are stable across growth") {
+  PathTable table;
+  char buf[64];
+  const int n = 5000;
+  for (int i = 0; i < n; ++i) {
+    int len = snprintf(buf, sizeof(buf), "/src/dir%d/file%d.cc", i % 17, i);
+    CHECK(table.Intern(StringSlice(buf, len)) == static_cast<PathId>(i + 1));
+  }
+  CHECK(table.Size() == n + 1);
+
+  for (int i = 0; i < n; ++i) {
+    int len = snprintf(buf, sizeof(buf), "/src/dir%d/file%d.cc", i % 17, i);
+    StringSlice path(buf, len);
+    PathId id = table.Find(path);
+    REQUIRE(id == static_cast<PathId>(i + 1));
+    CHECK(table.Get(id) == path);
+    CHECK(table.Cstr(id)[len] == '\0');
+  }
+}
+
+TEST_CASE("PathTable slices stay valid while the table grows") {
+  PathTable table;
+  PathId first = table.Intern("/home/user/src/first.cc");
+  StringSlice slice = table.Get(first);
+  const char *cstr = table.Cstr(first);
+
+  char buf[64];
+  for (int i = 0; i < 2000; ++i) {
+    int len = snprintf(buf, sizeof(buf), "/home/user/src/generated/file%d.cc", i);
+    table.Intern(StringSlice(buf, len));
+  }
+  CHECK(table.Get(first).Begin() == slice.Begin());
+  CHECK(table.Cstr(first) == cstr);
+  CHECK(slice == StringSlice("/home/user/src/first.cc"));
+  CHECK(table.ArenaBytes() > 2000 * 30);
+}
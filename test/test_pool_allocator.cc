@@ -0,0 +1,125 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "data/pool_allocator.h"
+#include "data/vector.h"
+
+#include <cstring>
+#include <thread>
+
+using pdp::PoolAllocator;
+
+TEST_CASE("PoolAllocator: size classes round up and are monotonic") {
+  using pdp::impl::_PoolSmallClass;
+  using pdp::impl::_PoolSmallClassSize;
+
+  CHECK(_PoolSmallClass(1) == 0);
+  CHECK(_PoolSmallClassSize(0) == 16);
+  CHECK(_PoolSmallClassSize(_PoolSmallClass(128)) == 128);
+  CHECK(_PoolSmallClassSize(_PoolSmallClass(129)) == 160);
+  CHECK(_PoolSmallClass(4096) == pdp::impl::_pool_num_small_classes - 1);
+  CHECK(_PoolSmallClassSize(pdp::impl::_pool_num_small_classes - 1) == 4096);
+
+  size_t previous = 0;
+  for (size_t bytes = 1; bytes <= 4096; ++bytes) {
+    const size_t size = _PoolSmallClassSize(_PoolSmallClass(bytes));
+    REQUIRE(size >= bytes);
+    REQUIRE(size >= previous);
+    REQUIRE(size - bytes < bytes / 4 + 16);
+    previous = size;
+  }
+}
+
+TEST_CASE("PoolAllocator: freed small blocks are reused") {
+  PoolAllocator alloc;
+  void *first = alloc.AllocateRaw(40);
+  CHECK(alloc.GetAllocationSize(first) == 48);
+  CHECK(reinterpret_cast<uintptr_t>(first) % 16 == 0);
+  alloc.DeallocateRaw(first);
+
+  const auto before = pdp::GetPoolAllocatorStats();
+  void *second = alloc.AllocateRaw(33);
+  CHECK(second == first);
+  const auto after = pdp::GetPoolAllocatorStats();
+  CHECK(after.small_hits == before.small_hits + 1);
+  alloc.DeallocateRaw(second);
+}
+
+TEST_CASE("PoolAllocator: reallocate keeps the contents") {
+  PoolAllocator alloc;
+  char *ptr = static_cast<char *>(alloc.AllocateRaw(10));
+  memcpy(ptr, "123456789", 10);
+  // Fits in the same class.
+  CHECK(alloc.ReallocateRaw(ptr, 16) == ptr);
+
+  for (size_t size : {100, 5000, 300'000, 3'000'000}) {
+    ptr = static_cast<char *>(alloc.ReallocateRaw(ptr, size));
+    REQUIRE(ptr);
+    CHECK(alloc.GetAllocationSize(ptr) >= size);
+    CHECK(strcmp(ptr, "123456789") == 0);
+    ptr[size - 1] = 'x';
+  }
+  alloc.DeallocateRaw(ptr);
+}
+
+TEST_CASE("PoolAllocator: large spans are cached and trimmed over the limit") {
+  PoolAllocator alloc;
+  void *span = alloc.AllocateRaw(20'000);
+  CHECK(alloc.GetAllocationSize(span) == 32 * 1024 - 16);
+  alloc.DeallocateRaw(span);
+
+  const auto before = pdp::GetPoolAllocatorStats();
+  void *again = alloc.AllocateRaw(30'000);
+  CHECK(again == span);
+  CHECK(pdp::GetPoolAllocatorStats().large_hits == before.large_hits + 1);
+
+  pdp::SetPoolRetainedBytes(1);
+  alloc.DeallocateRaw(again);
+  const auto trimmed = pdp::GetPoolAllocatorStats();
+  CHECK(trimmed.trimmed_bytes > before.trimmed_bytes);
+
+  // The span is still handed out, its pages are faulted back in on demand.
+  char *reused = static_cast<char *>(alloc.AllocateRaw(30'000));
+  CHECK(reused == span);
+  memset(reused, 1, 30'000);
+  CHECK(pdp::GetPoolAllocatorStats().retained_bytes == trimmed.retained_bytes);
+  alloc.DeallocateRaw(reused);
+  pdp::SetPoolRetainedBytes(0);
+}
+
+TEST_CASE("PoolAllocator: thread caches flush into the global lists") {
+  const auto before = pdp::GetPoolAllocatorStats();
+  std::thread worker([]() {
+    PoolAllocator alloc;
+    void *blocks[64];
+    for (void *&block : blocks) {
+      block = alloc.AllocateRaw(200);
+    }
+    for (void *block : blocks) {
+      alloc.DeallocateRaw(block);
+    }
+  });
+  worker.join();
+
+  const auto after = pdp::GetPoolAllocatorStats();
+  CHECK(after.small_misses >= before.small_misses + 64);
+  CHECK(after.retained_bytes >= before.retained_bytes + 64 * 224);
+
+  // This thread picks the blocks up from the global list.
+  PoolAllocator alloc;
+  void *block = alloc.AllocateRaw(200);
+  CHECK(pdp::GetPoolAllocatorStats().small_refills == after.small_refills + 1);
+  alloc.DeallocateRaw(block);
+}
+
+TEST_CASE("PoolAllocator: works as a container allocator") {
+  pdp::Vector<int, PoolAllocator> v;
+  for (int i = 0; i < 100'000; ++i) {
+    v += i;
+  }
+  int64_t sum = 0;
+  for (size_t i = 0; i < v.Size(); ++i) {
+    sum += v[i];
+  }
+  CHECK(sum == int64_t(100'000) * 99'999 / 2);
+}
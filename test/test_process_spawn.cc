@@ -0,0 +1,123 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "system/process_spawn.h"
+
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <string>
+
+using namespace pdp;
+
+namespace {
+
+int WaitExitCode(pid_t pid) {
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  REQUIRE(WIFEXITED(status));
+  return WEXITSTATUS(status);
+}
+
+std::string ReadAll(int fd) {
+  std::string res;
+  char buf[256];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    res.append(buf, n);
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST_CASE("SpawnProcess: exit code is reported") {
+  SpawnActions actions;
+  const char *const argv[] = {"sh", "-c", "exit 7", nullptr};
+  pid_t pid = SpawnProcess(actions, "/bin/sh", argv);
+  REQUIRE(pid > 0);
+  CHECK(WaitExitCode(pid) == 7);
+}
+
+TEST_CASE("SpawnProcess: dup2 redirects output") {
+  int out[2];
+  REQUIRE(pipe2(out, O_CLOEXEC) == 0);
+
+  SpawnActions actions;
+  actions.AddDup2(out[1], STDOUT_FILENO);
+  const char *const argv[] = {"sh", "-c", "echo hello", nullptr};
+  pid_t pid = SpawnProcess(actions, "/bin/sh", argv);
+  REQUIRE(pid > 0);
+  close(out[1]);
+
+  CHECK(ReadAll(out[0]) == "hello\n");
+  CHECK(WaitExitCode(pid) == 0);
+  close(out[0]);
+}
+
+TEST_CASE("SpawnProcess: open and close actions") {
+  int out[2];
+  REQUIRE(pipe2(out, O_CLOEXEC) == 0);
+
+  SpawnActions actions;
+  actions.AddOpen(STDIN_FILENO, "/dev/null", O_RDONLY);
+  actions.AddDup2(out[1], STDOUT_FILENO);
+  actions.AddClose(STDERR_FILENO);
+  const char *const argv[] = {"cat", nullptr};
+  pid_t pid = SpawnProcessInPath(actions, "cat", argv);
+  REQUIRE(pid > 0);
+  close(out[1]);
+
+  CHECK(ReadAll(out[0]).empty());
+  CHECK(WaitExitCode(pid) == 0);
+  close(out[0]);
+}
+
+TEST_CASE("SpawnProcess: missing executable fails in the parent") {
+  SpawnActions actions;
+  const char *const argv[] = {"pdp-does-not-exist", nullptr};
+
+  errno = 0;
+  CHECK(SpawnProcess(actions, "/nonexistent/pdp-does-not-exist", argv) == -1);
+  CHECK(errno == ENOENT);
+
+  errno = 0;
+  CHECK(SpawnProcessInPath(actions, "pdp-does-not-exist", argv) == -1);
+  CHECK(errno == ENOENT);
+}
+
+TEST_CASE("SpawnProcess: death signal is delivered when the parent exits") {
+  // Orphans are reparented to us, so the grandchild can be waited for.
+  REQUIRE(prctl(PR_SET_CHILD_SUBREAPER, 1) == 0);
+
+  int channel[2];
+  REQUIRE(pipe(channel) == 0);
+
+  pid_t middle = fork();
+  REQUIRE(middle >= 0);
+  if (middle == 0) {
+    SpawnActions actions;
+    actions.SetDeathSignal(SIGTERM);
+    const char *const argv[] = {"sleep", "10", nullptr};
+    pid_t pid = SpawnProcessInPath(actions, "sleep", argv);
+    write(channel[1], &pid, sizeof(pid));
+    _exit(0);
+  }
+
+  pid_t sleeper = -1;
+  REQUIRE(read(channel[0], &sleeper, sizeof(sleeper)) == sizeof(sleeper));
+  REQUIRE(sleeper > 0);
+  CHECK(WaitExitCode(middle) == 0);
+
+  int status = 0;
+  REQUIRE(waitpid(sleeper, &status, 0) == sleeper);
+  CHECK(WIFSIGNALED(status));
+  CHECK(WTERMSIG(status) == SIGTERM);
+
+  close(channel[0]);
+  close(channel[1]);
+  prctl(PR_SET_CHILD_SUBREAPER, 0);
+}
@@ -0,0 +1,245 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/log.h"
+#include "core/ring_log.h"
+#include "system/thread.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+
+using namespace pdp;
+
+static int TempFile() {
+  char path[] = "/tmp/pdp_test_ring_log_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  unlink(path);
+  return fd;
+}
+
+TEST_CASE("ring is read in order") {
+  int fd = TempFile();
+  RingLogHeader *ring = CreateRingLog(fd, 100);
+  REQUIRE(ring);
+  CHECK(ring->capacity == 4096);
+  struct stat st;
+  REQUIRE(fstat(fd, &st) == 0);
+  CHECK(st.st_size == sizeof(RingLogHeader) + 4096);
+
+  RingLogReader reader;
+  REQUIRE(OpenRingLog(fd, reader));
+  CHECK(reader.capacity == 4096);
+  StringBuilder<> out;
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.Size() == 0);
+
+  AppendRingLog(ring, "first\n");
+  AppendRingLog(ring, "second\n");
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() == "first\nsecond\n");
+  CHECK(reader.offset == 13);
+
+  AppendRingLog(ring, "third\n");
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() == "first\nsecond\nthird\n");
+  CHECK(reader.session == 0);
+  CloseRingLog(reader);
+  CloseRingLog(ring);
+  close(fd);
+}
+
+TEST_CASE("oldest bytes are overwritten") {
+  int fd = TempFile();
+  RingLogHeader *ring = CreateRingLog(fd, 4096);
+  REQUIRE(ring);
+
+  char line[100];
+  memset(line, 'a', sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\n';
+  for (int i = 0; i < 50; ++i) {
+    line[0] = 'a' + i % 26;
+    AppendRingLog(ring, StringSlice(line, sizeof(line)));
+  }
+
+  RingLogReader reader;
+  REQUIRE(OpenRingLog(fd, reader));
+  StringBuilder<> out;
+  CHECK(ReadRingLog(reader, false, out) == 5000 - 4096);
+  REQUIRE(out.Size() == 4096);
+  CHECK(reader.offset == 5000);
+  // The last line wrapped around the end of the data.
+  CHECK(out.ToSlice().GetLeft(4) == "aaaa");
+  CHECK(out.Data()[4096 - 100] == 'a' + 49 % 26);
+  CHECK(out.Data()[4095] == '\n');
+
+  // A string longer than the ring keeps its tail.
+  StringBuilder<> huge;
+  for (int i = 0; i < 5000; ++i) {
+    huge.Append(static_cast<char>('0' + i % 10));
+  }
+  AppendRingLog(ring, huge.ToSlice());
+  out.Clear();
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() == StringSlice(huge.Data() + 5000 - 4096, 4096));
+  CloseRingLog(reader);
+  CloseRingLog(ring);
+  close(fd);
+}
+
+TEST_CASE("contents survive the writer") {
+  int fd = TempFile();
+  RingLogHeader *ring = CreateRingLog(fd, 4096);
+  REQUIRE(ring);
+  AppendRingLog(ring, "before crash\n");
+  // An append which never finished.
+  ring->reserved.fetch_add(4, std::memory_order_relaxed);
+  CloseRingLog(ring);
+
+  RingLogReader reader;
+  REQUIRE(OpenRingLog(fd, reader));
+  StringBuilder<> out;
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.Size() == 0);
+  CHECK(ReadRingLog(reader, true, out) == 0);
+  CHECK(out.ToSlice().GetLeft(13) == "before crash\n");
+  CHECK(out.Size() == 17);
+  CloseRingLog(reader);
+
+  // Not a ring.
+  int plain = TempFile();
+  REQUIRE(write(plain, "[2026-01-02] text log\n", 22) == 22);
+  RingLogReader not_ring;
+  CHECK(!OpenRingLog(plain, not_ring));
+  close(plain);
+  close(fd);
+}
+
+TEST_CASE("a new session restarts the reader") {
+  int fd = TempFile();
+  RingLogHeader *ring = CreateRingLog(fd, 8192);
+  REQUIRE(ring);
+  AppendRingLog(ring, "first session, with a long first line\n");
+  RingLogReader reader;
+  REQUIRE(OpenRingLog(fd, reader));
+  StringBuilder<> out;
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CloseRingLog(ring);
+
+  // Same capacity, the log is shorter than what was read.
+  ring = CreateRingLog(fd, 8192);
+  REQUIRE(ring);
+  AppendRingLog(ring, "second\n");
+  out.Clear();
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() == "second\n");
+  CHECK(reader.session == 1);
+  CloseRingLog(ring);
+
+  // A smaller ring does not shrink the file under the mapping of the reader.
+  ring = CreateRingLog(fd, 4096);
+  REQUIRE(ring);
+  struct stat st;
+  REQUIRE(fstat(fd, &st) == 0);
+  CHECK(st.st_size == sizeof(RingLogHeader) + 8192);
+  AppendRingLog(ring, "third session\n");
+  out.Clear();
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() == "third session\n");
+  CHECK(reader.session == 2);
+  CHECK(reader.capacity == 4096);
+  CloseRingLog(ring);
+
+  // A larger one is mapped again.
+  ring = CreateRingLog(fd, 16384);
+  REQUIRE(ring);
+  AppendRingLog(ring, "fourth session, long enough to be past the offset\n");
+  out.Clear();
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() == "fourth session, long enough to be past the offset\n");
+  CHECK(reader.session == 3);
+  CHECK(reader.capacity == 16384);
+  CloseRingLog(ring);
+
+  // Same capacity again, and the new session already wrote past the offset.
+  ring = CreateRingLog(fd, 16384);
+  REQUIRE(ring);
+  AppendRingLog(ring, "fifth session, which writes more than the fourth one before it is read\n");
+  out.Clear();
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(out.ToSlice() ==
+        "fifth session, which writes more than the fourth one before it is read\n");
+  CHECK(reader.session == 4);
+  CloseRingLog(ring);
+  CloseRingLog(reader);
+  close(fd);
+}
+
+TEST_CASE("concurrent appends are not torn") {
+  int fd = TempFile();
+  RingLogHeader *ring = CreateRingLog(fd, 1 << 20);
+  REQUIRE(ring);
+  static RingLogHeader *shared_ring = ring;
+  struct Writer {
+    void operator()() {
+      for (int i = 0; i < 10'000; ++i) {
+        AppendRingLog(shared_ring, "0123456789abcdef\n");
+      }
+    }
+  };
+  Thread threads[4];
+  for (auto &thread : threads) {
+    thread.Start(Writer{});
+  }
+  for (auto &thread : threads) {
+    thread.Wait();
+  }
+
+  RingLogReader reader;
+  REQUIRE(OpenRingLog(fd, reader));
+  StringBuilder<> out;
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  REQUIRE(out.Size() == 4 * 10'000 * 17);
+  StringSlice text = out.ToSlice();
+  bool all_whole = true;
+  while (!text.Empty()) {
+    all_whole &= text.GetLeft(17) == "0123456789abcdef\n";
+    text.DropLeft(17);
+  }
+  CHECK(all_whole);
+  CloseRingLog(reader);
+  CloseRingLog(ring);
+  close(fd);
+}
+
+TEST_CASE("log messages go to the ring") {
+  char path[] = "/tmp/pdp_test_ring_log_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  // Old contents are dropped.
+  REQUIRE(write(fd, "previous session\n", 17) == 17);
+  close(fd);
+
+  RedirectLoggingToRing(path, 64 * 1024);
+  CHECK(IsRingLogging());
+  pdp_info("ring message {}", 42);
+  LogUnformatted("raw text\n");
+
+  fd = open(path, O_RDONLY);
+  unlink(path);
+  REQUIRE(fd >= 0);
+  // The session still holds the lock.
+  CHECK(!LockLogFile(fd));
+  RingLogReader reader;
+  REQUIRE(OpenRingLog(fd, reader));
+  CHECK(reader.capacity == 64 * 1024);
+  StringBuilder<> out;
+  CHECK(ReadRingLog(reader, false, out) == 0);
+  CHECK(!out.ToSlice().MemMem("previous session"));
+  CHECK(out.ToSlice().MemMem("ring message 42\n"));
+  CHECK(out.ToSlice().MemMem("raw text\n"));
+  CloseRingLog(reader);
+  close(fd);
+}
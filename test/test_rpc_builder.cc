@@ -40,7 +40,8 @@ static ParseResult ParseFromBuilder(const RpcBytes &msg) {
 }
 
 static UniquePtr<char> MakeString(size_t len, char c = 'x') {
-  UniquePtr<char> res((char *)malloc(len));
+  DefaultAllocator allocator;
+  UniquePtr<char> res(Allocate<char>(allocator, len));
   memset(res.Get(), c, len);
   return res;
 }
@@ -97,6 +98,28 @@ TEST_CASE("rpc builder: notification scalar arguments") {
   CHECK(e[3][4].AsString() == "hello");
 }
 
+TEST_CASE("rpc builder: response to a request") {
+  RpcBuilder b;
+  b.RestartResponse(7);
+  b.AddNil();
+  b.OpenShortMap();
+  b.AddMapItem("live", int64_t(4096));
+  b.AddMapItem("peak", int64_t(8192));
+  b.CloseShortMap();
+
+  RpcBytes msg = b.Finish();
+  const unsigned char header[] = {0x94, 0x01, 0x07, 0xc0};
+  REQUIRE(msg.bytes > sizeof(header));
+  CHECK(memcmp(msg.data, header, sizeof(header)) == 0);
+
+  auto [e, chunks] = ParseFromBuilder(msg);
+  REQUIRE(e.Count() == 4);
+  CHECK(e[0u].AsInteger() == 1);
+  CHECK(e[1].AsInteger() == 7);
+  CHECK(e[3]["live"].AsInteger() == 4096);
+  CHECK(e[3]["peak"].AsInteger() == 8192);
+}
+
 TEST_CASE("rpc builder: nested arrays in args") {
   RpcBuilder b(2, "nested_test");
   b.OpenShortArray();
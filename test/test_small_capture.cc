@@ -95,7 +95,8 @@ TEST_CASE("SmallCapture: move-only argument is forwarded") {
 
   cap.Bind<Consume>(&result);
 
-  UniquePtr<int> ptr((int *)malloc(sizeof(int)));
+  DefaultAllocator allocator;
+  UniquePtr<int> ptr(Allocate<int>(allocator, 1));
   *ptr = 42;
   cap(std::move(ptr));
 
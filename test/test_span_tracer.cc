@@ -0,0 +1,109 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "system/thread.h"
+#include "tracing/span_tracer.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace pdp;
+
+/// @brief Exports all rings and returns the JSON, null terminated.
+static char *ExportToString() {
+  char path[] = "/tmp/pdp_test_span_tracer_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  REQUIRE(ExportChromeTrace(path));
+  unlink(path);
+
+  struct stat st;
+  REQUIRE(fstat(fd, &st) == 0);
+  char *json = static_cast<char *>(malloc(st.st_size + 1));
+  REQUIRE(pread(fd, json, st.st_size, 0) == st.st_size);
+  json[st.st_size] = '\0';
+  close(fd);
+  return json;
+}
+
+static size_t CountOccurrences(const char *text, const char *needle) {
+  size_t count = 0;
+  for (const char *it = strstr(text, needle); it; it = strstr(it + 1, needle)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST_CASE("spans and instants are exported") {
+  {
+    PDP_TRACE_SPAN("outer");
+    PDP_TRACE_SPAN("inner", 42);
+    PDP_TRACE_INSTANT("marker");
+  }
+  RecordTraceEvent(TracePhase::kAsyncBegin, "handler", 0xabc);
+  RecordTraceEvent(TracePhase::kAsyncEnd, "handler", 0xabc);
+
+  char *json = ExportToString();
+  CHECK(strncmp(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) == 0);
+  CHECK(strstr(json, "{\"name\":\"outer\",\"ph\":\"B\",\"ts\":"));
+  CHECK(strstr(json, "{\"name\":\"inner\",\"ph\":\"E\",\"ts\":"));
+  CHECK(strstr(json, "\"args\":{\"arg\":42}}"));
+  CHECK(strstr(json, "{\"name\":\"marker\",\"ph\":\"i\",\"ts\":"));
+  CHECK(strstr(json, "\"cat\":\"async\",\"id\":\"0xabc\"}"));
+  CHECK(strcmp(json + strlen(json) - 4, "\n]}\n") == 0);
+  free(json);
+}
+
+TEST_CASE("each thread records into its own ring") {
+  struct Worker {
+    void operator()() {
+      for (int i = 0; i < 100; ++i) {
+        PDP_TRACE_SPAN("worker span");
+      }
+    }
+  };
+  Thread threads[2];
+  for (auto &thread : threads) {
+    thread.Start(Worker{});
+  }
+  for (auto &thread : threads) {
+    thread.Wait();
+  }
+
+  char *json = ExportToString();
+  CHECK(CountOccurrences(json, "\"name\":\"worker span\",\"ph\":\"B\"") == 200);
+  // The 100 spans of the first worker, begin and end, carry its thread id.
+  const char *first = strstr(json, "\"name\":\"worker span\"");
+  REQUIRE(first);
+  const char *tid = strstr(first, "\"tid\":");
+  REQUIRE(tid);
+  char needle[32];
+  snprintf(needle, sizeof(needle), "\"tid\":%d}", atoi(tid + 6));
+  CHECK(CountOccurrences(json, needle) == 200);
+  free(json);
+}
+
+TEST_CASE("rings keep the most recent events") {
+  for (uint64_t i = 1; i <= 20000; ++i) {
+    PDP_TRACE_INSTANT("flood", i);
+  }
+  char *json = ExportToString();
+  const size_t num_flood = CountOccurrences(json, "\"name\":\"flood\"");
+  CHECK(num_flood > 4000);
+  CHECK(num_flood < 20000);
+  CHECK(strstr(json, "\"args\":{\"arg\":20000}"));
+  CHECK(!strstr(json, "\"args\":{\"arg\":1}"));
+  free(json);
+}
+
+TEST_CASE("recording can be disabled") {
+  SetSpanTracing(false);
+  PDP_TRACE_INSTANT("disabled");
+  SetSpanTracing(true);
+  char *json = ExportToString();
+  CHECK(!strstr(json, "\"disabled\""));
+  free(json);
+}
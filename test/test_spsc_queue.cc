@@ -0,0 +1,111 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "data/spsc_queue.h"
+#include "strings/fixed_string.h"
+
+#include <thread>
+
+using pdp::SpscQueue;
+
+TEST_CASE("SpscQueue push and pop in order") {
+  SpscQueue<int> q(4);
+
+  CHECK(q.Empty());
+  CHECK(q.Front() == nullptr);
+
+  CHECK(q.TryEmplaceBack(1));
+  CHECK(q.TryEmplaceBack(2));
+  CHECK(q.TryEmplaceBack(3));
+
+  REQUIRE(q.Front());
+  CHECK(*q.Front() == 1);
+  q.PopFront();
+  CHECK(*q.Front() == 2);
+  q.PopFront();
+  CHECK(*q.Front() == 3);
+  q.PopFront();
+  CHECK(q.Empty());
+}
+
+TEST_CASE("SpscQueue reports full queue") {
+  SpscQueue<int> q(2);
+
+  CHECK(q.TryEmplaceBack(1));
+  CHECK(q.TryEmplaceBack(2));
+  CHECK_FALSE(q.TryEmplaceBack(3));
+
+  q.PopFront();
+  CHECK(q.TryEmplaceBack(3));
+  CHECK(*q.Front() == 2);
+  q.PopFront();
+  CHECK(*q.Front() == 3);
+}
+
+TEST_CASE("SpscQueue destroys remaining elements") {
+  SpscQueue<pdp::FixedString> q(4);
+  CHECK(q.TryEmplaceBack(pdp::StringSlice("a string which does not fit in place")));
+  CHECK(q.TryEmplaceBack(pdp::StringSlice("another one")));
+  q.PopFront();
+}
+
+TEST_CASE("SpscQueue transfers elements between threads") {
+  constexpr int count = 100'000;
+  SpscQueue<int> q(64);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < count; ++i) {
+      while (!q.TryEmplaceBack(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  bool in_order = true;
+  while (expected < count) {
+    int *front = q.Front();
+    if (!front) {
+      std::this_thread::yield();
+      continue;
+    }
+    in_order &= (*front == expected);
+    q.PopFront();
+    ++expected;
+  }
+  producer.join();
+
+  CHECK(in_order);
+  CHECK(q.Empty());
+}
+
+TEST_CASE("SpscQueue batch push and pop") {
+  SpscQueue<int> q(8);
+
+  int input[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  CHECK(q.TryPushBatch(input, 5) == 5);
+  CHECK(q.TryPushBatch(input + 5, 5) == 3);
+
+  int output[8];
+  CHECK(q.PopBatch(output, 6) == 6);
+  for (int i = 0; i < 6; ++i) {
+    CHECK(output[i] == i);
+  }
+  CHECK(q.PopBatch(output, 8) == 2);
+  CHECK(output[0] == 6);
+  CHECK(output[1] == 7);
+  CHECK(q.PopBatch(output, 8) == 0);
+}
+
+TEST_CASE("SpscQueue batches wrap around") {
+  SpscQueue<int> q(4);
+
+  int input[3] = {1, 2, 3};
+  int output[4];
+  for (int round = 0; round < 10; ++round) {
+    REQUIRE(q.TryPushBatch(input, 3) == 3);
+    REQUIRE(q.PopBatch(output, 4) == 3);
+    CHECK(output[0] == 1);
+    CHECK(output[2] == 3);
+  }
+}
@@ -0,0 +1,101 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "external/emhash8.h"
+#include "strings/string_hash.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace pdp;
+
+namespace {
+
+using HashFn = uint32_t (*)(const void *, size_t);
+
+struct Variant {
+  const char *name;
+  HashFn fn;
+  bool supported;
+};
+
+const Variant variants[] = {
+    {"portable", HashBytesPortable, true},
+    {"crc32c", HashBytesCrc32c, CheckCpuCrc32c()},
+    {"aes", HashBytesAes, CheckCpuAes()},
+    {"dispatched", HashBytes, true},
+};
+
+}  // namespace
+
+TEST_CASE("String hashes depend on every byte and on the length") {
+  char buf[80];
+  for (const Variant &v : variants) {
+    if (!v.supported) {
+      continue;
+    }
+    for (size_t n = 0; n <= 64; ++n) {
+      memset(buf, 'a', sizeof(buf));
+      const uint32_t base = v.fn(buf, n);
+      CHECK(v.fn(buf, n) == base);
+      // Bytes past the end are not read.
+      buf[n] = 'z';
+      CHECK(v.fn(buf, n) == base);
+      CHECK(v.fn(buf, n + 1) != base);
+      buf[n] = 'a';
+      for (size_t i = 0; i < n; ++i) {
+        buf[i] = 'b';
+        CHECK(v.fn(buf, n) != base);
+        buf[i] = 'a';
+      }
+    }
+  }
+}
+
+TEST_CASE("String hashes spread similar keys across buckets") {
+  constexpr size_t num_keys = 1 << 14;
+  constexpr size_t num_buckets = 1 << 10;
+  static uint32_t buckets[num_buckets];
+  char buf[64];
+  for (const Variant &v : variants) {
+    if (!v.supported) {
+      continue;
+    }
+    memset(buckets, 0, sizeof(buckets));
+    for (size_t i = 0; i < num_keys; ++i) {
+      int len = snprintf(buf, sizeof(buf), "/home/user/src/file_%zu.cc", i);
+      ++buckets[v.fn(buf, len) & (num_buckets - 1)];
+    }
+    const double expected = double(num_keys) / num_buckets;
+    double chi2 = 0;
+    for (uint32_t count : buckets) {
+      chi2 += (count - expected) * (count - expected) / expected;
+    }
+    CHECK(chi2 / num_buckets < 1.5);
+  }
+}
+
+TEST_CASE("emhash8 maps accept a custom hasher") {
+  emhash8::StringMap<int, Crc32cStringHash> crc_map;
+  emhash8::ArenaStringMap<int, StringHash> arena_map;
+  emhash8::StringMap<int, PortableStringHash> portable_map;
+  char buf[32];
+  for (int i = 0; i < 1000; ++i) {
+    int len = snprintf(buf, sizeof(buf), "key%d", i);
+    if (CheckCpuCrc32c()) {
+      crc_map.Emplace(StringSlice(buf, len), i);
+    }
+    arena_map.Emplace(StringSlice(buf, len), i);
+    portable_map.Emplace(StringSlice(buf, len), i);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    int len = snprintf(buf, sizeof(buf), "key%d", i);
+    if (CheckCpuCrc32c()) {
+      auto it = crc_map.Find(StringSlice(buf, len));
+      REQUIRE(it != crc_map.End());
+      CHECK(it->value == i);
+    }
+    CHECK(arena_map.Find(StringSlice(buf, len))->value == i);
+    CHECK(portable_map.Find(StringSlice(buf, len))->value == i);
+  }
+}
@@ -0,0 +1,137 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "coroutines/run_on_pool.h"
+#include "system/thread_pool.h"
+
+#include <pthread.h>
+#include <sys/poll.h>
+#include <atomic>
+
+using namespace pdp;
+
+namespace {
+
+void WaitForCompletions(ThreadPool &pool) {
+  while (pool.NumPending() > 0) {
+    struct pollfd poll_args;
+    poll_args.fd = pool.GetDescriptor();
+    poll_args.events = POLLIN;
+    poll_args.revents = 0;
+    REQUIRE(poll(&poll_args, 1, 1000) == 1);
+    pool.DrainCompletions();
+  }
+}
+
+struct SquareTask : public PoolTask {
+  SquareTask() : PoolTask(Run, Complete), input(0), output(0), completed_on(0) {}
+
+  static void Run(PoolTask *task) {
+    auto *self = static_cast<SquareTask *>(task);
+    self->output = self->input * self->input;
+  }
+
+  static void Complete(PoolTask *task) {
+    static_cast<SquareTask *>(task)->completed_on = pthread_self();
+  }
+
+  int64_t input;
+  int64_t output;
+  pthread_t completed_on;
+};
+
+struct FanOutTask : public PoolTask {
+  FanOutTask(ThreadPool &p, std::atomic_int &c)
+      : PoolTask(Run, Complete), pool(p), counter(c), children(nullptr) {}
+
+  static void Run(PoolTask *task) {
+    auto *self = static_cast<FanOutTask *>(task);
+    for (int i = 0; i < 16; ++i) {
+      self->pool.Submit(&self->children[i]);
+    }
+    self->counter++;
+  }
+
+  static void Complete(PoolTask *) {}
+
+  ThreadPool &pool;
+  std::atomic_int &counter;
+  SquareTask *children;
+};
+
+Coroutine SumOnPool(ThreadPool &pool, int64_t *result) {
+  int64_t a = co_await RunOnPool(pool, []() { return int64_t(40); });
+  int64_t b = co_await RunOnPool(pool, [a]() { return a + 2; });
+  co_await RunOnPool(pool, []() {});
+  *result = b;
+}
+
+}  // namespace
+
+TEST_CASE("ThreadPool: tasks run and complete on the main thread") {
+  ThreadPool pool(4);
+  REQUIRE_FALSE(pool.IsInline());
+
+  constexpr int count = 1000;
+  static SquareTask tasks[count];
+  for (int i = 0; i < count; ++i) {
+    tasks[i].input = i;
+    pool.Submit(&tasks[i]);
+  }
+  WaitForCompletions(pool);
+
+  for (int i = 0; i < count; ++i) {
+    CHECK(tasks[i].output == int64_t(i) * i);
+    CHECK(pthread_equal(tasks[i].completed_on, pthread_self()));
+  }
+}
+
+TEST_CASE("ThreadPool: tasks can submit tasks") {
+  ThreadPool pool(3);
+  std::atomic_int counter(0);
+
+  constexpr int count = 8;
+  static SquareTask children[count][16];
+  FanOutTask *parents[count];
+  for (int i = 0; i < count; ++i) {
+    parents[i] = new FanOutTask(pool, counter);
+    parents[i]->children = children[i];
+    for (int j = 0; j < 16; ++j) {
+      children[i][j].input = i + j;
+    }
+    pool.Submit(parents[i]);
+  }
+  WaitForCompletions(pool);
+
+  CHECK(counter == count);
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      CHECK(children[i][j].output == int64_t(i + j) * (i + j));
+    }
+    delete parents[i];
+  }
+}
+
+TEST_CASE("ThreadPool: no workers runs inline") {
+  ThreadPool pool(0);
+  CHECK(pool.IsInline());
+
+  SquareTask task;
+  task.input = 7;
+  pool.Submit(&task);
+  CHECK(task.output == 49);
+  CHECK(pool.NumPending() == 0);
+}
+
+TEST_CASE("ThreadPool: RunOnPool resumes the coroutine with the result") {
+  ThreadPool pool(2);
+  int64_t result = 0;
+  SumOnPool(pool, &result);
+  WaitForCompletions(pool);
+  CHECK(result == 42);
+
+  ThreadPool inline_pool(0);
+  result = 0;
+  SumOnPool(inline_pool, &result);
+  CHECK(result == 42);
+}
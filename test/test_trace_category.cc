@@ -0,0 +1,56 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/log.h"
+
+using namespace pdp;
+
+static int evaluations = 0;
+
+static int Evaluate() { return ++evaluations; }
+
+TEST_CASE("categories are switched by name") {
+  CHECK(SetTraceCategories("none"));
+  CHECK(!IsTraceEnabled(TraceCategory::kMessages));
+  CHECK(!IsTraceEnabled(TraceCategory::kRpcTokens));
+
+  CHECK(SetTraceCategories("messages,rolling-buffer"));
+  CHECK(IsTraceEnabled(TraceCategory::kMessages));
+  CHECK(!IsTraceEnabled(TraceCategory::kRpcTokens));
+  CHECK(IsTraceEnabled(TraceCategory::kRollingBuffer));
+
+  CHECK(SetTraceCategories("-messages,rpc-tokens"));
+  CHECK(!IsTraceEnabled(TraceCategory::kMessages));
+  CHECK(IsTraceEnabled(TraceCategory::kRpcTokens));
+  CHECK(IsTraceEnabled(TraceCategory::kRollingBuffer));
+
+  CHECK(SetTraceCategories("all,-rpc-tokens"));
+  CHECK(IsTraceEnabled(TraceCategory::kMessages));
+  CHECK(!IsTraceEnabled(TraceCategory::kRpcTokens));
+
+  SetTraceEnabled(TraceCategory::kRpcTokens, true);
+  CHECK(IsTraceEnabled(TraceCategory::kRpcTokens));
+  SetTraceEnabled(TraceCategory::kRpcTokens, false);
+  CHECK(!IsTraceEnabled(TraceCategory::kRpcTokens));
+}
+
+TEST_CASE("unknown names are reported and skipped") {
+  CHECK(SetTraceCategories("none"));
+  CHECK(!SetTraceCategories("bogus,messages,,"));
+  CHECK(IsTraceEnabled(TraceCategory::kMessages));
+  CHECK(SetTraceCategories(""));
+  CHECK(IsTraceEnabled(TraceCategory::kMessages));
+}
+
+TEST_CASE("disabled sites do not evaluate their arguments") {
+  evaluations = 0;
+  SetTraceCategories("none");
+  pdp_trace("value {}", Evaluate());
+  pdp_trace_in(kRpcTokens, "value {}", Evaluate());
+  CHECK(evaluations == 0);
+
+  SetTraceCategories("rpc-tokens");
+  pdp_trace("value {}", Evaluate());
+  pdp_trace_in(kRpcTokens, "value {}", Evaluate());
+  CHECK(evaluations == 1);
+}
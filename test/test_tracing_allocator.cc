@@ -0,0 +1,111 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "data/tracing_allocator.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+
+using pdp::TracingAllocator;
+
+namespace {
+
+const pdp::impl::_AllocationSite *FindSite(int line) {
+  for (const auto &site : pdp::impl::g_allocation_registry.sites) {
+    if (site.is_ready.load() && site.line == line && strstr(site.file, "test_tracing_allocator")) {
+      return &site;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST_CASE("TracingAllocator: counts allocations per construction site") {
+  // clang-format off
+  TracingAllocator first; const int first_line = __LINE__;
+  TracingAllocator second; const int second_line = __LINE__;
+  // clang-format on
+
+  void *a = first.AllocateRaw(10);
+  void *b = first.AllocateRaw(100);
+  void *c = second.AllocateRaw(5000);
+  CHECK(first.GetAllocationSize(a) >= 10);
+  CHECK(second.GetAllocationSize(c) >= 5000);
+
+  const auto *first_site = FindSite(first_line);
+  const auto *second_site = FindSite(second_line);
+  REQUIRE(first_site);
+  REQUIRE(second_site);
+  CHECK(first_site != second_site);
+
+  CHECK(first_site->allocations == 2);
+  CHECK(first_site->size_classes[0] == 1);
+  CHECK(first_site->size_classes[3] == 1);
+  CHECK(second_site->allocations == 1);
+  CHECK(second_site->size_classes[9] == 1);
+
+  const int64_t live = first_site->live_bytes;
+  CHECK(live >= 110);
+  first.DeallocateRaw(a);
+  CHECK(first_site->live_bytes < live);
+  CHECK(first_site->peak_bytes == live);
+  CHECK(first_site->deallocations == 1);
+
+  // Memory is attributed to the site that allocated it.
+  second.DeallocateRaw(b);
+  CHECK(first_site->deallocations == 2);
+  CHECK(first_site->live_bytes == 0);
+  second.DeallocateRaw(c);
+  CHECK(second_site->live_bytes == 0);
+}
+
+TEST_CASE("TracingAllocator: reallocation keeps the contents and the site") {
+  TracingAllocator allocator;
+  const int line = __LINE__ - 1;
+
+  char *ptr = static_cast<char *>(allocator.AllocateRaw(8));
+  memcpy(ptr, "pdp", 4);
+  ptr = static_cast<char *>(allocator.ReallocateRaw(ptr, 64 * 1024));
+  CHECK(strcmp(ptr, "pdp") == 0);
+  CHECK(allocator.GetAllocationSize(ptr) >= 64 * 1024);
+
+  const auto *site = FindSite(line);
+  REQUIRE(site);
+  CHECK(site->allocations == 1);
+  CHECK(site->reallocations == 1);
+  CHECK(site->live_bytes >= 64 * 1024);
+  allocator.DeallocateRaw(ptr);
+  CHECK(site->live_bytes == 0);
+}
+
+TEST_CASE("TracingAllocator: report is sorted by bytes allocated") {
+  // clang-format off
+  TracingAllocator small; const int small_line = __LINE__;
+  TracingAllocator big; const int big_line = __LINE__;
+  // clang-format on
+  small.DeallocateRaw(small.AllocateRaw(1));
+  big.DeallocateRaw(big.AllocateRaw(1024 * 1024));
+
+  int fd = memfd_create("report", 0);
+  REQUIRE(fd >= 0);
+  pdp::PrintAllocationReport(fd);
+
+  char report[64 * 1024];
+  ssize_t length = pread(fd, report, sizeof(report) - 1, 0);
+  REQUIRE(length > 0);
+  report[length] = '\0';
+  close(fd);
+
+  char small_site[64];
+  char big_site[64];
+  snprintf(small_site, sizeof(small_site), "test_tracing_allocator.cc:%d\n", small_line);
+  snprintf(big_site, sizeof(big_site), "test_tracing_allocator.cc:%d\n", big_line);
+  const char *small_pos = strstr(report, small_site);
+  const char *big_pos = strstr(report, big_site);
+  REQUIRE(small_pos);
+  REQUIRE(big_pos);
+  CHECK(big_pos < small_pos);
+  CHECK(strstr(report, "Allocation report"));
+}
@@ -0,0 +1,96 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "system/thread.h"
+#include "tracing/tracing_counter.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+
+using namespace pdp;
+
+static bool ReportContains(const char *line) {
+  StringBuilder<> report;
+  AppendTracingCounters(report);
+  return report.ToSlice().MemMem(line) != nullptr;
+}
+
+TEST_CASE("registering the same name twice returns the same id") {
+  const uint32_t first = RegisterTracingCounter("Dedup", "hits");
+  const uint32_t second = RegisterTracingCounter("Dedup", "misses");
+  CHECK(first != second);
+  // The strings need not be the same pointers.
+  char group[] = "Dedup";
+  char name[] = "hits";
+  CHECK(RegisterTracingCounter(group, name) == first);
+  CHECK(RegisterTracingCounter("Other", "hits") != first);
+}
+
+TEST_CASE("report lists counters with their group total") {
+  static constexpr const char *names[] = {"first", "second"};
+  TracingCounter<2> counter("Report", names);
+  TracingCounter<2> same_counter("Report", names);
+  counter.Count(0);
+  counter.Count(1);
+  same_counter.Count(1);
+  same_counter.Count(1);
+  CHECK(ReportContains("Report/first: 1/4\n"));
+  CHECK(ReportContains("Report/second: 3/4\n"));
+}
+
+TEST_CASE("threads count into their own shards") {
+  static constexpr const char *names[] = {"even", "odd"};
+  struct Worker {
+    void operator()() {
+      TracingCounter<2> counter("Threads", names);
+      for (int i = 0; i < 100'000; ++i) {
+        counter.Count(i % 2);
+      }
+    }
+  };
+  Thread threads[4];
+  for (auto &thread : threads) {
+    thread.Start(Worker{});
+  }
+  for (auto &thread : threads) {
+    thread.Wait();
+  }
+  // Exited threads keep their counts.
+  CHECK(ReportContains("Threads/even: 200000/400000\n"));
+  CHECK(ReportContains("Threads/odd: 200000/400000\n"));
+}
+
+TEST_CASE("snapshots are written only when requested") {
+  const uint32_t id = RegisterTracingCounter("Snapshot", "writes");
+  IncrementTracingCounter(id, 5);
+
+  char path[] = "/tmp/pdp_test_tracing_counter_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+  unlink(path);
+
+  CheckTracingCountersRequest(path);
+  CHECK(access(path, F_OK) != 0);
+
+  RequestTracingCounters();
+  CheckTracingCountersRequest(path);
+  fd = open(path, O_RDONLY);
+  REQUIRE(fd >= 0);
+  unlink(path);
+  struct stat st;
+  REQUIRE(fstat(fd, &st) == 0);
+  char *text = static_cast<char *>(malloc(st.st_size + 1));
+  REQUIRE(read(fd, text, st.st_size) == st.st_size);
+  text[st.st_size] = '\0';
+  close(fd);
+  CHECK(strstr(text, "Snapshot/writes: 5/5\n"));
+  free(text);
+
+  // The request is consumed.
+  CheckTracingCountersRequest(path);
+  CHECK(access(path, F_OK) != 0);
+}
@@ -230,14 +230,40 @@ struct pdp::CanReallocate<TestPair> : std::true_type {};
 TEST_CASE("Emplace constructs simple struct and appends it") {
   Vector<TestPair> v(2);
 
-  pdp::FixedString s("Test string", 11);
+  pdp::FixedString s("Test string which is not inline", 31);
   const void *old_ptr = s.Begin();
   v.Emplace(std::move(s), 2);
 
   CHECK(v.Size() == 1);
-  CHECK(v[0].first == "Test string");
+  CHECK(v[0].first == "Test string which is not inline");
   CHECK(v[0].second == 2);
 
   CHECK(old_ptr == v[0].first.Cstr());
-  CHECK(s.Begin() == nullptr);
+  CHECK(s.Empty());
+}
+
+TEST_CASE("EmplaceAt inserts in the middle and Erase closes the gap") {
+  Vector<TestPair> v(2);
+  v.Emplace(pdp::FixedString("zero", 4), 0);
+  v.Emplace(pdp::FixedString("three", 5), 3);
+  v.EmplaceAt(1, pdp::FixedString("one", 3), 1);
+  v.EmplaceAt(2, pdp::FixedString("a string long enough to live on the heap", 40), 2);
+  v.EmplaceAt(4, pdp::FixedString("four", 4), 4);
+
+  REQUIRE(v.Size() == 5);
+  for (int i = 0; i < 5; ++i) {
+    CHECK(v[i].second == i);
+  }
+  CHECK(v[2].first == "a string long enough to live on the heap");
+
+  v.Erase(1, 3);
+  REQUIRE(v.Size() == 3);
+  CHECK(v[0].first == "zero");
+  CHECK(v[1].first == "three");
+  CHECK(v[2].first == "four");
+
+  v.Erase(2, 2);
+  CHECK(v.Size() == 3);
+  v.Erase(0, 3);
+  CHECK(v.Empty());
 }
@@ -0,0 +1,61 @@
+#include "branch_profile.h"
+#include "core/log.h"
+#include "data/vector.h"
+
+namespace pdp {
+
+/// @brief Every site hit at least once, newest first. Sites are statics and never unlinked.
+static std::atomic<BranchSite *> all_sites = nullptr;
+
+uint64_t BranchSite::Mispredicted() const {
+  return (expected ? not_taken : taken).load(std::memory_order_relaxed);
+}
+
+uint64_t BranchSite::Total() const {
+  return taken.load(std::memory_order_relaxed) + not_taken.load(std::memory_order_relaxed);
+}
+
+void BranchSite::Register() {
+  if (registered.exchange(true, std::memory_order_relaxed)) {
+    return;
+  }
+  next = all_sites.load(std::memory_order_relaxed);
+  while (!all_sites.compare_exchange_weak(next, this, std::memory_order_release)) {
+  }
+}
+
+void AppendBranchProfile(StringBuilder<> &out) {
+  Vector<const BranchSite *> sites;
+  for (const BranchSite *site = all_sites.load(std::memory_order_acquire); site;
+       site = site->next) {
+    // Insertion sort, there are only a handful of sites.
+    size_t pos = sites.Size();
+    while (pos > 0 && sites[pos - 1]->Mispredicted() < site->Mispredicted()) {
+      --pos;
+    }
+    sites.EmplaceAt(pos, site);
+  }
+  for (size_t i = 0; i < sites.Size(); ++i) {
+    const BranchSite *site = sites[i];
+    const uint64_t mispredicted = site->Mispredicted();
+    const uint64_t total = site->Total();
+    const uint64_t permille = total > 0 ? mispredicted * 1000 / total : 0;
+    out.AppendFormat("mispredicted {}/{} ({}.{}%) {}({}) {}:{}\n", mispredicted, total,
+                     permille / 10, permille % 10,
+                     StringSlice(site->expected ? "LIKELY" : "UNLIKELY"),
+                     StringSlice(site->condition), StringSlice(site->file), site->line);
+  }
+}
+
+void LogBranchProfile() {
+  StringBuilder<> report;
+  AppendBranchProfile(report);
+  if (report.Size() == 0) {
+    pdp_info("No branch hints hit");
+    return;
+  }
+  pdp_info("Branch hints, most mispredicted first:");
+  pdp_info_multiline(report.ToSlice());
+}
+
+}  // namespace pdp
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/internals.h"
+#include "strings/string_builder.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Counts of one PDP_TRACE_LIKELY or PDP_TRACE_UNLIKELY site. Constant initialized, so it
+/// can be a function local static without thread safe statics. Joins the registry on its first hit.
+struct BranchSite {
+  constexpr BranchSite(const char *file, unsigned line, const char *condition, bool expected)
+      : file(file),
+        condition(condition),
+        line(line),
+        expected(expected),
+        registered(false),
+        taken(0),
+        not_taken(0),
+        next(nullptr) {}
+
+  void Record(bool value) {
+    if (PDP_UNLIKELY(!registered.load(std::memory_order_relaxed))) {
+      Register();
+    }
+    (value ? taken : not_taken).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// @brief Hits which went against the hint.
+  uint64_t Mispredicted() const;
+  uint64_t Total() const;
+
+  const char *file;
+  const char *condition;
+  unsigned line;
+  /// @brief The hinted value of the condition, true for PDP_TRACE_LIKELY.
+  bool expected;
+
+  std::atomic_bool registered;
+  std::atomic_uint64_t taken;
+  std::atomic_uint64_t not_taken;
+  BranchSite *next;
+
+ private:
+  void Register();
+};
+
+/// @brief Appends a line per hit site, most mispredicted first:
+/// "mispredicted M/N (P%) LIKELY(cond) file:line".
+void AppendBranchProfile(StringBuilder<> &out);
+
+void LogBranchProfile();
+
+}  // namespace pdp
@@ -12,6 +12,7 @@
 #include <new>
 
 #include "core/check.h"
+#include "core/clock.h"
 #include "core/log.h"
 
 namespace pdp {
@@ -113,6 +114,22 @@ pid_t _Recorder::RecordSyscallFork(pid_t child_pid) {
   return child_pid;
 }
 
+pid_t _Recorder::RecordSyscallSpawn(pid_t child_pid, int error) {
+  if (PDP_UNLIKELY(child_pid > INT_MAX)) {
+    PDP_UNREACHABLE("Cannot record pid: overflow");
+  }
+
+  RecordEnum(RecordType::kSpawn, scratch_buffer);
+  RecordInteger(child_pid, scratch_buffer + 1);
+  if (child_pid > 0) {
+    WriteFully(recording_fd, scratch_buffer, 5);
+  } else {
+    RecordInteger(error, scratch_buffer + 5);
+    WriteFully(recording_fd, scratch_buffer, 9);
+  }
+  return child_pid;
+}
+
 pid_t _Recorder::RecordSyscallWaitPid(pid_t pid, int status) {
   if (PDP_UNLIKELY(pid > INT_MAX || pid < INT_MIN)) {
     PDP_UNREACHABLE("Cannot record pid: overflow");
@@ -248,6 +265,25 @@ pid_t _Replayer::ReplaySyscallFork() {
   return child_pid;
 }
 
+pid_t _Replayer::ReplaySyscallSpawn() {
+  CheckForEnd();
+
+  const bool match = IsRecordType(RecordType::kSpawn, ptr);
+  if (PDP_UNLIKELY(!match)) {
+    PDP_FMT_UNREACHABLE("Corrupted recording detected (byte {}), spawn failed", MakeHex(*ptr));
+  }
+
+  pdp_assert(limit - ptr >= 5);
+  pid_t child_pid = static_cast<pid_t>(ReplayInteger(ptr + 1));
+  ptr += 5;
+  if (child_pid <= 0) {
+    pdp_assert(limit - ptr >= 4);
+    errno = ReplayInteger(ptr);
+    ptr += 4;
+  }
+  return child_pid;
+}
+
 pid_t _Replayer::ReplaySyscallWaitPid(int *status) {
   CheckForEnd();
 
@@ -434,6 +470,26 @@ pid_t ExecutionTracer::SyscallFork() {
   pdp_assert(false);
 }
 
+pid_t ExecutionTracer::SyscallSpawn(pid_t (*spawn)(void *), void *user_data) {
+  pid_t child_pid = 0;
+  int error = 0;
+  switch (mode) {
+    case ExecMode::kNormal:
+      return spawn(user_data);
+
+    case ExecMode::kRecord:
+      child_pid = spawn(user_data);
+      error = errno;
+      AsRecorder()->RecordSyscallSpawn(child_pid, error);
+      errno = error;
+      return child_pid;
+
+    case ExecMode::kReplay:
+      return AsReplay()->ReplaySyscallSpawn();
+  }
+  PDP_UNREACHABLE("Invalid execution mode");
+}
+
 pid_t ExecutionTracer::SyscallWaitPid(int *status, int options) {
   pid_t child_pid = 0;
   switch (mode) {
@@ -450,14 +506,30 @@ pid_t ExecutionTracer::SyscallWaitPid(int *status, int options) {
   pdp_assert(false);
 }
 
+/// @brief poll(2) is never restarted after a signal handler, not even with SA_RESTART. Retries with
+/// what is left of @p timeout, so that recordings never contain EINTR.
+static int PollRestarting(struct pollfd *poll_args, nfds_t n, int timeout) {
+  const uint64_t deadline_ns = MonotonicNs() + static_cast<uint64_t>(timeout) * 1'000'000;
+  for (;;) {
+    int ret = poll(poll_args, n, timeout);
+    if (PDP_LIKELY(ret >= 0 || errno != EINTR)) {
+      return ret;
+    }
+    if (timeout > 0) {
+      const uint64_t now_ns = MonotonicNs();
+      timeout = now_ns < deadline_ns ? static_cast<int>((deadline_ns - now_ns) / 1'000'000) : 0;
+    }
+  }
+}
+
 int ExecutionTracer::SyscallPoll(struct pollfd *poll_args, nfds_t n, int timeout) {
   int ret = 0;
   switch (mode) {
     case ExecMode::kNormal:
-      return poll(poll_args, n, timeout);
+      return PollRestarting(poll_args, n, timeout);
 
     case ExecMode::kRecord:
-      ret = poll(poll_args, n, timeout);
+      ret = PollRestarting(poll_args, n, timeout);
       AsRecorder()->RecordSyscallPoll(poll_args, n, ret);
       return ret;
 
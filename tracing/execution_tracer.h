@@ -11,7 +11,16 @@ namespace pdp {
 
 // TODO #ifdef PDP_DEBUG_BUILD
 
-enum class RecordType { kRead, kFork, kWaitPid, kPoll, kTimeLess, kTimeNotLess, kTotal };
+enum class RecordType {
+  kRead,
+  kFork,
+  kWaitPid,
+  kPoll,
+  kTimeLess,
+  kTimeNotLess,
+  kSpawn,
+  kTotal
+};
 
 namespace impl {
 
@@ -24,6 +33,7 @@ struct _Recorder {
   int RecordSyscallPoll(struct pollfd *poll_args, nfds_t n, int ret);
 
   pid_t RecordSyscallFork(pid_t child_pid);
+  pid_t RecordSyscallSpawn(pid_t child_pid, int error);
   pid_t RecordSyscallWaitPid(pid_t pid, int status);
 
   bool RecordIsTimeLess(bool check_passed);
@@ -54,6 +64,7 @@ struct _Replayer {
   int ReplaySyscallPoll(struct pollfd *poll_args, nfds_t n);
 
   pid_t ReplaySyscallFork();
+  pid_t ReplaySyscallSpawn();
   pid_t ReplaySyscallWaitPid(int *status);
 
   bool ReplayIsTimeLess();
@@ -106,6 +117,12 @@ struct ExecutionTracer {
   pid_t SyscallWaitPid(int *status, int options);
   pid_t SyscallFork();
 
+  /// @brief Runs a callback which starts a child process and records the resulting pid.
+  /// The callback is not invoked when replaying, the recorded pid (or error) is returned instead.
+  /// @param spawn Creates the child process. Returns the pid or -1 with `errno` set.
+  /// @param user_data Opaque pointer passed to the callback.
+  pid_t SyscallSpawn(pid_t (*spawn)(void *), void *user_data);
+
  private:
   impl::_Recorder *AsRecorder();
   impl::_Replayer *AsReplay();
@@ -0,0 +1,87 @@
+#include "latency_histogram.h"
+#include "core/internals.h"
+
+#include <cstring>
+
+namespace pdp {
+
+LatencyHistogram::LatencyHistogram() { Reset(); }
+
+unsigned LatencyHistogram::BucketIndex(uint64_t ns) {
+  if (ns < sub_bucket_count) {
+    return ns;
+  }
+  const unsigned exponent = 63 - PDP_CLZLL(ns);
+  if (PDP_UNLIKELY(exponent >= max_value_bits)) {
+    return num_buckets - 1;
+  }
+  // The bits after the leading one select the sub bucket.
+  const unsigned shift = exponent - sub_bucket_bits;
+  const unsigned sub_bucket = (ns >> shift) & (sub_bucket_count - 1);
+  return (shift + 1) * sub_bucket_count + sub_bucket;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(unsigned index) {
+  if (index < sub_bucket_count) {
+    return index;
+  }
+  const unsigned shift = index / sub_bucket_count - 1;
+  const uint64_t sub_bucket = index % sub_bucket_count;
+  const uint64_t lower = (uint64_t(1) << (shift + sub_bucket_bits)) | (sub_bucket << shift);
+  return lower + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t ns) {
+  counts[BucketIndex(ns)] += 1;
+  total += 1;
+  max = ns > max ? ns : max;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+  for (unsigned i = 0; i < num_buckets; ++i) {
+    counts[i] += other.counts[i];
+  }
+  total += other.total;
+  max = other.max > max ? other.max : max;
+}
+
+void LatencyHistogram::Reset() {
+  memset(counts, 0, sizeof(counts));
+  total = 0;
+  max = 0;
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+  rank = rank < 1 ? 1 : rank;
+  uint64_t seen = 0;
+  for (unsigned i = 0; i < num_buckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      const uint64_t bound = BucketUpperBound(i);
+      return bound < max ? bound : max;
+    }
+  }
+  return max;
+}
+
+static void AppendMicros(uint64_t ns, StringBuilder<> &out) {
+  out.AppendFormat(" {}.{}us", ns / 1000, ns % 1000 / 100);
+}
+
+void LatencyHistogram::AppendSummary(StringBuilder<> &out) const {
+  out.AppendFormat("count {}", total);
+  out.Append(" p50");
+  AppendMicros(Percentile(50), out);
+  out.Append(" p90");
+  AppendMicros(Percentile(90), out);
+  out.Append(" p99");
+  AppendMicros(Percentile(99), out);
+  out.Append(" max");
+  AppendMicros(max, out);
+}
+
+}  // namespace pdp
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "strings/string_builder.h"
+
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Log-bucketed histogram of latencies in nanoseconds, in the style of HdrHistogram.
+///
+/// Values below 2^sub_bucket_bits are counted exactly. Larger values share a bucket with values
+/// within 1/2^sub_bucket_bits of them, so percentiles are accurate to about 3%. Values from about
+/// 18 minutes on share the last bucket, the maximum is kept exactly. The memory is fixed and
+/// histograms merge by adding their counts.
+class LatencyHistogram {
+ public:
+  static constexpr unsigned sub_bucket_bits = 5;
+  static constexpr unsigned sub_bucket_count = 1u << sub_bucket_bits;
+  static constexpr unsigned max_value_bits = 40;
+  static constexpr unsigned num_buckets =
+      (max_value_bits - sub_bucket_bits + 1) * sub_bucket_count;
+
+  LatencyHistogram();
+
+  void Record(uint64_t ns);
+  void Merge(const LatencyHistogram &other);
+  void Reset();
+
+  uint64_t Count() const { return total; }
+  uint64_t Max() const { return max; }
+
+  /// @brief Smallest value that @p percentile percent of the recorded values do not exceed, up to
+  /// the precision of the buckets. Zero for an empty histogram.
+  uint64_t Percentile(double percentile) const;
+
+  /// @brief Appends "count p50 p90 p99 max", the durations in microseconds.
+  void AppendSummary(StringBuilder<> &out) const;
+
+  static unsigned BucketIndex(uint64_t ns);
+  static uint64_t BucketUpperBound(unsigned index);
+
+ private:
+  uint32_t counts[num_buckets];
+  uint64_t total;
+  uint64_t max;
+};
+
+}  // namespace pdp
@@ -0,0 +1,169 @@
+#include "span_tracer.h"
+#include "core/clock.h"
+#include "core/log.h"
+#include "data/allocator.h"
+#include "data/vector.h"
+#include "strings/string_builder.h"
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+
+namespace pdp {
+
+namespace {
+
+struct TraceEvent {
+  uint64_t tsc;
+  const char *name;
+  uint64_t arg;
+  TracePhase phase;
+  uint32_t unused;
+};
+
+static_assert(sizeof(TraceEvent) == 32);
+
+/// @brief Recent events of one thread. Written only by its thread, rings are never freed.
+struct TraceRing {
+  static constexpr size_t capacity = 8192;
+  static_assert((capacity & (capacity - 1)) == 0);
+
+  /// Number of events recorded so far, the ring holds the last `capacity` of them.
+  std::atomic_uint64_t head;
+  int tid;
+  TraceRing *next;
+  TraceEvent events[capacity];
+};
+
+std::atomic_bool tracing_enabled = true;
+std::atomic_bool export_requested = false;
+/// @brief Every ring ever created, newest first.
+std::atomic<TraceRing *> all_rings = nullptr;
+thread_local TraceRing *thread_ring = nullptr;
+
+TraceRing *CreateRing() {
+  MallocAllocator allocator;
+  TraceRing *ring = new (Allocate<TraceRing>(allocator, 1)) TraceRing;
+  ring->head.store(0, std::memory_order_relaxed);
+  ring->tid = syscall(SYS_gettid);
+  ring->next = all_rings.load(std::memory_order_relaxed);
+  while (!all_rings.compare_exchange_weak(ring->next, ring, std::memory_order_release)) {
+  }
+  return ring;
+}
+
+/// @brief Copies the events of @p ring which were not overwritten while copying.
+void SnapshotRing(const TraceRing *ring, Vector<TraceEvent> &out) {
+  const uint64_t end = ring->head.load(std::memory_order_acquire);
+  const uint64_t begin = end > TraceRing::capacity ? end - TraceRing::capacity : 0;
+  const size_t old_size = out.Size();
+  for (uint64_t i = begin; i < end; ++i) {
+    out += ring->events[i & (TraceRing::capacity - 1)];
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // Events recorded meanwhile overwrote the oldest ones, and the slot after the last recorded
+  // event may be half written.
+  const uint64_t new_end = ring->head.load(std::memory_order_relaxed);
+  const uint64_t first_valid =
+      new_end + 1 > TraceRing::capacity ? new_end + 1 - TraceRing::capacity : 0;
+  if (PDP_UNLIKELY(first_valid > begin)) {
+    const size_t drop = first_valid - begin < end - begin ? first_valid - begin : end - begin;
+    for (size_t i = old_size; i + drop < out.Size(); ++i) {
+      out[i] = out[i + drop];
+    }
+    out.Downsize(drop);
+  }
+}
+
+/// @brief Appends a microsecond timestamp with nanosecond decimals.
+void AppendMicros(uint64_t ns, StringBuilder<> &out) {
+  out.AppendFormat("{}.", ns / 1000);
+  const unsigned frac = ns % 1000;
+  out.Append(static_cast<char>('0' + frac / 100));
+  out.Append(static_cast<char>('0' + frac / 10 % 10));
+  out.Append(static_cast<char>('0' + frac % 10));
+}
+
+void AppendEvent(const TraceEvent &e, int pid, int tid, StringBuilder<> &out) {
+  out.AppendFormat("{\"name\":\"{}\",\"ph\":\"{}\",\"ts\":", StringSlice(e.name),
+                   static_cast<char>(e.phase));
+  AppendMicros(TscToMonotonicNs(e.tsc), out);
+  out.AppendFormat(",\"pid\":{},\"tid\":{}", pid, tid);
+  switch (e.phase) {
+    case TracePhase::kInstant:
+      out.Append(",\"s\":\"t\"");
+      break;
+    case TracePhase::kAsyncBegin:
+    case TracePhase::kAsyncEnd:
+      out.AppendFormat(",\"cat\":\"async\",\"id\":\"{}\"", MakeHex(e.arg));
+      break;
+    default:
+      break;
+  }
+  if (e.arg != 0 && e.phase != TracePhase::kAsyncBegin && e.phase != TracePhase::kAsyncEnd) {
+    out.AppendFormat(",\"args\":{\"arg\":{}}", e.arg);
+  }
+  out.Append('}');
+}
+
+}  // namespace
+
+void RecordTraceEvent(TracePhase phase, const char *name, uint64_t arg) {
+  if (PDP_UNLIKELY(!tracing_enabled.load(std::memory_order_relaxed))) {
+    return;
+  }
+  TraceRing *ring = thread_ring;
+  if (PDP_UNLIKELY(!ring)) {
+    ring = thread_ring = CreateRing();
+  }
+  const uint64_t head = ring->head.load(std::memory_order_relaxed);
+  TraceEvent &e = ring->events[head & (TraceRing::capacity - 1)];
+  e.tsc = ReadTsc();
+  e.name = name;
+  e.arg = arg;
+  e.phase = phase;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void SetSpanTracing(bool enabled) { tracing_enabled.store(enabled, std::memory_order_relaxed); }
+
+bool ExportChromeTrace(const char *path) {
+  const int pid = getpid();
+  StringBuilder<> json;
+  json.Append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  bool first = true;
+  Vector<TraceEvent> events;
+  for (TraceRing *ring = all_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+    events.Clear();
+    SnapshotRing(ring, events);
+    for (size_t i = 0; i < events.Size(); ++i) {
+      json.Append(first ? "\n" : ",\n");
+      first = false;
+      AppendEvent(events[i], pid, ring->tid, json);
+    }
+  }
+  json.Append("\n]}\n");
+
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (PDP_UNLIKELY(fd < 0)) {
+    pdp_error("Failed to open {} for the trace!", StringSlice(path));
+    return false;
+  }
+  const bool okay = WriteFully(fd, json.Data(), json.Size());
+  close(fd);
+  pdp_info("Exported {} of trace to {}", MakeByteSize(json.Size()), StringSlice(path));
+  return okay;
+}
+
+void RequestTraceExport() { export_requested.store(true, std::memory_order_relaxed); }
+
+void CheckTraceExportRequest(const char *path) {
+  if (PDP_UNLIKELY(export_requested.load(std::memory_order_relaxed))) {
+    export_requested.store(false, std::memory_order_relaxed);
+    ExportChromeTrace(path);
+  }
+}
+
+}  // namespace pdp
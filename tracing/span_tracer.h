@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core/internals.h"
+
+#include <cstdint>
+
+namespace pdp {
+
+/// @brief Event phases, the same letters as in the Chrome trace format.
+enum class TracePhase : uint32_t {
+  kBegin = 'B',
+  kEnd = 'E',
+  kInstant = 'i',
+  kAsyncBegin = 'b',
+  kAsyncEnd = 'e',
+};
+
+/// @brief Appends an event to the ring of the calling thread.
+///
+/// Each thread owns a ring of the most recent events, stamped with ReadTsc(). Recording takes a
+/// few nanoseconds, so tracing stays enabled in release builds. @p name must be a string literal.
+/// @p arg is shown with the event, async events are matched by it.
+void RecordTraceEvent(TracePhase phase, const char *name, uint64_t arg = 0);
+
+/// @brief Enables or disables recording, enabled by default.
+void SetSpanTracing(bool enabled);
+
+/// @brief Writes the events in all rings to @p path in the Chrome trace JSON format, which
+/// chrome://tracing and ui.perfetto.dev open. Rings are read while threads keep recording, events
+/// overwritten in the meantime are skipped.
+bool ExportChromeTrace(const char *path);
+
+/// @brief Asks for an export at the next CheckTraceExportRequest(). Async signal safe.
+void RequestTraceExport();
+
+/// @brief Exports to @p path if RequestTraceExport() was called since the last check.
+void CheckTraceExportRequest(const char *path);
+
+/// @brief Records a span over its lifetime.
+struct ScopedSpan {
+  explicit ScopedSpan(const char *n, uint64_t arg = 0) : name(n) {
+    RecordTraceEvent(TracePhase::kBegin, name, arg);
+  }
+
+  ~ScopedSpan() { RecordTraceEvent(TracePhase::kEnd, name); }
+
+  ScopedSpan(const ScopedSpan &) = delete;
+  ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+ private:
+  const char *name;
+};
+
+}  // namespace pdp
+
+#define PDP_SPAN_CONCAT_IMPL(a, b) a##b
+#define PDP_SPAN_CONCAT(a, b) PDP_SPAN_CONCAT_IMPL(a, b)
+
+/// @brief Records a span until the end of the enclosing scope.
+#define PDP_TRACE_SPAN(name, ...) \
+  ::pdp::ScopedSpan PDP_SPAN_CONCAT(_pdp_span_, __LINE__)(name, ##__VA_ARGS__)
+
+#define PDP_TRACE_INSTANT(name, ...) \
+  ::pdp::RecordTraceEvent(::pdp::TracePhase::kInstant, name, ##__VA_ARGS__)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/clock.h"
+
 #include <cstdint>
 
 namespace pdp {
@@ -9,24 +11,21 @@ class HardwareStopwatch {
   /// @brief Starts the stopwatch
   ///
   /// Keep the implementation here so the call is inlined as a single instruction.
-  HardwareStopwatch() : start(ReadTSC()) {}
+  HardwareStopwatch() : start(ReadTscOrdered()) {}
 
   /// @brief Returns the elapsed clocks.
   ///
   /// Can be called multiple times.
   uint64_t LapClocks() {
     uint64_t old_start = start;
-    start = ReadTSC();
+    start = ReadTscOrdered();
     return start - old_start;
   }
 
- private:
-  static inline uint64_t ReadTSC() {
-    uint32_t lo, hi;
-    asm volatile("rdtscp" : "=a"(lo), "=d"(hi)::"rcx");
-    return (uint64_t(hi) << 32) | lo;
-  }
+  /// @brief Returns the elapsed nanoseconds, see LapClocks().
+  uint64_t LapNs() { return TscTicksToNs(LapClocks()); }
 
+ private:
   uint64_t start;
 };
 
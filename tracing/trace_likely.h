@@ -1,39 +1,19 @@
 #pragma once
 
 #include "core/internals.h"
-#include "core/log.h"
-
-#include <atomic>
 
 #ifdef PDP_TRACE_BRANCH
-#define PDP_TRACE_LIKELY(x)                                                        \
-  [](bool value, const pdp::StringSlice cond) -> bool {                            \
-    static std::atomic_uint total(0);                                              \
-    static std::atomic_uint taken(0);                                              \
-    total.fetch_add(1, std::memory_order_relaxed);                                 \
-    if (value) {                                                                   \
-      taken.fetch_add(1, std::memory_order_relaxed);                               \
-    } else {                                                                       \
-      auto now_total = total.load(std::memory_order_relaxed);                      \
-      auto now_mispred = now_total - taken.load(std::memory_order_relaxed);        \
-      pdp_trace("LIKELY '{}' misprediction: {}/{}", cond, now_mispred, now_total); \
-    }                                                                              \
-    return value;                                                                  \
-  }(x, #x)
-#define PDP_TRACE_UNLIKELY(x)                                                        \
-  [](bool value, const pdp::StringSlice &cond) -> bool {                             \
-    static std::atomic_uint total(0);                                                \
-    static std::atomic_uint not_taken(0);                                            \
-    total.fetch_add(1, std::memory_order_relaxed);                                   \
-    if (!value) {                                                                    \
-      not_taken.fetch_add(1, std::memory_order_relaxed);                             \
-    } else {                                                                         \
-      auto now_total = total.load(std::memory_order_relaxed);                        \
-      auto now_mispred = now_total - not_taken.load(std::memory_order_relaxed);      \
-      pdp_trace("UNLIKELY '{}' misprediction: {}/{}", cond, now_mispred, now_total); \
-    }                                                                                \
-    return value;                                                                    \
-  }(x, #x)
+#include "core/log.h"
+#include "tracing/branch_profile.h"
+
+#define PDP_TRACE_BRANCH_SITE(x, expected)                                                       \
+  [](bool value) -> bool {                                                                       \
+    static ::pdp::BranchSite _pdp_site(::pdp::GetBasename(__FILE__), __LINE__, #x, expected);    \
+    _pdp_site.Record(value);                                                                     \
+    return value;                                                                                \
+  }(x)
+#define PDP_TRACE_LIKELY(x) PDP_TRACE_BRANCH_SITE(x, true)
+#define PDP_TRACE_UNLIKELY(x) PDP_TRACE_BRANCH_SITE(x, false)
 #else
 #define PDP_TRACE_LIKELY(x) PDP_LIKELY(x)
 #define PDP_TRACE_UNLIKELY(x) PDP_UNLIKELY(x)
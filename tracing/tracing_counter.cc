@@ -0,0 +1,140 @@
+#include "tracing_counter.h"
+#include "core/log.h"
+#include "data/allocator.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+namespace pdp {
+
+namespace {
+
+constexpr uint32_t max_counters = 256;
+/// @brief Counts for counters registered past the maximum.
+constexpr uint32_t overflow_counter = max_counters - 1;
+
+struct CounterName {
+  const char *group;
+  const char *name;
+};
+
+/// @brief The counters of one thread. Written only by its thread, shards are never freed.
+struct alignas(64) CounterShard {
+  std::atomic_uint64_t values[max_counters];
+  CounterShard *next;
+};
+
+CounterName counter_names[max_counters];
+std::atomic_uint32_t num_counters = 0;
+std::atomic_flag registry_lock = ATOMIC_FLAG_INIT;
+
+std::atomic_bool snapshot_requested = false;
+/// @brief Every shard ever created, newest first.
+std::atomic<CounterShard *> all_shards = nullptr;
+thread_local CounterShard *thread_shard = nullptr;
+
+CounterShard *CreateShard() {
+  MallocAllocator allocator;
+  void *memory = allocator.AllocateRaw(sizeof(CounterShard) + alignof(CounterShard));
+  // Keep neighbouring allocations off the cache lines of the shard.
+  auto aligned = (reinterpret_cast<uintptr_t>(memory) + alignof(CounterShard) - 1) &
+                 ~(alignof(CounterShard) - 1);
+  CounterShard *shard = new (reinterpret_cast<void *>(aligned)) CounterShard;
+  for (auto &value : shard->values) {
+    value.store(0, std::memory_order_relaxed);
+  }
+  shard->next = all_shards.load(std::memory_order_relaxed);
+  while (!all_shards.compare_exchange_weak(shard->next, shard, std::memory_order_release)) {
+  }
+  return shard;
+}
+
+}  // namespace
+
+uint32_t RegisterTracingCounter(const char *group, const char *name) {
+  while (registry_lock.test_and_set(std::memory_order_acquire)) {
+    sched_yield();
+  }
+  const uint32_t size = num_counters.load(std::memory_order_relaxed);
+  uint32_t id = size;
+  for (uint32_t i = 0; i < size; ++i) {
+    if (strcmp(counter_names[i].group, group) == 0 && strcmp(counter_names[i].name, name) == 0) {
+      id = i;
+      break;
+    }
+  }
+  if (id == size) {
+    if (PDP_LIKELY(size < overflow_counter)) {
+      counter_names[id] = CounterName{group, name};
+      num_counters.store(size + 1, std::memory_order_release);
+    } else {
+      // Out of slots, the rest share the last one.
+      id = overflow_counter;
+      if (size == overflow_counter) {
+        counter_names[overflow_counter] = CounterName{"TracingCounter", "(overflow)"};
+        num_counters.store(max_counters, std::memory_order_release);
+      }
+    }
+  }
+  registry_lock.clear(std::memory_order_release);
+  return id;
+}
+
+void IncrementTracingCounter(uint32_t id, uint64_t delta) {
+  pdp_assert(id < max_counters);
+  CounterShard *shard = thread_shard;
+  if (PDP_UNLIKELY(!shard)) {
+    shard = thread_shard = CreateShard();
+  }
+  // Only this thread writes the shard, readers only need untorn values.
+  std::atomic_uint64_t &value = shard->values[id];
+  value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void AppendTracingCounters(StringBuilder<> &out) {
+  const uint32_t size = num_counters.load(std::memory_order_acquire);
+  uint64_t totals[max_counters] = {};
+  for (CounterShard *shard = all_shards.load(std::memory_order_acquire); shard;
+       shard = shard->next) {
+    for (uint32_t i = 0; i < size; ++i) {
+      totals[i] += shard->values[i].load(std::memory_order_relaxed);
+    }
+  }
+  for (uint32_t i = 0; i < size; ++i) {
+    const StringSlice group(counter_names[i].group);
+    uint64_t group_total = 0;
+    for (uint32_t j = 0; j < size; ++j) {
+      group_total += group == StringSlice(counter_names[j].group) ? totals[j] : 0;
+    }
+    out.AppendFormat("{}/{}: {}/{}\n", group, StringSlice(counter_names[i].name), totals[i],
+                     group_total);
+  }
+}
+
+bool WriteTracingCounters(const char *path) {
+  StringBuilder<> report;
+  AppendTracingCounters(report);
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (PDP_UNLIKELY(fd < 0)) {
+    pdp_error("Failed to open {} for the counters!", StringSlice(path));
+    return false;
+  }
+  const bool okay = report.Size() == 0 || WriteFully(fd, report.Data(), report.Size());
+  close(fd);
+  return okay;
+}
+
+void RequestTracingCounters() { snapshot_requested.store(true, std::memory_order_relaxed); }
+
+void CheckTracingCountersRequest(const char *path) {
+  if (PDP_UNLIKELY(snapshot_requested.load(std::memory_order_relaxed))) {
+    snapshot_requested.store(false, std::memory_order_relaxed);
+    WriteTracingCounters(path);
+  }
+}
+
+}  // namespace pdp
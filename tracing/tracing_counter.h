@@ -1,36 +1,48 @@
 #pragma once
 
-#include "core/log.h"
+#include "core/check.h"
+#include "strings/string_builder.h"
+
+#include <cstdint>
 
 namespace pdp {
 
+/// @brief Registers the counter @p name of @p group, both string literals. Registering the same
+/// pair again returns the same id, so every instance of a class shares its counters.
+uint32_t RegisterTracingCounter(const char *group, const char *name);
+
+/// @brief Adds to a counter of the calling thread. Each thread has its own cache line aligned
+/// shard of counters, so threads never contend and counting is a plain load and store.
+void IncrementTracingCounter(uint32_t id, uint64_t delta = 1);
+
+/// @brief Appends a line per counter, summed over all threads: "group/name: value/group total".
+void AppendTracingCounters(StringBuilder<> &out);
+
+/// @brief Writes AppendTracingCounters() to @p path.
+bool WriteTracingCounters(const char *path);
+
+/// @brief Asks for a snapshot at the next CheckTracingCountersRequest(). Async signal safe.
+void RequestTracingCounters();
+
+/// @brief Writes a snapshot to @p path if RequestTracingCounters() was called since the last check.
+void CheckTracingCountersRequest(const char *path);
+
+/// @brief A group of N named counters, reported on demand instead of logged.
 template <size_t N>
 struct TracingCounter {
-  TracingCounter(const char *const (&n)[N]) : names(n), counters{}, next_print(print_every) {}
+  TracingCounter(const char *group, const char *const *names) {
+    for (size_t i = 0; i < N; ++i) {
+      ids[i] = RegisterTracingCounter(group, names[i]);
+    }
+  }
 
   void Count(size_t i) {
     pdp_assert(i < N);
-    counters[i] += 1;
-    --next_print;
-
-    if (next_print <= 0) {
-      next_print = print_every;
-      size_t total = counters[0];
-      for (size_t i = 1; i < N; ++i) {
-        total += counters[i];
-      }
-      for (size_t i = 0; i < N; ++i) {
-        pdp_trace("Counter '{}': {}/{}", StringSlice(names[i]), counters[i], total);
-      }
-    }
+    IncrementTracingCounter(ids[i]);
   }
 
  private:
-  static constexpr unsigned print_every = 100;
-
-  const char *const (&names)[N];
-  unsigned counters[N];
-  unsigned next_print;
+  uint32_t ids[N];
 };
 
 }  // namespace pdp